@@ -0,0 +1,78 @@
+/*======================================================================================================================
+
+    Copyright 2011, 2012, 2013, 2014, 2015 Institut fuer Neuroinformatik, Ruhr-Universitaet Bochum, Germany
+ 
+    This file is part of cedar.
+
+    cedar is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation, either version 3 of the License, or (at your
+    option) any later version.
+
+    cedar is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with cedar. If not, see <http://www.gnu.org/licenses/>.
+
+========================================================================================================================
+
+    Institute:   Ruhr-Universitaet Bochum
+                 Institut fuer Neuroinformatik
+
+    File:        BudgetStrategy.cpp
+
+    Maintainer:  aydin demircioglu
+    Email:       aydin.demircioglu@ini.rub.de
+    Date:        2015 01 20
+
+    Description: Source file for the class cShark::BudgetStrategy.
+
+    Credits:
+
+======================================================================================================================*/
+
+// CEDAR CONFIGURATION
+#include "cedar/configuration.h"
+
+// CLASS HEADER
+#include "BudgetStrategy.h"
+
+// CEDAR INCLUDES
+
+// SYSTEM INCLUDES
+
+//----------------------------------------------------------------------------------------------------------------------
+// static members
+//----------------------------------------------------------------------------------------------------------------------
+
+cedar::aux::EnumType<cShark::BudgetStrategy> cShark::BudgetStrategy::mType("cShark::BudgetStrategy::");
+
+#ifndef CEDAR_COMPILER_MSVC
+const cShark::BudgetStrategy::Id cShark::BudgetStrategy::Remove;
+const cShark::BudgetStrategy::Id cShark::BudgetStrategy::Merge;
+const cShark::BudgetStrategy::Id cShark::BudgetStrategy::Project;
+#endif // CEDAR_COMPILER_MSVC
+
+//----------------------------------------------------------------------------------------------------------------------
+// methods
+//----------------------------------------------------------------------------------------------------------------------
+
+void cShark::BudgetStrategy::construct()
+{
+  mType.type()->def(cedar::aux::Enum(Remove, "Remove", "Remove"));
+  mType.type()->def(cedar::aux::Enum(Merge, "Merge", "Merge"));
+  mType.type()->def(cedar::aux::Enum(Project, "Project", "Project"));
+}
+
+const cedar::aux::EnumBase& cShark::BudgetStrategy::type()
+{
+  return *cShark::BudgetStrategy::mType.type();
+}
+
+const cShark::BudgetStrategy::TypePtr& cShark::BudgetStrategy::typePtr()
+{
+  return cShark::BudgetStrategy::mType.type();
+}
@@ -0,0 +1,80 @@
+/*======================================================================================================================
+
+    Copyright 2011, 2012, 2013, 2014, 2015 Institut fuer Neuroinformatik, Ruhr-Universitaet Bochum, Germany
+ 
+    This file is part of cedar.
+
+    cedar is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation, either version 3 of the License, or (at your
+    option) any later version.
+
+    cedar is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with cedar. If not, see <http://www.gnu.org/licenses/>.
+
+========================================================================================================================
+
+    Institute:   Ruhr-Universitaet Bochum
+                 Institut fuer Neuroinformatik
+
+    File:        EpochMode.cpp
+
+    Maintainer:  aydin demircioglu
+    Email:       aydin.demircioglu@ini.rub.de
+    Date:        2015 01 20
+
+    Description: Source file for the class cShark::EpochMode.
+
+    Credits:
+
+======================================================================================================================*/
+
+// CEDAR CONFIGURATION
+#include "cedar/configuration.h"
+
+// CLASS HEADER
+#include "EpochMode.h"
+
+// CEDAR INCLUDES
+
+// SYSTEM INCLUDES
+
+//----------------------------------------------------------------------------------------------------------------------
+// static members
+//----------------------------------------------------------------------------------------------------------------------
+
+cedar::aux::EnumType<cShark::EpochMode> cShark::EpochMode::mType("cShark::EpochMode::");
+
+#ifndef CEDAR_COMPILER_MSVC
+const cShark::EpochMode::Id cShark::EpochMode::Sequential;
+const cShark::EpochMode::Id cShark::EpochMode::Permutation;
+const cShark::EpochMode::Id cShark::EpochMode::Stratified;
+const cShark::EpochMode::Id cShark::EpochMode::Sharded;
+#endif // CEDAR_COMPILER_MSVC
+
+//----------------------------------------------------------------------------------------------------------------------
+// methods
+//----------------------------------------------------------------------------------------------------------------------
+
+void cShark::EpochMode::construct()
+{
+  mType.type()->def(cedar::aux::Enum(Sequential, "Sequential", "Sequential"));
+  mType.type()->def(cedar::aux::Enum(Permutation, "Permutation", "Random Permutation"));
+  mType.type()->def(cedar::aux::Enum(Stratified, "Stratified", "Stratified by Label"));
+  mType.type()->def(cedar::aux::Enum(Sharded, "Sharded", "Sharded"));
+}
+
+const cedar::aux::EnumBase& cShark::EpochMode::type()
+{
+  return *cShark::EpochMode::mType.type();
+}
+
+const cShark::EpochMode::TypePtr& cShark::EpochMode::typePtr()
+{
+  return cShark::EpochMode::mType.type();
+}
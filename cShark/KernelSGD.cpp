@@ -42,6 +42,7 @@
 
 // CEDAR INCLUDES
 #include "cedar/processing/typecheck/IsMatrix.h"
+#include "cedar/auxiliaries/stringFunctions.h"
 
 // SYSTEM INCLUDES
 
@@ -55,54 +56,325 @@ using namespace shark;
 
 
 cShark::KernelSGD::KernelSGD():
-	//TODO:mKernelType(new cedar::aux::X),
-	//TODO:mLossType(new cedar::aux::X )
 	mOffset(new cedar::aux::BoolParameter(this, "Use Offset", false)),
 	mLambda(new cedar::aux::DoubleParameter(this, "Lambda", 1.0, cedar::aux::DoubleParameter::LimitType::positive())),
 	mEpochs(new cedar::aux::IntParameter(this, "Epochs", 1, cedar::aux::IntParameter::LimitType::fromLower(1))),
-	mOutput(new CedarRealVector())
-	//	mCacheSize(new cedar::aux::IntParameter(this, "Cache Size in MB", 1, cedar::aux::IntParameter::LimitType::fromLower(1)))
-//mOutput(new cedar::aux::MatData(cv::Mat())),
+	mKernelType(new cedar::aux::EnumParameter(this, "Kernel", cShark::KernelType::typePtr(), cShark::KernelType::Rbf)),
+	mGamma(new cedar::aux::DoubleParameter(this, "Gamma", 1.0, cedar::aux::DoubleParameter::LimitType::positive())),
+	mDegree(new cedar::aux::UIntParameter(this, "Degree", 2, cedar::aux::UIntParameter::LimitType::fromLower(1))),
+	mKernelOffset(new cedar::aux::DoubleParameter(this, "Kernel Offset", 0.0)),
+	mLossType(new cedar::aux::EnumParameter(this, "Loss", cShark::LossType::typePtr(), cShark::LossType::Hinge)),
+	mWarmStart(new cedar::aux::BoolParameter(this, "Warm Start on Kernel Change", true)),
+	mNumberOfClasses(new cedar::aux::UIntParameter(this, "Number of Classes", 2, cedar::aux::UIntParameter::LimitType::fromLower(2))),
+	mBudget(new cedar::aux::UIntParameter(this, "Budget", 0)),
+	mBudgetStrategy(new cedar::aux::EnumParameter(this, "Budget Strategy", cShark::BudgetStrategy::typePtr(), cShark::BudgetStrategy::Merge)),
+	mCacheSize(new cedar::aux::IntParameter(this, "Cache Size in MB", 64, cedar::aux::IntParameter::LimitType::fromLower(0))),
+	mPublishEvery(new cedar::aux::UIntParameter(this, "Publish Model Every", 100, cedar::aux::UIntParameter::LimitType::fromLower(1))),
+	mKernelSGDTrainer(NULL),
+	mOutput(new CedarRealVector()),
+	mCacheStatistics(new CedarRealVector(RealVector(4, 0.0))),
+	mStopLearner(false),
+	mStepsPerPublication(100),
+	mUnpublishedSteps(0),
+	mWrongDimensionReported(false)
 {
 	cedar::aux::LogSingleton::getInstance()->message("Constructing Kernel SGD..", "SharkKernelSGDOnlineTrainer");
 
 	// declare all data
 	cedar::proc::DataSlotPtr input = this->declareInput("input");
+	this->declareInput("label");
+	this->declareInput("index", false);
+	this->declareInput("data generation", false);
 	this->declareOutput("output", mOutput);
+	this->declareOutput("cache statistics", mCacheStatistics);
 	
 	// do all connections
-	QObject::connect(mOffset.get(), SIGNAL(valueChanged()), this, SLOT(reinitializeKernelSGD()));
-	QObject::connect(mLambda.get(), SIGNAL(valueChanged()), this, SLOT(reinitializeKernelSGD()));
-	QObject::connect(mEpochs.get(), SIGNAL(valueChanged()), this, SLOT(reinitializeKernelSGD()));
+	QObject::connect(mOffset.get(), SIGNAL(valueChanged()), this, SLOT(updateOffset()));
+	QObject::connect(mLambda.get(), SIGNAL(valueChanged()), this, SLOT(updateLambda()));
+	QObject::connect(mEpochs.get(), SIGNAL(valueChanged()), this, SLOT(updateEpochs()));
+	QObject::connect(mNumberOfClasses.get(), SIGNAL(valueChanged()), this, SLOT(reinitializeKernelSGD()));
+	QObject::connect(mKernelType.get(), SIGNAL(valueChanged()), this, SLOT(updateKernel()));
+	QObject::connect(mGamma.get(), SIGNAL(valueChanged()), this, SLOT(updateKernel()));
+	QObject::connect(mDegree.get(), SIGNAL(valueChanged()), this, SLOT(updateKernel()));
+	QObject::connect(mKernelOffset.get(), SIGNAL(valueChanged()), this, SLOT(updateKernel()));
+	QObject::connect(mLossType.get(), SIGNAL(valueChanged()), this, SLOT(updateKernel()));
+	QObject::connect(mBudget.get(), SIGNAL(valueChanged()), this, SLOT(updateBudget()));
+	QObject::connect(mBudgetStrategy.get(), SIGNAL(valueChanged()), this, SLOT(updateBudget()));
+	QObject::connect(mCacheSize.get(), SIGNAL(valueChanged()), this, SLOT(updateCacheSize()));
+	QObject::connect(mPublishEvery.get(), SIGNAL(valueChanged()), this, SLOT(updatePublishing()));
 	
 	// TODO: parameter of source changes
 	
 	// make sure that we initialize a kernel SGD
-	
+	updatePublishing();
+	reinitializeKernelSGD();
 //	input->setCheck(cedar::proc::typecheck::IsMatrix());
+
+	mLearner = boost::thread(&cShark::KernelSGD::learn, this);
 }
 
 
 
-void cShark::KernelSGD::reinitializeKernelSGD() 
+cShark::KernelSGD::~KernelSGD()
 {
-	cedar::aux::LogSingleton::getInstance()->message("Reinitializing Kernel SGD..", "SharkKernelSGDOnlineTrainer");
-	
-	// TODO: recreate kernel, loss etc
-		
-	// remove old trainer
-	if (mKernelSGDTrainer != NULL) {
-		delete mKernelSGDTrainer;
-		mKernelSGDTrainer = NULL;
+	mStopLearner = true;
+	mLearner.join();
+
+	deleteKernelSGD();
+}
+
+
+
+void cShark::KernelSGD::PublishedModel::eval(const RealVector& x, RealVector& f) const
+{
+	if (useRbf)
+	{
+		rbf.eval(x, f);
+		return;
 	}
-	
-	// reset model with our parameters
+
+	// nothing published yet
+	if (!kernel)
+	{
+		f = RealVector();
+		return;
+	}
+
+	f = classifier.decisionFunction()(x);
+}
+
+
+
+AbstractKernelSGDOnlineTrainer<RealVector>* cShark::KernelSGD::createKernelSGD()
+{
 	double lambda = mLambda->getValue();
 	bool offset = mOffset->getValue();
-	size_t cacheSize = mCacheSize->getValue();
+	size_t cacheSize = static_cast<size_t>(mCacheSize->getValue()) * 1024 * 1024;
 	size_t epochs = mEpochs->getValue();
-	mKernelSGDTrainer = new KernelSGDOnlineTrainer<RealVector> (&mKernel, &mLoss, lambda, offset, false, cacheSize);
-	mKernelSGDTrainer	-> setEpochs (epochs);
+
+	// the kernel and loss are chosen here once, the trainer is instantiated for them
+	AbstractKernelSGDOnlineTrainer<RealVector>* trainer = AbstractKernelSGDOnlineTrainer<RealVector>::create
+	(
+		mKernelType->getValue().id(), mGamma->getValue(), mDegree->getValue(), mKernelOffset->getValue(),
+		mLossType->getValue().id(), lambda, offset, cacheSize
+	);
+	trainer	-> setEpochs (epochs);
+	trainer	-> setNumberOfClasses (mNumberOfClasses->getValue());
+	return trainer;
+}
+
+
+
+void cShark::KernelSGD::deleteKernelSGD()
+{
+	if (mKernelSGDTrainer == NULL)
+		return;
+
+	const AbstractKernelSGDOnlineTrainer<RealVector>::KernelCacheType& cache = mKernelSGDTrainer->cache();
+	cedar::aux::LogSingleton::getInstance()->debugMessage
+	(
+		"Kernel cache hit rate " + cedar::aux::toString(cache.hitRate()) + ", " + cedar::aux::toString(cache.evictions()) + " evictions.",
+		"SharkKernelSGDOnlineTrainer"
+	);
+	delete mKernelSGDTrainer;
+	mKernelSGDTrainer = NULL;
+}
+
+
+
+void cShark::KernelSGD::learn()
+{
+	Sample sample;
+	while (!mStopLearner)
+	{
+		if (!mSamples.pop(sample))
+		{
+			// the stream paused, so predictions should see everything learned so far
+			{
+				boost::mutex::scoped_lock lock(mTrainerMutex);
+				if (mUnpublishedSteps != 0)
+					publishModel();
+			}
+			boost::this_thread::sleep_for(boost::chrono::milliseconds(1));
+			continue;
+		}
+
+		boost::mutex::scoped_lock lock(mTrainerMutex);
+		try
+		{
+			mKernelSGDTrainer -> setDataGeneration (sample.dataGeneration);
+			mKernelSGDTrainer -> oneStep (sample.point, sample.label, sample.index);
+		}
+		catch (const std::exception& e)
+		{
+			// e.g. a label queued before the number of classes changed, nobody else would see the error
+			cedar::aux::LogSingleton::getInstance()->warning("Point not learned: " + std::string(e.what()), "SharkKernelSGDOnlineTrainer");
+			continue;
+		}
+
+		// if a predictor still holds the free buffer, try again after the next step
+		if (++mUnpublishedSteps >= mStepsPerPublication)
+			publishModel();
+	}
+}
+
+
+
+bool cShark::KernelSGD::publishModel()
+{
+	PublishedModel* model = mModels.back();
+	if (model == NULL)
+		return false;
+
+	model->kernel = mKernelSGDTrainer->kernel();
+	mKernelSGDTrainer->finalizeModel(model->classifier);
+
+	// Gaussian kernels have a faster copy of the model
+	model->useRbf = (dynamic_cast<const GaussianRbfKernel<RealVector>*>(model->kernel.get()) != NULL);
+	if (model->useRbf)
+		model->rbf.setModel(model->classifier.decisionFunction());
+
+	const AbstractKernelSGDOnlineTrainer<RealVector>::KernelCacheType& cache = mKernelSGDTrainer->cache();
+	model->cacheStatistics(0) = cache.hitRate();
+	model->cacheStatistics(1) = static_cast<double>(cache.hits());
+	model->cacheStatistics(2) = static_cast<double>(cache.misses());
+	model->cacheStatistics(3) = static_cast<double>(cache.evictions());
+
+	// compute() can only evaluate points of the dimension of the support vectors
+	const Data<RealVector>& basis = model->classifier.decisionFunction().basis();
+	model->inputSize = (basis.numberOfElements() == 0) ? 0 : dataDimension(basis);
+
+	mModels.publish();
+	mUnpublishedSteps = 0;
+	return true;
+}
+
+
+
+void cShark::KernelSGD::reinitializeKernelSGD() 
+{
+	cedar::aux::LogSingleton::getInstance()->message("Reinitializing Kernel SGD..", "SharkKernelSGDOnlineTrainer");
+	
+	boost::mutex::scoped_lock lock(mTrainerMutex);
+
+	// remove old trainer and start over with our parameters
+	deleteKernelSGD();
+	mKernelSGDTrainer = createKernelSGD();
+
+	applyBudget();
+	++mUnpublishedSteps;
+	publishModel();
+}
+
+
+
+void cShark::KernelSGD::updateKernel()
+{
+	if (mKernelSGDTrainer == NULL || !mWarmStart->getValue())
+	{
+		reinitializeKernelSGD();
+		return;
+	}
+
+	cedar::aux::LogSingleton::getInstance()->message("Changing kernel, keeping the support vectors..", "SharkKernelSGDOnlineTrainer");
+
+	boost::mutex::scoped_lock lock(mTrainerMutex);
+
+	// the new trainer has an empty cache and evaluates the old support vectors with its kernel
+	AbstractKernelSGDOnlineTrainer<RealVector>* trainer = createKernelSGD();
+	trainer -> continueFrom (*mKernelSGDTrainer);
+
+	deleteKernelSGD();
+	mKernelSGDTrainer = trainer;
+
+	applyBudget();
+	++mUnpublishedSteps;
+	publishModel();
+}
+
+
+
+void cShark::KernelSGD::updateLambda()
+{
+	boost::mutex::scoped_lock lock(mTrainerMutex);
+	if (mKernelSGDTrainer == NULL)
+		return;
+
+	mKernelSGDTrainer -> setLambda (mLambda->getValue());
+	++mUnpublishedSteps;
+	publishModel();
+}
+
+
+
+void cShark::KernelSGD::updateOffset()
+{
+	boost::mutex::scoped_lock lock(mTrainerMutex);
+	if (mKernelSGDTrainer == NULL)
+		return;
+
+	mKernelSGDTrainer -> setTrainOffset (mOffset->getValue());
+	++mUnpublishedSteps;
+	publishModel();
+}
+
+
+
+void cShark::KernelSGD::updateEpochs()
+{
+	boost::mutex::scoped_lock lock(mTrainerMutex);
+	if (mKernelSGDTrainer == NULL)
+		return;
+
+	mKernelSGDTrainer -> setEpochs (mEpochs->getValue());
+}
+
+
+
+void cShark::KernelSGD::updateBudget()
+{
+	boost::mutex::scoped_lock lock(mTrainerMutex);
+	if (mKernelSGDTrainer == NULL)
+		return;
+
+	applyBudget();
+	++mUnpublishedSteps;
+	publishModel();
+}
+
+
+
+void cShark::KernelSGD::applyBudget()
+{
+	// merging needs a Gaussian kernel
+	unsigned int strategy = mBudgetStrategy->getValue().id();
+	if (strategy == cShark::BudgetStrategy::Merge && mKernelType->getValue().id() != cShark::KernelType::Rbf)
+	{
+		cedar::aux::LogSingleton::getInstance()->warning("Merging needs the Gaussian RBF kernel, removing support vectors instead.", "SharkKernelSGDOnlineTrainer");
+		strategy = cShark::BudgetStrategy::Remove;
+	}
+
+	// a smaller budget shrinks the current model right away
+	mKernelSGDTrainer -> setBudget (mBudget->getValue(), strategy);
+}
+
+
+
+void cShark::KernelSGD::updatePublishing()
+{
+	boost::mutex::scoped_lock lock(mTrainerMutex);
+	mStepsPerPublication = mPublishEvery->getValue();
+}
+
+
+
+void cShark::KernelSGD::updateCacheSize()
+{
+	boost::mutex::scoped_lock lock(mTrainerMutex);
+	if (mKernelSGDTrainer == NULL)
+		return;
+
+	mKernelSGDTrainer -> setCacheSize (static_cast<size_t>(mCacheSize->getValue()) * 1024 * 1024);
 }
 
 
@@ -113,12 +385,25 @@ void cShark::KernelSGD::inputConnectionChanged(const std::string& inputName)
 
 	// Again, let's first make sure that this is really the input in case anyone ever changes our interface.
 	cedar::aux::LogSingleton::getInstance()->message("Input Connection Changed..", "SharkKernelSGDOnlineTrainer");
-	CEDAR_DEBUG_ASSERT(inputName == "input");
+	CEDAR_DEBUG_ASSERT(inputName == "input" || inputName == "label" || inputName == "index" || inputName == "data generation");
 
 	// Assign the input to the member. This saves us from casting in every computation step.
-	//	this->mInput = boost::dynamic_pointer_cast<ConstCedarRealVectorPtr>(this->getInput(inputName));
-	//	this->mInput = boost::dynamic_pointer_cast<ConstCedarRealVectorPtr>(this->getInput(inputName));
-	
+	if (inputName == "label")
+	{
+		this->mLabel = boost::dynamic_pointer_cast<const CedarLabel>(this->getInput(inputName));
+		return;
+	}
+	if (inputName == "index")
+	{
+		this->mIndex = boost::dynamic_pointer_cast<const CedarIndex>(this->getInput(inputName));
+		return;
+	}
+	if (inputName == "data generation")
+	{
+		this->mDataGeneration = boost::dynamic_pointer_cast<const CedarIndex>(this->getInput(inputName));
+		return;
+	}
+	this->mInput = boost::dynamic_pointer_cast<const CedarRealVector>(this->getInput(inputName));
 	
 	bool output_changed = false;
 	if (!this->mInput)
@@ -129,9 +414,6 @@ void cShark::KernelSGD::inputConnectionChanged(const std::string& inputName)
 	}
 	else
 	{
-		// Let's get a reference to the input matrix.
-		const CedarRealVector& input = this->mInput->getData();
-
 		// check if the input is different from the output
 		//    if (input.type() != this->mOutput->getData().type() || input.size != this->mOutput->getData().size)
 		{
@@ -154,7 +436,48 @@ void cShark::KernelSGD::inputConnectionChanged(const std::string& inputName)
 
 void cShark::KernelSGD::compute(const cedar::proc::Arguments& arguments)
 {
-	// go one step in the initialized kernelsgd object
-	RealVector v = this->mInput->getData();
-	mKernelSGDTrainer	-> oneStep (v);
+	// both the point and its label are needed for a step
+	if (!this->mInput || !this->mLabel)
+		return;
+
+	// without an index, the point is not known to the kernel cache; without the data generation
+	// a reloaded file would hit the kernel values of the old points under the same indices
+	Sample sample;
+	sample.point = this->mInput->getData();
+	sample.label = this->mLabel->getData();
+	sample.index = AbstractKernelSGDOnlineTrainer<RealVector>::NoIndex;
+	sample.dataGeneration = 0;
+	if (this->mIndex && this->mDataGeneration)
+	{
+		sample.index = this->mIndex->getData();
+		sample.dataGeneration = this->mDataGeneration->getData();
+	}
+
+	// hand the point to the learner, if it is too far behind the point is dropped
+	mSamples.push(sample);
+
+	// the output is the prediction of the model published last, learning goes on meanwhile
+	shark::ModelPublisher<PublishedModel>::Reader model(mModels);
+	if (model->inputSize != 0 && sample.point.size() != model->inputSize)
+	{
+		// e.g. the input was connected to another data file; throwing here would stop the
+		// architecture, so there is no prediction, and one warning until the inputs fit again
+		if (!mWrongDimensionReported)
+		{
+			cedar::aux::LogSingleton::getInstance()->warning
+			(
+				"Input has dimension " + cedar::aux::toString(sample.point.size()) + ", the model expects "
+					+ cedar::aux::toString(model->inputSize) + ", no prediction.",
+				"cShark::KernelSGD::compute()"
+			);
+			mWrongDimensionReported = true;
+		}
+		this->mOutput->getData() = RealVector();
+	}
+	else
+	{
+		mWrongDimensionReported = false;
+		model->eval(sample.point, this->mOutput->getData());
+	}
+	this->mCacheStatistics->setData(model->cacheStatistics);
 }
@@ -47,27 +47,37 @@
 #include <cedar/auxiliaries/FileParameter.h>
 #include <cedar/auxiliaries/DoubleParameter.h>
 #include <cedar/auxiliaries/IntParameter.h>
+#include <cedar/auxiliaries/UIntParameter.h>
+#include <cedar/auxiliaries/EnumParameter.h>
 #include <cedar/auxiliaries/MatData.h>
 
 // CSHARK
 #include "cShark.h"
+#include "BudgetStrategy.h"
+#include "KernelType.h"
+#include "LossType.h"
 
 // SHARK THINGS
-#include "SharkSVM/SharkKernelSGDOnlineTrainer.h"
-#include <shark/ObjectiveFunctions/Loss/HingeLoss.h>
-#include <shark/Models/Kernels/GaussianRbfKernel.h> //the used kernel for the SVM
+#include "SharkSVM/AbstractKernelSGDOnlineTrainer.h"
+#include "SharkSVM/GaussianRbfExpansion.h"
+#include "SharkSVM/ModelPublisher.h"
 
 // FORWARD DECLARATIONS
 #include "KernelSGD.fwd.h"
 
 // SYSTEM INCLUDES
+#include <boost/atomic.hpp>
+#include <boost/lockfree/spsc_queue.hpp>
+#include <boost/thread.hpp>
 
 
 using namespace shark;
 
-/*!@todo describe.
+/*!@brief Online kernel SGD on a stream of labeled points.
  *
- * @todo describe more.
+ * The points are learned on a thread of their own. compute() only queues the point and predicts it with the model
+ * published last; the learner publishes a copy of its model every few steps, so predicting never waits for learning
+ * and learning never waits for predicting. Points arriving while the queue is full are not learned.
  */
 class cShark::KernelSGD : public cedar::proc::Step
 {
@@ -76,6 +86,46 @@ class cShark::KernelSGD : public cedar::proc::Step
   //--------------------------------------------------------------------------------------------------------------------
   // nested types
   //--------------------------------------------------------------------------------------------------------------------
+public:
+	//!@brief A copy of the model of the learner, read by compute() while the learner goes on.
+	struct PublishedModel
+	{
+		//!@brief Decision values of the model, empty before the first publication.
+		void eval(const RealVector& x, RealVector& f) const;
+
+		//!@brief The model, it refers to the kernel below.
+		shark::KernelClassifier<RealVector> classifier;
+
+		//!@brief Faster copy of the model for a Gaussian kernel.
+		shark::GaussianRbfExpansion rbf;
+
+		//!@brief Whether rbf holds the model.
+		bool useRbf;
+
+		//!@brief The kernel of the trainer that wrote the model, kept alive with the model.
+		boost::shared_ptr<shark::AbstractKernelFunction<RealVector> > kernel;
+
+		//!@brief Hit rate, hits, misses and evictions of the kernel cache at the time of the copy.
+		RealVector cacheStatistics;
+
+		//!@brief Dimension of the support vectors, 0 while there are none and any point can be evaluated.
+		std::size_t inputSize;
+
+		PublishedModel() : useRbf(false), cacheStatistics(4, 0.0), inputSize(0) {}
+	};
+
+private:
+	//!@brief A point waiting to be learned.
+	struct Sample
+	{
+		RealVector point;
+		unsigned int label;
+		std::size_t index;
+		std::size_t dataGeneration;
+	};
+
+	//!@brief Number of points that can wait for the learner.
+	static const std::size_t QueueSize = 1024;
 
   //--------------------------------------------------------------------------------------------------------------------
   // constructors and destructor
@@ -84,6 +134,9 @@ public:
   //!@brief The standard constructor.
   KernelSGD();
 
+  //!@brief Stops the learner.
+  ~KernelSGD();
+
   //--------------------------------------------------------------------------------------------------------------------
   // public methods
   //--------------------------------------------------------------------------------------------------------------------
@@ -103,8 +156,46 @@ private:
 	
 	void compute(const cedar::proc::Arguments& arguments);
 
+	//!@brief Creates a trainer with the current parameters, it has no model yet.
+	shark::AbstractKernelSGDOnlineTrainer<RealVector>* createKernelSGD();
+
+	//!@brief Deletes the current trainer.
+	void deleteKernelSGD();
+
+	//!@brief Learns the queued points, runs on the learner thread.
+	void learn();
+
+	//!@brief Hands budget and strategy to the trainer, the trainer mutex must be held.
+	void applyBudget();
+
+	//!@brief Copies the model of the trainer into the free buffer and publishes it, the trainer mutex must be held.
+	//!@return false if a reader still holds the free buffer, the model should be published later.
+	bool publishModel();
+
 public slots: 
+	//!@brief Starts over with a new trainer, everything learned so far is lost.
 	void reinitializeKernelSGD();
+
+	//!@brief Switches to a new kernel or loss, the support vectors are kept if warm start is on.
+	void updateKernel();
+
+	//!@brief Hands lambda to the trainer, the model is kept and rescaled.
+	void updateLambda();
+
+	//!@brief Switches the offset on or off, the rest of the model is kept.
+	void updateOffset();
+
+	//!@brief Hands the number of epochs to the trainer, the model is kept.
+	void updateEpochs();
+
+	//!@brief Hands the publication cadence to the learner.
+	void updatePublishing();
+
+	//!@brief Hands budget and strategy to the trainer, the model is kept.
+	void updateBudget();
+
+	//!@brief Resizes the kernel cache of the trainer, the model is kept.
+	void updateCacheSize();
 	
 	
 
@@ -112,11 +203,47 @@ protected:
   // none yet
 private:
 	//!@brief MatrixData representing the input. Storing it like this saves time during computation.
-	CedarRealVectorPtr mInput;
+	ConstCedarRealVectorPtr mInput;
+
+	//!@brief The label of the input point.
+	ConstCedarLabelPtr mLabel;
+
+	//!@brief Index of the input point in its data, optional, kernel values are only cached if it and the data generation are given.
+	ConstCedarIndexPtr mIndex;
+
+	//!@brief Generation of the data the index refers to, the kernel cache is cleared when it changes.
+	ConstCedarIndexPtr mDataGeneration;
 
 	//!@brief The output data.
 	CedarRealVectorPtr mOutput;
 
+	//!@brief Hit rate, hits, misses and evictions of the kernel cache.
+	CedarRealVectorPtr mCacheStatistics;
+
+	//!@brief Points from compute() to the learner.
+	boost::lockfree::spsc_queue<Sample, boost::lockfree::capacity<QueueSize> > mSamples;
+
+	//!@brief Models from the learner to compute().
+	shark::ModelPublisher<PublishedModel> mModels;
+
+	//!@brief Thread learning the queued points.
+	boost::thread mLearner;
+
+	//!@brief Tells the learner to stop.
+	boost::atomic<bool> mStopLearner;
+
+	//!@brief Guards the trainer, held by the learner during a step and by the parameter slots.
+	boost::mutex mTrainerMutex;
+
+	//!@brief Number of steps between two publications, guarded by the trainer mutex.
+	std::size_t mStepsPerPublication;
+
+	//!@brief Number of steps since the last publication, guarded by the trainer mutex.
+	std::size_t mUnpublishedSteps;
+
+	//!@brief Whether compute() already warned about inputs that do not fit the model, reset once they fit again.
+	bool mWrongDimensionReported;
+
   //--------------------------------------------------------------------------------------------------------------------
   // parameters
   //--------------------------------------------------------------------------------------------------------------------
@@ -133,18 +260,42 @@ private:
 
 	//!@brief number of epochs
 	cedar::aux::IntParameterPtr mEpochs;
+
+	//!@brief kernel function
+	cedar::aux::EnumParameterPtr mKernelType;
+
+	//!@brief bandwidth of the Gaussian RBF kernel
+	cedar::aux::DoubleParameterPtr mGamma;
+
+	//!@brief degree of the polynomial kernel
+	cedar::aux::UIntParameterPtr mDegree;
+
+	//!@brief offset of the polynomial kernel
+	cedar::aux::DoubleParameterPtr mKernelOffset;
+
+	//!@brief loss function
+	cedar::aux::EnumParameterPtr mLossType;
+
+	//!@brief whether a new kernel or loss continues from the current support vectors
+	cedar::aux::BoolParameterPtr mWarmStart;
+
+	//!@brief number of classes of the labels, the output has one decision value per class for more than two
+	cedar::aux::UIntParameterPtr mNumberOfClasses;
 	
-	//!@brief cache size
+	//!@brief maximal number of support vectors, 0 for unlimited
+	cedar::aux::UIntParameterPtr mBudget;
+
+	//!@brief how the support vectors are kept within the budget
+	cedar::aux::EnumParameterPtr mBudgetStrategy;
+
+	//!@brief cache size in MB
 	cedar::aux::IntParameterPtr mCacheSize;
 
-	//!@brief current trainer we work on
-	shark::KernelSGDOnlineTrainer<RealVector> *mKernelSGDTrainer;
+	//!@brief number of steps after which the learner publishes its model
+	cedar::aux::UIntParameterPtr mPublishEvery;
 
-	//!@brief kernel to use FIXME should be abstract blabla
-	GaussianRbfKernel<> mKernel;
-	
-	//!@brief loss function FIXME should be abstract blabla
-	HingeLoss mLoss;
+	//!@brief current trainer we work on, instantiated for the chosen kernel and loss, it owns both
+	shark::AbstractKernelSGDOnlineTrainer<RealVector> *mKernelSGDTrainer;
 	
 }; // class cShark::KernelSGD
 
@@ -0,0 +1,78 @@
+/*======================================================================================================================
+
+    Copyright 2011, 2012, 2013, 2014, 2015 Institut fuer Neuroinformatik, Ruhr-Universitaet Bochum, Germany
+ 
+    This file is part of cedar.
+
+    cedar is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation, either version 3 of the License, or (at your
+    option) any later version.
+
+    cedar is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with cedar. If not, see <http://www.gnu.org/licenses/>.
+
+========================================================================================================================
+
+    Institute:   Ruhr-Universitaet Bochum
+                 Institut fuer Neuroinformatik
+
+    File:        KernelType.cpp
+
+    Maintainer:  aydin demircioglu
+    Email:       aydin.demircioglu@ini.rub.de
+    Date:        2015 01 20
+
+    Description: Source file for the class cShark::KernelType.
+
+    Credits:
+
+======================================================================================================================*/
+
+// CEDAR CONFIGURATION
+#include "cedar/configuration.h"
+
+// CLASS HEADER
+#include "KernelType.h"
+
+// CEDAR INCLUDES
+
+// SYSTEM INCLUDES
+
+//----------------------------------------------------------------------------------------------------------------------
+// static members
+//----------------------------------------------------------------------------------------------------------------------
+
+cedar::aux::EnumType<cShark::KernelType> cShark::KernelType::mType("cShark::KernelType::");
+
+#ifndef CEDAR_COMPILER_MSVC
+const cShark::KernelType::Id cShark::KernelType::Linear;
+const cShark::KernelType::Id cShark::KernelType::Polynomial;
+const cShark::KernelType::Id cShark::KernelType::Rbf;
+#endif // CEDAR_COMPILER_MSVC
+
+//----------------------------------------------------------------------------------------------------------------------
+// methods
+//----------------------------------------------------------------------------------------------------------------------
+
+void cShark::KernelType::construct()
+{
+  mType.type()->def(cedar::aux::Enum(Linear, "Linear", "Linear"));
+  mType.type()->def(cedar::aux::Enum(Polynomial, "Polynomial", "Polynomial"));
+  mType.type()->def(cedar::aux::Enum(Rbf, "Rbf", "Gaussian RBF"));
+}
+
+const cedar::aux::EnumBase& cShark::KernelType::type()
+{
+  return *cShark::KernelType::mType.type();
+}
+
+const cShark::KernelType::TypePtr& cShark::KernelType::typePtr()
+{
+  return cShark::KernelType::mType.type();
+}
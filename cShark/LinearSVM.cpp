@@ -44,10 +44,295 @@
 #include "cedar/processing/typecheck/IsMatrix.h"
 
 // SYSTEM INCLUDES
+#include <cmath>
 
 using namespace shark;
 
 
+//----------------------------------------------------------------------------------------------------------------------
+// training thread
+//----------------------------------------------------------------------------------------------------------------------
+
+
+
+LinearSVMThread::LinearSVMThread():
+	mRequested(0),
+	mTrainings(0),
+	mQuit(false),
+	mCancel(false)
+{
+}
+
+
+
+LinearSVMThread::~LinearSVMThread()
+{
+	{
+		boost::mutex::scoped_lock lock(mMutex);
+		mQuit = true;
+		mCancel = true;
+	}
+	mTrainingRequested.notify_all();
+	wait();
+}
+
+
+
+unsigned int LinearSVMThread::startTraining(const SharkSVMData& data, const Parameters& parameters)
+{
+	return request(data, SharkSparseSVMData(), parameters);
+}
+
+
+
+unsigned int LinearSVMThread::startTraining(const SharkSparseSVMData& data, const Parameters& parameters)
+{
+	return request(SharkSVMData(), data, parameters);
+}
+
+
+
+unsigned int LinearSVMThread::request(const SharkSVMData& data, const SharkSparseSVMData& sparseData, const Parameters& parameters)
+{
+	unsigned int training;
+	{
+		boost::mutex::scoped_lock lock(mMutex);
+
+		// a waiting request that starts over must not be skipped by a warm start, that would continue on other data
+		bool warmStart = parameters.warmStart && ((mRequested == 0) || mRequestedParameters.warmStart);
+
+		training = ++mTrainings;
+		mRequested = training;
+		mRequestedData = data;
+		mRequestedSparseData = sparseData;
+		mRequestedParameters = parameters;
+		mRequestedParameters.warmStart = warmStart;
+		mCancel = true;
+	}
+	mTrainingRequested.notify_all();
+	return training;
+}
+
+
+
+void LinearSVMThread::cancel()
+{
+	boost::mutex::scoped_lock lock(mMutex);
+	mRequested = 0;
+	mCancel = true;
+}
+
+
+
+bool LinearSVMThread::cancelled() const
+{
+	return mCancel;
+}
+
+
+
+bool LinearSVMThread::predict(unsigned int training, const RealVector& x, RealVector& decision, RealVector& path, RealVector& lambdas, std::size_t& inputSize) const
+{
+	shark::ModelPublisher<Result>::Reader result(mResults);
+	if (result->training != training)
+		return false;
+
+	// the kernel model only takes points of its dimension, the linear one ignores features it has not seen
+	inputSize = 0;
+	if (!result->linear && (result->predictor.numberOfSupportVectors() != 0))
+		inputSize = result->predictor.inputSize();
+	if ((inputSize != 0) && (x.size() != inputSize))
+	{
+		decision = RealVector();
+		path = RealVector();
+		lambdas = RealVector();
+		return true;
+	}
+
+	if (!result->linear)
+		result->predictor.eval(x, decision);
+	else
+		decision = RealVector(1, linearDecision(result->weights, result->offset, x));
+
+	path.resize(result->pathWeights.size());
+	for (std::size_t k = 0; k < result->pathWeights.size(); ++k)
+		path(k) = linearDecision(result->pathWeights[k], result->pathOffsets[k], x);
+	lambdas = result->pathLambdas;
+	return true;
+}
+
+
+
+double LinearSVMThread::linearDecision(const RealVector& w, double b, const RealVector& x)
+{
+	double f = b;
+	for (std::size_t i = 0; i < std::min(w.size(), x.size()); ++i)
+		f += w(i) * x(i);
+	return f;
+}
+
+
+
+void LinearSVMThread::run()
+{
+	for (;;)
+	{
+		unsigned int training;
+		SharkSVMData data;
+		SharkSparseSVMData sparseData;
+		Parameters parameters;
+		{
+			boost::mutex::scoped_lock lock(mMutex);
+			while ((mRequested == 0) && (mQuit == false))
+				mTrainingRequested.wait(lock);
+
+			if (mQuit == true)
+				return;
+
+			// a request arriving from now on cancels this training again
+			training = mRequested;
+			data = mRequestedData;
+			sparseData = mRequestedSparseData;
+			parameters = mRequestedParameters;
+			mRequested = 0;
+			mRequestedData = SharkSVMData();
+			mRequestedSparseData = SharkSparseSVMData();
+			mCancel = false;
+		}
+
+		train(training, data, sparseData, parameters);
+	}
+}
+
+
+
+void LinearSVMThread::train(unsigned int training, const SharkSVMData& data, const SharkSparseSVMData& sparseData, const Parameters& parameters)
+{
+	GaussianRbfExpansion predictor;
+	RealVector weights;
+	double offset = 0.0;
+	std::vector<RealVector> pathWeights;
+	std::vector<double> pathOffsets;
+	RealVector pathLambdas;
+	bool linear = (parameters.solver == cShark::SolverType::Liblinear);
+	try
+	{
+		bool sparse = (sparseData.numberOfElements() != 0);
+		std::size_t ell = sparse ? sparseData.numberOfElements() : data.numberOfElements();
+
+		if (linear)
+		{
+			// the path descends to the given lambda, every model is the start of the next
+			std::size_t length = std::max<std::size_t>(parameters.pathLength, 1);
+			pathLambdas.resize(length);
+			for (std::size_t k = 0; k != length; ++k)
+				pathLambdas(k) = parameters.lambda * std::pow(parameters.pathFactor, static_cast<double>(length - 1 - k));
+
+			// a warm start continues from the solver of the last training, only if that had exactly this data;
+			// the dataset may have been reloaded since, e.g. with as many points as before
+			bool warm = parameters.warmStart && mLinearSolver
+				&& (sparse ? mLinearSolver->hasData(sparseData) : mLinearSolver->hasData(data));
+			if (parameters.warmStart && !warm)
+			{
+				cedar::aux::LogSingleton::getInstance()->debugMessage
+				(
+					"The data differs from that of the last training, training from scratch.",
+					"SharkLinearSVMOnlineTrainer"
+				);
+			}
+			if (!warm)
+				mLinearSolver.reset(new LinearDcdSolver(1.0 / (pathLambdas(0) * ell), parameters.loss, parameters.offset));
+
+			LinearDcdSolver& solver = *mLinearSolver;
+			solver.setMaxEpochs(parameters.epochs);
+			solver.setNumberOfThreads(parameters.threads);
+			solver.setDeterministic(parameters.deterministic);
+
+			std::size_t epochs = 0;
+			for (std::size_t k = 0; k != length; ++k)
+			{
+				// the solver checks the flag in every epoch
+				bool trained;
+				if ((k == 0) && !warm)
+				{
+					trained = sparse ? solver.train(sparseData, weights, offset, &mCancel) : solver.train(data, weights, offset, &mCancel);
+				}
+				else
+				{
+					solver.setC(1.0 / (pathLambdas(k) * ell));
+					trained = solver.warmStart(weights, offset, &mCancel);
+				}
+				if (!trained)
+					return;
+
+				epochs += solver.iterations();
+				pathWeights.push_back(weights);
+				pathOffsets.push_back(offset);
+			}
+
+			cedar::aux::LogSingleton::getInstance()->debugMessage
+			(
+				"Dual coordinate descent finished after " + cedar::aux::toString(epochs) + " epochs"
+				+ (warm ? " from the last model." : "."),
+				"SharkLinearSVMOnlineTrainer"
+			);
+		}
+		else
+		{
+			// the linear solver would no longer know the data
+			mLinearSolver.reset();
+
+			if (sparse)
+				throw SHARKSVMEXCEPTION("The kernel solver needs dense data, turn sparse output of the data off.");
+
+			SmoSolver solver(parameters.gamma, 1.0 / (parameters.lambda * ell), parameters.offset, parameters.cacheSize);
+			solver.setMaxSweeps(parameters.epochs);
+
+			// the solver checks the flag in every step
+			if (!solver.train(data, predictor, &mCancel))
+				return;
+
+			cedar::aux::LogSingleton::getInstance()->debugMessage
+			(
+				"SMO finished after " + cedar::aux::toString(solver.iterations()) + " steps, "
+				+ cedar::aux::toString(solver.cacheMisses()) + " kernel rows computed, "
+				+ cedar::aux::toString(solver.cacheHits()) + " taken from the cache.",
+				"SharkLinearSVMOnlineTrainer"
+			);
+		}
+	}
+	catch (const std::exception& e)
+	{
+		// a solver that failed on its data is no start for the next training
+		mLinearSolver.reset();
+
+		// nobody else would see the error on this thread
+		cedar::aux::LogSingleton::getInstance()->warning("Training failed: " + std::string(e.what()), "SharkLinearSVMOnlineTrainer");
+		return;
+	}
+
+	// a reader pins the free slot at most for one prediction
+	Result* result;
+	while ((result = mResults.back()) == NULL)
+	{
+		if (cancelled())
+			return;
+		yieldCurrentThread();
+	}
+
+	result->predictor = predictor;
+	result->weights = weights;
+	result->offset = offset;
+	result->linear = linear;
+	result->pathWeights = pathWeights;
+	result->pathOffsets = pathOffsets;
+	result->pathLambdas = pathLambdas;
+	result->training = training;
+	mResults.publish();
+}
+
+
+
 //----------------------------------------------------------------------------------------------------------------------
 // constructors and destructor
 //----------------------------------------------------------------------------------------------------------------------
@@ -55,160 +340,173 @@ using namespace shark;
 
 
 cShark::LinearSVM::LinearSVM():
-	//TODO:mKernelType(new cedar::aux::X),
-	//TODO:mLossType(new cedar::aux::X )
 	mOutput(new CedarRealVector()),
+	mPathOutput(new CedarRealVector()),
+	mPathLambdas(new CedarRealVector()),
+	mTraining(0),
+	mWrongDimensionReported(false),
+	mSolverType(new cedar::aux::EnumParameter(this, "Solver", cShark::SolverType::typePtr(), cShark::SolverType::Liblinear)),
+	mLossType(new cedar::aux::EnumParameter(this, "Loss", cShark::LossType::typePtr(), cShark::LossType::Hinge)),
 	mOffset(new cedar::aux::BoolParameter(this, "Use Offset", false)),
 	mLambda(new cedar::aux::DoubleParameter(this, "Lambda", 1.0, cedar::aux::DoubleParameter::LimitType::positive())),
-	mEpochs(new cedar::aux::IntParameter(this, "Epochs", 1, cedar::aux::IntParameter::LimitType::fromLower(1)))
-	//	mCacheSize(new cedar::aux::IntParameter(this, "Cache Size in MB", 1, cedar::aux::IntParameter::LimitType::fromLower(1)))
+	mEpochs(new cedar::aux::IntParameter(this, "Epochs", 0, cedar::aux::IntParameter::LimitType::fromLower(0))),
+	mGamma(new cedar::aux::DoubleParameter(this, "Gamma", 0.5, cedar::aux::DoubleParameter::LimitType::positive())),
+	mCacheSize(new cedar::aux::IntParameter(this, "Cache Size in MB", 64, cedar::aux::IntParameter::LimitType::fromLower(0))),
+	mNumberOfThreads(new cedar::aux::UIntParameter(this, "Number of Threads", 1)),
+	mDeterministic(new cedar::aux::BoolParameter(this, "Deterministic", false)),
+	mWarmStart(new cedar::aux::BoolParameter(this, "Warm Start on Lambda Change", true)),
+	mPathLength(new cedar::aux::UIntParameter(this, "Path Length", 1, cedar::aux::UIntParameter::LimitType::fromLower(1))),
+	// lambda has to shrink along the path, so the factor must be larger than one
+	mPathFactor(new cedar::aux::DoubleParameter(this, "Path Factor", 2.0, cedar::aux::DoubleParameter::LimitType::fromLower(1.01))),
 //mOutput(new cedar::aux::MatData(cv::Mat())),
+	mLinearSVMThread(new LinearSVMThread())
 {
 	cedar::aux::LogSingleton::getInstance()->message("Constructing Linear SVM..", "LinearSVM");
 
 	// declare all data
-	cedar::proc::DataSlotPtr input = this->declareInput("input");
+	this->declareInput("dataset");
+	this->declareInput("input", false);
 	this->declareOutput("output", mOutput);
+	this->declareOutput("path output", mPathOutput);
+	this->declareOutput("path lambdas", mPathLambdas);
 	
 	// do all connections
+	QObject::connect(mSolverType.get(), SIGNAL(valueChanged()), this, SLOT(reinitializeLinearSVM()));
+	QObject::connect(mLossType.get(), SIGNAL(valueChanged()), this, SLOT(reinitializeLinearSVM()));
 	QObject::connect(mOffset.get(), SIGNAL(valueChanged()), this, SLOT(reinitializeLinearSVM()));
-	QObject::connect(mLambda.get(), SIGNAL(valueChanged()), this, SLOT(reinitializeLinearSVM()));
+	QObject::connect(mLambda.get(), SIGNAL(valueChanged()), this, SLOT(updateLambda()));
 	QObject::connect(mEpochs.get(), SIGNAL(valueChanged()), this, SLOT(reinitializeLinearSVM()));
+	QObject::connect(mGamma.get(), SIGNAL(valueChanged()), this, SLOT(reinitializeLinearSVM()));
+	QObject::connect(mCacheSize.get(), SIGNAL(valueChanged()), this, SLOT(reinitializeLinearSVM()));
+	QObject::connect(mNumberOfThreads.get(), SIGNAL(valueChanged()), this, SLOT(reinitializeLinearSVM()));
+	QObject::connect(mDeterministic.get(), SIGNAL(valueChanged()), this, SLOT(reinitializeLinearSVM()));
+	QObject::connect(mPathLength.get(), SIGNAL(valueChanged()), this, SLOT(updateLambda()));
+	QObject::connect(mPathFactor.get(), SIGNAL(valueChanged()), this, SLOT(updateLambda()));
 	
 	// TODO: parameter of source changes
 	
-	// make sure that we initialize a kernel SGD
+	// the thread waits for its first training
+	mLinearSVMThread->start();
 	
 //	input->setCheck(cedar::proc::typecheck::IsMatrix());
 }
 
 
 
-void cShark::LinearSVM::reinitializeLinearSVM() 
+cShark::LinearSVM::~LinearSVM()
 {
-	cedar::aux::LogSingleton::getInstance()->message("Reinitializing Kernel SGD..", "SharkLinearSVMOnlineTrainer");
-	
-	// TODO: recreate kernel, loss etc
+	delete mLinearSVMThread;
+}
 
-	// check if there is no thread running etc
-	
-	// remove old trainer
-	if (mLinearSVMThread != NULL) {
-		// TODO: kill that thing!
-		delete mLinearSVMThread;
-		mLinearSVMThread = NULL;
-	}
-	
-	// reset model with our parameters
-	double lambda = mLambda->getValue();
-	bool offset = mOffset->getValue();
-	size_t cacheSize = mCacheSize->getValue();
-	size_t epochs = mEpochs->getValue();
-	mLinearSVMThread = new LinearSVMThread();
-	
-	// reset flags
-	isDeadNow = false;
-	isStarted = false;
-	isFinished = false;
+
+
+void cShark::LinearSVM::reinitializeLinearSVM() 
+{
+	cedar::aux::LogSingleton::getInstance()->message("Reinitializing Linear SVM..", "SharkLinearSVMOnlineTrainer");
+	startTraining(false);
 }
 
 
 
-void cShark::LinearSVM::inputConnectionChanged(const std::string& inputName)
+void cShark::LinearSVM::updateLambda()
 {
-	// TODO: you may want to replace this code by using a cedar::proc::InputSlotHelper
+	// the kernel solver always starts over
+	bool warmStart = mWarmStart->getValue() && (mSolverType->getValue().id() == cShark::SolverType::Liblinear);
+	startTraining(warmStart);
+}
 
-	// Again, let's first make sure that this is really the input in case anyone ever changes our interface.
-	cedar::aux::LogSingleton::getInstance()->message("Input Connection Changed..", "SharkLinearSVMOnlineTrainer");
-	CEDAR_DEBUG_ASSERT(inputName == "input");
 
-	// Assign the input to the member. This saves us from casting in every computation step.
-	//	this->mInput = boost::dynamic_pointer_cast<ConstCedarRealVectorPtr>(this->getInput(inputName));
-	//	this->mInput = boost::dynamic_pointer_cast<ConstCedarRealVectorPtr>(this->getInput(inputName));
-	
-	
-	bool output_changed = false;
-	if (!this->mInput)
+
+void cShark::LinearSVM::startTraining(bool warmStart)
+{
+	// without data there is nothing to train, the model of an earlier dataset is dropped
+	if (!this->mDataset && !this->mSparseDataset)
 	{
-		// no input -> no output
-		//    this->mOutput->setData(cv::Mat());
-		output_changed = true;
+		mLinearSVMThread->cancel();
+		mTraining = 0;
+		return;
 	}
+
+	LinearSVMThread::Parameters parameters;
+	parameters.solver = mSolverType->getValue().id();
+	parameters.loss = mLossType->getValue().id();
+	parameters.gamma = mGamma->getValue();
+	parameters.lambda = mLambda->getValue();
+	parameters.offset = mOffset->getValue();
+	parameters.epochs = static_cast<std::size_t>(mEpochs->getValue());
+	parameters.cacheSize = static_cast<std::size_t>(mCacheSize->getValue()) * 1024 * 1024;
+	parameters.threads = mNumberOfThreads->getValue();
+	parameters.deterministic = mDeterministic->getValue();
+	parameters.warmStart = warmStart;
+	parameters.pathLength = mPathLength->getValue();
+	parameters.pathFactor = mPathFactor->getValue();
+
+	// the running training is cancelled, the output is empty until the new model is there
+	if (this->mDataset)
+		mTraining = mLinearSVMThread->startTraining(this->mDataset->getData(), parameters);
 	else
-	{
-		// Let's get a reference to the input matrix.
-		const CedarRealVector& input = this->mInput->getData();
+		mTraining = mLinearSVMThread->startTraining(this->mSparseDataset->getData(), parameters);
+}
 
-		// check if the input is different from the output
-		//    if (input.type() != this->mOutput->getData().type() || input.size != this->mOutput->getData().size)
-		{
-			output_changed = true;
-		}
 
-		// Make a copy to create a matrix of the same type, dimensions, ...
-		//this->mOutput->setData(input.clone());
 
-		//this->mOutput->copyAnnotationsFrom(this->mInput);
-	}
+void cShark::LinearSVM::inputConnectionChanged(const std::string& inputName)
+{
+	// Again, let's first make sure that this is really the input in case anyone ever changes our interface.
+	cedar::aux::LogSingleton::getInstance()->message("Input Connection Changed..", "SharkLinearSVMOnlineTrainer");
+	CEDAR_DEBUG_ASSERT(inputName == "input" || inputName == "dataset");
 
-	if (output_changed)
+	// Assign the input to the member. This saves us from casting in every computation step.
+	if (inputName == "input")
 	{
-		this->emitOutputPropertiesChangedSignal("output");
+		this->mInput = boost::dynamic_pointer_cast<const CedarRealVector>(this->getInput(inputName));
+		return;
 	}
+
+	// a new dataset is trained right away, dense or sparse
+	this->mDataset = boost::dynamic_pointer_cast<const CedarSVMData>(this->getInput(inputName));
+	this->mSparseDataset = boost::dynamic_pointer_cast<const CedarSparseSVMData>(this->getInput(inputName));
+	reinitializeLinearSVM();
+	this->emitOutputPropertiesChangedSignal("output");
 }
 
 
 
 void cShark::LinearSVM::compute(const cedar::proc::Arguments& arguments)
 {
-	// overwrite output already 
-	RealVector notFinishedVec (1, -1);
-	CedarRealVector deadPixel (notFinishedVec );
-	this->mOutput = CedarRealVectorPtr (&deadPixel );
-
-	// check, if we already finished all our steps
-	if (isDeadNow == true) {
-		// oh yes, so we do not do anything anymore until
-		// we get a new input connection or some parameter changed etc
-		return;
+	// post the decision values of the trained model to the next worker, nothing while it is not ready
+	RealVector decision;
+	RealVector path;
+	RealVector lambdas;
+	std::size_t inputSize = 0;
+	unsigned int training = mTraining.load();
+	if (!this->mInput || (training == 0) || !mLinearSVMThread->predict(training, this->mInput->getData(), decision, path, lambdas, inputSize))
+	{
+		decision = RealVector();
+		path = RealVector();
+		lambdas = RealVector();
 	}
-		
-	// check first, if our trainer thread is started or not
-	if (isStarted == true) {
-		// check if we are finished
-		
-		if (isFinished == true) {
-			// get data
-			KernelClassifier<RealVector> *linearSVMModel = mLinearSVMThread -> getModel ();
-			
-			// kill the thread now
-//			mLinearSVMThread -> m_abort = true;
-			if (!mLinearSVMThread -> wait(100)) {
-				// why that thread!...
-				// LOG ERROR
-				mLinearSVMThread -> quit();
-				mLinearSVMThread -> terminate();
-				return;
-			}
-			
-			// post the data to the next worker
-//			this -> mOutput (Model);
-
-			// signal that our processing stopped, and we need to be restarted again
-			isDeadNow = true;
-		}
-		else {
-			// we have to wait, so we return nothing
-			return;
+	else if ((inputSize != 0) && (this->mInput->getData().size() != inputSize))
+	{
+		// e.g. the input was connected to another data file; throwing here would stop the
+		// architecture, so there is no prediction, and one warning until the inputs fit again
+		if (!mWrongDimensionReported)
+		{
+			cedar::aux::LogSingleton::getInstance()->warning
+			(
+				"Input has dimension " + cedar::aux::toString(this->mInput->getData().size()) + ", the model expects "
+					+ cedar::aux::toString(inputSize) + ", no prediction.",
+				"cShark::LinearSVM::compute()"
+			);
+			mWrongDimensionReported = true;
 		}
 	}
-	else {
-		// well, we should start now.
-		mLinearSVMThread = new LinearSVMThread();
-		mLinearSVMThread->run();
-		isStarted = true;
+	else
+	{
+		mWrongDimensionReported = false;
 	}
-}
-
-
 
+	this->mOutput->setData (decision);
+	this->mPathOutput->setData (path);
+	this->mPathLambdas->setData (lambdas);
+}
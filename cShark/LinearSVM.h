@@ -47,20 +47,25 @@
 #include <cedar/auxiliaries/FileParameter.h>
 #include <cedar/auxiliaries/DoubleParameter.h>
 #include <cedar/auxiliaries/IntParameter.h>
+#include <cedar/auxiliaries/UIntParameter.h>
+#include <cedar/auxiliaries/EnumParameter.h>
 #include <cedar/auxiliaries/MatData.h>
 
 // CSHARK
 #include "cShark.h"
+#include "LossType.h"
+#include "SolverType.h"
 
 // SHARK THINGS
-#include <shark/ObjectiveFunctions/Loss/HingeLoss.h>
-#include <shark/Algorithms/Trainers/CSvmTrainer.h> // the C-SVM trainer
-#include <shark/Models/Kernels/GaussianRbfKernel.h> //the used kernel for the SVM
-#include <shark/ObjectiveFunctions/Loss/ZeroOneLoss.h> //used for evaluation of the classifier
-#include <shark/Data/DataDistribution.h> //includes small toy distributions
+#include "SharkSVM/GaussianRbfExpansion.h"
+#include "SharkSVM/LinearDcdSolver.h"
+#include "SharkSVM/ModelPublisher.h"
+#include "SharkSVM/SmoSolver.h"
 
-using namespace shark;
-using namespace std;
+#include <boost/atomic.hpp>
+#include <boost/scoped_ptr.hpp>
+#include <boost/thread/condition_variable.hpp>
+#include <boost/thread/mutex.hpp>
 
 
 // FORWARD DECLARATIONS
@@ -74,73 +79,161 @@ using namespace shark;
 
 
 
+/*!@brief Worker thread training the SVM of a LinearSVM step.
+ *
+ * The thread is started once and trains whenever startTraining() is called. A new training cancels the running one
+ * through an atomic flag. Finished models are handed over through a lock-free slot, so the step can ask for them in
+ * every compute() without ever waiting for the training.
+ */
 class LinearSVMThread: public QThread
 {
 	Q_OBJECT
 
-public:	
-	bool start;
-	bool finished;
-	GaussianRbfKernel<> *kernel;
-	KernelClassifier<RealVector> *kc; // (affine) linear function in kernel-induced feature space
-	ClassificationDataset *training;
-	double gamma;
-	double C;
-	bool bias;
-	
-	// eats everything any linear SVM would need
-	LinearSVMThread () {
-		unsigned int ell = 500;     // number of training data point
-		gamma = 0.5;         // kernel bandwidth parameter
-		C = 1000.0;          // regularization parameter
-		bias = true;           // use bias/offset parameter
-		
-		// init kernel
-		kernel = new GaussianRbfKernel<>(gamma);
-		
-		Chessboard problem; // artificial benchmark data
-		*training = problem.generateDataset(ell);
-		
-		// threading things
-		start = false;
-		finished = false;
-	}
-
-	~LinearSVMThread() {
-		delete kernel;
-		delete training;
-	}
-	
-	KernelClassifier<RealVector>* getModel () {
-		return (kc);
-	}
-	
-	bool resultReady() {
-		return finished;
-	}
+public:
+	//!@brief A trained model and the number of the training it came from, 0 for none yet.
+	struct Result
+	{
+		//!@brief The kernel model, unless linear.
+		GaussianRbfExpansion predictor;
 
-	void run() {
-		CSvmTrainer<RealVector> trainer(kernel, C, bias);
-		trainer.train(*kc, *training);
-		
-		// 		cout << "\n  number of iterations: " << trainer.solutionProperties().iterations;
-		// 		cout << "\n  dual value: " << trainer.solutionProperties().value;
-		// 		cout << "\n  training time: " << trainer.solutionProperties().seconds << " seconds\ndone." << endl;
-		// 		
-		// for now just sleep little baby.
-		QThread::sleep (10);
-		finished = true;
-		
-		// sleep till death?
-	}
-	
+		//!@brief The linear model w, b, if linear.
+		RealVector weights;
+		double offset;
+		bool linear;
+
+		//!@brief The linear models of a regularization path, by descending lambda; the last one is the model above.
+		std::vector<RealVector> pathWeights;
+		std::vector<double> pathOffsets;
+		RealVector pathLambdas;
+
+		unsigned int training;
+
+		Result() : offset(0.0), linear(false), training(0) {}
+	};
+
+	LinearSVMThread();
+
+	//!@brief Cancels the training and stops the thread.
+	~LinearSVMThread();
+
+	//!@brief Hyper-parameters of a training.
+	struct Parameters
+	{
+		//!@brief one of SolverType
+		unsigned int solver;
+
+		//!@brief one of LossType, the kernel solver uses the hinge loss always
+		unsigned int loss;
+
+		//!@brief kernel bandwidth parameter
+		double gamma;
+
+		//!@brief regularization parameter, the C of the solver is 1/(lambda ell)
+		double lambda;
+
+		//!@brief use bias/offset parameter
+		bool offset;
+
+		//!@brief maximal number of sweeps of the solver, 0 for its default
+		std::size_t epochs;
+
+		//!@brief size of the kernel row cache in bytes
+		std::size_t cacheSize;
+
+		//!@brief threads of the linear solver, 0 for all cores
+		std::size_t threads;
+
+		//!@brief whether the threads of the linear solver add up their updates once per epoch instead of sharing them
+		bool deterministic;
+
+		//!@brief whether the linear solver continues from the model of the last training, if that had the same data
+		bool warmStart;
+
+		//!@brief number of models of the regularization path of the linear solver, 1 for the given lambda only
+		std::size_t pathLength;
+
+		//!@brief ratio of successive lambdas of the path, the path ends at the given lambda
+		double pathFactor;
+	};
+
+	//!@brief Starts a new training, a running one is cancelled. Does not wait for the thread.
+	//!@param data training data, binary labels; the batches are shared, not copied
+	//!@return the number of the new training, to ask for its model
+	unsigned int startTraining(const SharkSVMData& data, const Parameters& parameters);
+
+	//!@brief Starts a new training on sparse data, only the linear solver handles those.
+	unsigned int startTraining(const SharkSparseSVMData& data, const Parameters& parameters);
+
+	//!@brief Cancels the running training, its model is not published.
+	void cancel();
+
+	//!@brief Whether the running training should stop.
+	bool cancelled() const;
+
+	//!@brief Decision values of the model of the given training.
+	//!@param path decision value of every model of the regularization path, empty without one
+	//!@param lambdas lambda of every model of the regularization path
+	//!@param inputSize dimension of the points the model takes, 0 for any; for another one all outputs are empty
+	//!@return false if that model is not published yet
+	bool predict(unsigned int training, const RealVector& x, RealVector& decision, RealVector& path, RealVector& lambdas, std::size_t& inputSize) const;
+
+protected:
+	void run();
+
+private:
+	//!@brief Trains one model and publishes it unless cancelled.
+	void train(unsigned int training, const SharkSVMData& data, const SharkSparseSVMData& sparseData, const Parameters& parameters);
+
+	//!@brief Hands a request to the thread, only one of the datasets is non-empty.
+	unsigned int request(const SharkSVMData& data, const SharkSparseSVMData& sparseData, const Parameters& parameters);
+
+	//!@brief <w, x> + b, features the model has not seen have weight 0
+	static double linearDecision(const RealVector& w, double b, const RealVector& x);
+
+	//!@brief the linear solver of the last training with its data and solution, only used by the thread
+	boost::scoped_ptr<LinearDcdSolver> mLinearSolver;
+
+	//!@brief guards the fields below, never held during a training
+	boost::mutex mMutex;
+	boost::condition_variable mTrainingRequested;
+
+	//!@brief number of the requested training, 0 if none is waiting
+	unsigned int mRequested;
+
+	//!@brief data and hyper-parameters of the requested training
+	SharkSVMData mRequestedData;
+	SharkSparseSVMData mRequestedSparseData;
+	Parameters mRequestedParameters;
+
+	//!@brief number of trainings requested so far
+	unsigned int mTrainings;
+
+	//!@brief tells the thread to end
+	bool mQuit;
+
+	//!@brief tells the running training to stop
+	boost::atomic<bool> mCancel;
+
+	//!@brief the model published last
+	shark::ModelPublisher<Result> mResults;
 };
 
 
 
-/*!@todo describe.
+/*!@brief Trains an SVM on the dataset at its input, in the background.
+ *
+ * The training starts when a dataset is connected, compute() returns right away. The output is empty until the trained
+ * model is published, afterwards it holds the decision values of the input point. A new dataset or a parameter change
+ * starts a new training, the old one is cancelled.
  *
- * @todo describe more.
+ * The default solver trains a linear model by dual coordinate descent (shark::LinearDcdSolver), on dense or sparse
+ * data. The other one trains a Gaussian kernel model by SMO with a cache of kernel rows (shark::SmoSolver), on dense
+ * data only.
+ *
+ * A change of lambda lets the linear solver continue from the last model, rescaled to the new lambda. With a path
+ * length above 1, the linear solver trains a regularization path: lambdas descending by the path factor down to
+ * lambda, each model the start of the next. The path outputs hold the decision values of all its models and their
+ * lambdas.
  */
 class cShark::LinearSVM : public cedar::proc::Step
 {
@@ -157,6 +250,9 @@ public:
   //!@brief The standard constructor.
   LinearSVM();
 
+  //!@brief Stops the training thread.
+  ~LinearSVM();
+
   //--------------------------------------------------------------------------------------------------------------------
   // public methods
   //--------------------------------------------------------------------------------------------------------------------
@@ -176,20 +272,40 @@ private:
 	
 	void compute(const cedar::proc::Arguments& arguments);
 
+	//!@brief Hands the data and the parameters to the training thread.
+	//!@param warmStart continue from the last model, only if nothing but lambda changed
+	void startTraining(bool warmStart);
+
 public slots: 
+	//!@brief Starts over with a new training.
 	void reinitializeLinearSVM();
+
+	//!@brief Trains for the new lambda, from the last model if warm start is on.
+	void updateLambda();
 	
 	
 
 protected:
   // none yet
 private:
-	//!@brief MatrixData representing the input. Storing it like this saves time during computation.
-	CedarRealVectorPtr mInput;
+	//!@brief The point to predict.
+	ConstCedarRealVectorPtr mInput;
+
+	//!@brief The training data.
+	ConstCedarSVMDataPtr mDataset;
+
+	//!@brief The training data, if sparse.
+	ConstCedarSparseSVMDataPtr mSparseDataset;
 
 	//!@brief The output data.
 	CedarRealVectorPtr mOutput;
 
+	//!@brief Decision values of all models of the regularization path.
+	CedarRealVectorPtr mPathOutput;
+
+	//!@brief Lambdas of the models of the regularization path.
+	CedarRealVectorPtr mPathLambdas;
+
   //--------------------------------------------------------------------------------------------------------------------
   // parameters
   //--------------------------------------------------------------------------------------------------------------------
@@ -198,10 +314,17 @@ protected:
 
 private:
 
-	//!@brief thread control
-	bool isDeadNow;
-	bool isStarted;
-	bool isFinished;
+	//!@brief number of the training whose model is predicted with, 0 before the first; set by the parameter slots, read in compute()
+	boost::atomic<unsigned int> mTraining;
+
+	//!@brief Whether compute() already warned about inputs that do not fit the model, reset once they fit again.
+	bool mWrongDimensionReported;
+
+	//!@brief linear or kernel solver
+	cedar::aux::EnumParameterPtr mSolverType;
+
+	//!@brief loss of the linear solver
+	cedar::aux::EnumParameterPtr mLossType;
 	
 	//!@brief parameter for using bias term or not
 	cedar::aux::BoolParameterPtr mOffset;
@@ -209,21 +332,33 @@ private:
 	//!@brief regularization term
 	cedar::aux::DoubleParameterPtr mLambda;
 
-	//!@brief number of epochs
+	//!@brief maximal number of sweeps of the solver over the data, 0 for its default
 	cedar::aux::IntParameterPtr mEpochs;
+
+	//!@brief bandwidth of the Gaussian kernel
+	cedar::aux::DoubleParameterPtr mGamma;
 	
-	//!@brief cache size
+	//!@brief cache size in MB
 	cedar::aux::IntParameterPtr mCacheSize;
 
-	//!@brief we need the trainer in its own thread
+	//!@brief number of threads of the linear solver, 0 for all cores
+	cedar::aux::UIntParameterPtr mNumberOfThreads;
+
+	//!@brief reproducible parallel training of the linear solver, at the price of more epochs
+	cedar::aux::BoolParameterPtr mDeterministic;
+
+	//!@brief whether the linear solver continues from the last model when lambda changes
+	cedar::aux::BoolParameterPtr mWarmStart;
+
+	//!@brief number of models of the regularization path, 1 for none
+	cedar::aux::UIntParameterPtr mPathLength;
+
+	//!@brief ratio of successive lambdas of the regularization path
+	cedar::aux::DoubleParameterPtr mPathFactor;
+
+	//!@brief we need the trainer in its own thread, it is reused for every training
 	LinearSVMThread *mLinearSVMThread;
 	
-	//!@brief kernel to use FIXME should be abstract blabla
-	GaussianRbfKernel<> mKernel;
-	
-	//!@brief loss function FIXME should be abstract blabla
-	HingeLoss mLoss;
-	
 }; // class cShark::LinearSVM
 
 
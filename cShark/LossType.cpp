@@ -0,0 +1,78 @@
+/*======================================================================================================================
+
+    Copyright 2011, 2012, 2013, 2014, 2015 Institut fuer Neuroinformatik, Ruhr-Universitaet Bochum, Germany
+ 
+    This file is part of cedar.
+
+    cedar is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation, either version 3 of the License, or (at your
+    option) any later version.
+
+    cedar is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with cedar. If not, see <http://www.gnu.org/licenses/>.
+
+========================================================================================================================
+
+    Institute:   Ruhr-Universitaet Bochum
+                 Institut fuer Neuroinformatik
+
+    File:        LossType.cpp
+
+    Maintainer:  aydin demircioglu
+    Email:       aydin.demircioglu@ini.rub.de
+    Date:        2015 01 20
+
+    Description: Source file for the class cShark::LossType.
+
+    Credits:
+
+======================================================================================================================*/
+
+// CEDAR CONFIGURATION
+#include "cedar/configuration.h"
+
+// CLASS HEADER
+#include "LossType.h"
+
+// CEDAR INCLUDES
+
+// SYSTEM INCLUDES
+
+//----------------------------------------------------------------------------------------------------------------------
+// static members
+//----------------------------------------------------------------------------------------------------------------------
+
+cedar::aux::EnumType<cShark::LossType> cShark::LossType::mType("cShark::LossType::");
+
+#ifndef CEDAR_COMPILER_MSVC
+const cShark::LossType::Id cShark::LossType::Hinge;
+const cShark::LossType::Id cShark::LossType::SquaredHinge;
+const cShark::LossType::Id cShark::LossType::Logistic;
+#endif // CEDAR_COMPILER_MSVC
+
+//----------------------------------------------------------------------------------------------------------------------
+// methods
+//----------------------------------------------------------------------------------------------------------------------
+
+void cShark::LossType::construct()
+{
+  mType.type()->def(cedar::aux::Enum(Hinge, "Hinge", "Hinge"));
+  mType.type()->def(cedar::aux::Enum(SquaredHinge, "SquaredHinge", "Squared Hinge"));
+  mType.type()->def(cedar::aux::Enum(Logistic, "Logistic", "Logistic"));
+}
+
+const cedar::aux::EnumBase& cShark::LossType::type()
+{
+  return *cShark::LossType::mType.type();
+}
+
+const cShark::LossType::TypePtr& cShark::LossType::typePtr()
+{
+  return cShark::LossType::mType.type();
+}
@@ -0,0 +1,100 @@
+/*======================================================================================================================
+
+    Copyright 2011, 2012, 2013, 2014, 2015 Institut fuer Neuroinformatik, Ruhr-Universitaet Bochum, Germany
+ 
+    This file is part of cedar.
+
+    cedar is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation, either version 3 of the License, or (at your
+    option) any later version.
+
+    cedar is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with cedar. If not, see <http://www.gnu.org/licenses/>.
+
+========================================================================================================================
+
+    Institute:   Ruhr-Universitaet Bochum
+                 Institut fuer Neuroinformatik
+
+    File:        LossType.h
+
+    Maintainer:  aydin demircioglu
+    Email:       aydin.demircioglu@ini.rub.de
+    Date:        2015 01 20
+
+    Description: Header file for the class cShark::LossType.
+
+    Credits:
+
+======================================================================================================================*/
+
+#ifndef C_SHARK_LOSS_TYPE_H
+#define C_SHARK_LOSS_TYPE_H
+
+// CEDAR CONFIGURATION
+#include "cedar/configuration.h"
+
+// CEDAR INCLUDES
+#include <cedar/auxiliaries/EnumType.h>
+
+// SHARK THINGS
+#include "SharkSVM/SharkSVM.h"
+
+// FORWARD DECLARATIONS
+#include "LossType.fwd.h"
+
+// SYSTEM INCLUDES
+
+
+/*!@brief Enum describing the loss function of KernelSGD.
+ *
+ * The ids are those of shark::LossTypes, so they can be handed to the trainer directly.
+ */
+class cShark::LossType
+{
+  //--------------------------------------------------------------------------------------------------------------------
+  // typedefs
+  //--------------------------------------------------------------------------------------------------------------------
+public:
+  //! the id of an enum entry
+  typedef cedar::aux::EnumId Id;
+
+  //! constant pointer to an enum entry
+  typedef boost::shared_ptr<cedar::aux::EnumBase> TypePtr;
+
+  //--------------------------------------------------------------------------------------------------------------------
+  // public methods
+  //--------------------------------------------------------------------------------------------------------------------
+public:
+  //!@brief Construct the enum entries.
+  static void construct();
+
+  //!@brief Returns the enum base class.
+  static const cedar::aux::EnumBase& type();
+
+  //!@brief Returns a pointer to the enum base class.
+  static const cShark::LossType::TypePtr& typePtr();
+
+  //--------------------------------------------------------------------------------------------------------------------
+  // members
+  //--------------------------------------------------------------------------------------------------------------------
+public:
+  //! hinge loss of the SVM
+  static const Id Hinge = shark::LossTypes::HINGE;
+  //! squared hinge loss
+  static const Id SquaredHinge = shark::LossTypes::SQUARED_HINGE;
+  //! logistic loss (cross entropy), differentiable, so SGD converges much faster
+  static const Id Logistic = shark::LossTypes::LOGISTIC;
+
+private:
+  static cedar::aux::EnumType<cShark::LossType> mType;
+
+}; // class cShark::LossType
+
+#endif // C_SHARK_LOSS_TYPE_H
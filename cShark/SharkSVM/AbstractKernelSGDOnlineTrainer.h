@@ -0,0 +1,279 @@
+//===========================================================================
+/*!
+ *
+ *
+ * \brief       Online kernel SGD trainer with kernel and loss chosen at run time
+ *
+ *
+ *
+ * \author      Aydin Demircioglu
+ * \date        2015
+ *
+ *
+ * \par Copyright 1995-2015 Shark Development Team
+ *
+ * <BR><HR>
+ * This file is part of Shark.
+ * <http://image.diku.dk/shark/>
+ *
+ * Shark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Shark.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+//===========================================================================
+
+#ifndef SHARKSVM_ABSTRACTKERNELSGDONLINETRAINER_H
+#define SHARKSVM_ABSTRACTKERNELSGDONLINETRAINER_H
+
+#include <boost/shared_ptr.hpp>
+
+#include <shark/Models/Kernels/GaussianRbfKernel.h>
+#include <shark/Models/Kernels/LinearKernel.h>
+#include <shark/Models/Kernels/PolynomialKernel.h>
+#include <shark/ObjectiveFunctions/Loss/CrossEntropy.h>
+#include <shark/ObjectiveFunctions/Loss/HingeLoss.h>
+#include <shark/ObjectiveFunctions/Loss/SquaredHingeLoss.h>
+
+#include "SharkSVM.h"
+#include "SharkKernelSGDOnlineTrainer.h"
+
+
+namespace shark {
+
+
+    /// \brief Online kernel SGD trainer whose kernel and loss are chosen at run time.
+    ///
+    /// \par
+    /// create() picks the instantiation of KernelSGDOnlineTrainer for the
+    /// concrete kernel class once, so its inner loops call the kernel without
+    /// virtual dispatch. The calls made here are virtual, and so is the loss:
+    /// the trainer holds it as an AbstractLoss and evaluates its derivative
+    /// once per step (once per point of a mini-batch), which is cheap next to
+    /// the kernel row.
+    /// The trainer owns its loss and shares its kernel with the models it
+    /// writes, so they stay valid after the trainer is gone.
+    ///
+    /// \par
+    /// Lambda, the offset and the epochs can be changed while the model is
+    /// kept. A trainer for another kernel or loss can continue from the model
+    /// of an existing one (continueFrom).
+    ///
+    template <class InputType>
+    class AbstractKernelSGDOnlineTrainer {
+        public:
+            typedef AbstractKernelFunction<InputType> KernelType;
+            typedef KernelClassifier<InputType> ClassifierType;
+            typedef KernelExpansion<InputType> ModelType;
+            typedef KernelCache<float> KernelCacheType;
+            typedef typename ConstProxyReference<InputType const>::type ConstInputReference;
+
+            /// index of a point that is not part of a dataset
+            static const std::size_t NoIndex = static_cast<std::size_t> (-1);
+
+
+            virtual ~AbstractKernelSGDOnlineTrainer() {}
+
+
+
+            /// \brief Create a trainer.
+            ///
+            /// \param  kernelType      one of KernelTypes
+            /// \param  gamma           bandwidth of the RBF kernel exp(-gamma |a - b|^2)
+            /// \param  degree          degree of the polynomial kernel (<a, b> + kernelOffset)^degree
+            /// \param  kernelOffset    offset of the polynomial kernel
+            /// \param  lossType        one of LossTypes
+            /// \param  lambda          regularization parameter
+            /// \param  offset          whether to train with offset/bias parameter or not
+            /// \param  cacheSize       size of the kernel cache in bytes, 0 disables it
+            ///
+            static AbstractKernelSGDOnlineTrainer* create (unsigned int kernelType, double gamma, unsigned int degree, double kernelOffset,
+                    unsigned int lossType, double lambda, bool offset, std::size_t cacheSize) {
+                switch (kernelType) {
+                    case KernelTypes::LINEAR:
+                        return createWithLoss (new LinearKernel<InputType>(), lossType, lambda, offset, cacheSize);
+
+                    case KernelTypes::POLYNOMIAL:
+                        return createWithLoss (new PolynomialKernel<InputType> (degree, kernelOffset), lossType, lambda, offset, cacheSize);
+
+                    case KernelTypes::RBF:
+                        return createWithLoss (new GaussianRbfKernel<InputType> (gamma), lossType, lambda, offset, cacheSize);
+                }
+
+                throw SHARKSVMEXCEPTION ("Unknown kernel type");
+            }
+
+
+
+            /// \brief One Pegasos step, see KernelSGDOnlineTrainer::oneStep.
+            virtual RealVector const& oneStep (ConstInputReference x, unsigned int y, std::size_t index = NoIndex) = 0;
+
+            /// \brief Decision values of the current model.
+            virtual void decisionFunction (ConstInputReference x, RealVector &f) = 0;
+
+            /// \brief Write the current model into a classifier, it refers to the kernel of this trainer.
+            virtual void finalizeModel (ClassifierType &classifier) const = 0;
+
+            /// \brief The kernel, keep it as long as a classifier written by finalizeModel is used.
+            virtual boost::shared_ptr<KernelType> kernel() const = 0;
+
+            /// \brief Forget everything learned so far.
+            virtual void reset() = 0;
+
+            /// \brief Continue from a model, see KernelSGDOnlineTrainer::warmStart.
+            virtual void warmStart (ModelType const& model, std::size_t iterations) = 0;
+
+            /// \brief Continue from the model and the number of steps of another trainer,
+            /// its support vectors are evaluated with the kernel of this one.
+            void continueFrom (AbstractKernelSGDOnlineTrainer const& other) {
+                ClassifierType classifier;
+                other.finalizeModel (classifier);
+                warmStart (classifier.decisionFunction(), other.iterations());
+            }
+
+            virtual std::size_t numberOfSupportVectors() const = 0;
+            virtual std::size_t iterations() const = 0;
+
+            /// \brief Set lambda, the model is kept, see KernelSGDOnlineTrainer::setLambda.
+            virtual void setLambda (double lambda) = 0;
+            virtual void setTrainOffset (bool offset) = 0;
+            virtual void setEpochs (std::size_t epochs) = 0;
+            virtual void setNumberOfClasses (std::size_t classes) = 0;
+            virtual void setBudget (std::size_t budget, unsigned int strategy) = 0;
+            virtual void setCacheSize (std::size_t bytes) = 0;
+            virtual KernelCacheType const& cache() const = 0;
+
+            /// \brief Drop the cached kernel values if the indices refer to other data now,
+            /// see KernelSGDOnlineTrainer::setDataGeneration.
+            virtual void setDataGeneration (std::size_t generation) = 0;
+
+
+        private:
+
+            template <class KernelFunction>
+            static AbstractKernelSGDOnlineTrainer* createWithLoss (KernelFunction* kernel, unsigned int lossType, double lambda, bool offset, std::size_t cacheSize);
+    };
+
+
+
+    /// \brief AbstractKernelSGDOnlineTrainer for a concrete kernel and loss.
+    template <class InputType, class KernelFunction, class LossFunction>
+    class TypedKernelSGDOnlineTrainer : public AbstractKernelSGDOnlineTrainer<InputType> {
+        public:
+            typedef AbstractKernelSGDOnlineTrainer<InputType> base_type;
+            typedef typename base_type::ClassifierType ClassifierType;
+            typedef typename base_type::KernelCacheType KernelCacheType;
+            typedef typename base_type::ConstInputReference ConstInputReference;
+            typedef KernelSGDOnlineTrainer<InputType, float, KernelFunction> TrainerType;
+
+
+            /// takes ownership of the kernel
+            TypedKernelSGDOnlineTrainer (KernelFunction* kernel, double lambda, bool offset, std::size_t cacheSize) : m_kernel (kernel),
+                m_trainer (kernel, &m_loss, lambda, offset, false, cacheSize) {}
+
+
+            RealVector const& oneStep (ConstInputReference x, unsigned int y, std::size_t index) {
+                return m_trainer.oneStep (x, y, index);
+            }
+
+            void decisionFunction (ConstInputReference x, RealVector &f) {
+                m_trainer.decisionFunction (x, f);
+            }
+
+            void finalizeModel (ClassifierType &classifier) const {
+                m_trainer.finalizeModel (classifier);
+            }
+
+            boost::shared_ptr<typename base_type::KernelType> kernel() const {
+                return m_kernel;
+            }
+
+            void reset() {
+                m_trainer.reset();
+            }
+
+            void warmStart (typename base_type::ModelType const& model, std::size_t iterations) {
+                m_trainer.warmStart (model, iterations);
+            }
+
+            std::size_t numberOfSupportVectors() const {
+                return m_trainer.numberOfSupportVectors();
+            }
+
+            std::size_t iterations() const {
+                return m_trainer.iterations();
+            }
+
+            void setLambda (double lambda) {
+                m_trainer.setLambda (lambda);
+            }
+
+            void setTrainOffset (bool offset) {
+                m_trainer.setTrainOffset (offset);
+            }
+
+            void setEpochs (std::size_t epochs) {
+                m_trainer.setEpochs (epochs);
+            }
+
+            void setNumberOfClasses (std::size_t classes) {
+                m_trainer.setNumberOfClasses (classes);
+            }
+
+            void setBudget (std::size_t budget, unsigned int strategy) {
+                m_trainer.setBudget (budget, strategy);
+            }
+
+            void setCacheSize (std::size_t bytes) {
+                m_trainer.setCacheSize (bytes);
+            }
+
+            KernelCacheType const& cache() const {
+                return m_trainer.cache();
+            }
+
+            void setDataGeneration (std::size_t generation) {
+                m_trainer.setDataGeneration (generation);
+            }
+
+
+        private:
+
+            boost::shared_ptr<KernelFunction> m_kernel;
+            LossFunction m_loss;
+            TrainerType m_trainer;
+    };
+
+
+
+    template <class InputType>
+    template <class KernelFunction>
+    AbstractKernelSGDOnlineTrainer<InputType>* AbstractKernelSGDOnlineTrainer<InputType>::createWithLoss (KernelFunction* kernel, unsigned int lossType,
+            double lambda, bool offset, std::size_t cacheSize) {
+        switch (lossType) {
+            case LossTypes::HINGE:
+                return new TypedKernelSGDOnlineTrainer<InputType, KernelFunction, HingeLoss> (kernel, lambda, offset, cacheSize);
+
+            case LossTypes::SQUARED_HINGE:
+                return new TypedKernelSGDOnlineTrainer<InputType, KernelFunction, SquaredHingeLoss> (kernel, lambda, offset, cacheSize);
+
+            case LossTypes::LOGISTIC:
+                return new TypedKernelSGDOnlineTrainer<InputType, KernelFunction, CrossEntropy> (kernel, lambda, offset, cacheSize);
+        }
+
+        delete kernel;
+        throw SHARKSVMEXCEPTION ("Unknown loss type");
+    }
+
+}
+
+#endif
@@ -0,0 +1,470 @@
+//===========================================================================
+/*!
+ *
+ *
+ * \brief       Keeps the expansion of a kernel SGD model within a budget
+ *
+ *
+ *
+ * \author      Aydin Demircioglu
+ * \date        2015
+ *
+ *
+ * \par Copyright 1995-2015 Shark Development Team
+ *
+ * <BR><HR>
+ * This file is part of Shark.
+ * <http://image.diku.dk/shark/>
+ *
+ * Shark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Shark.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+//===========================================================================
+
+#ifndef SHARKSVM_BUDGETMAINTENANCE_H
+#define SHARKSVM_BUDGETMAINTENANCE_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <shark/Models/Kernels/AbstractKernelFunction.h>
+#include <shark/Models/Kernels/GaussianRbfKernel.h>
+
+#include "SharkSVM.h"
+
+
+namespace shark {
+
+
+    /// \brief Budget maintenance for kernel expansions grown by SGD.
+    ///
+    /// \par
+    /// The expansion is given as a list of points and a flat list of their
+    /// coefficients, outputs coefficients per point. Whenever it holds more
+    /// points than the budget allows, one point is taken out by one of the
+    /// strategies of BudgetMaintenanceStrategy, see
+    /// <i>Wang, Crammer, Vucetic. "Breaking the curse of kernelization: Budgeted
+    /// stochastic gradient descent for large-scale SVM training." JMLR 13 (2012).</i>
+    ///
+    /// \par
+    /// REMOVE drops the point with the smallest coefficients, the oldest one
+    /// among equals (with the hinge loss all coefficients have the same size).
+    /// PROJECT drops the point whose projection onto the span of all others
+    /// loses the least, and adds that projection to the other coefficients.
+    /// The inverse kernel matrix of the expansion is kept up to date for this,
+    /// so choosing and projecting costs O(budget^2) instead of O(budget^3).
+    /// MERGE (Gaussian RBF kernel only) replaces the point with the smallest
+    /// coefficients and its best partner by a single point on the line between
+    /// them, found by a golden section search.
+    ///
+    /// \par
+    /// Every point carries an id, e.g. for caching its kernel values. Removing
+    /// a point keeps the order of all others, a merged point gets a new id.
+    ///
+    template <class InputType>
+    class BudgetMaintenance {
+        public:
+            typedef AbstractKernelFunction<InputType> KernelType;
+
+
+            BudgetMaintenance() : m_kernel (NULL),
+                m_budget (0),
+                m_strategy (BudgetMaintenanceStrategy::REMOVE),
+                m_outputs (1),
+                m_size (0),
+                m_stride (0) {}
+
+
+
+            /// \brief Set budget and strategy for an expansion.
+            ///
+            /// \param  kernel      kernel of the expansion
+            /// \param  budget      maximal number of points, 0 means unlimited
+            /// \param  strategy    one of BudgetMaintenanceStrategy
+            /// \param  outputs     number of coefficients per point
+            /// \param  basis       current points of the expansion
+            ///
+            void reset (KernelType* kernel, std::size_t budget, unsigned int strategy, std::size_t outputs, std::vector<InputType> const &basis) {
+                if ((strategy != BudgetMaintenanceStrategy::REMOVE) &&
+                    (strategy != BudgetMaintenanceStrategy::MERGE) &&
+                    (strategy != BudgetMaintenanceStrategy::PROJECT))
+                    throw SHARKSVMEXCEPTION ("Unknown budget maintenance strategy");
+
+                if ((budget != 0) && (strategy == BudgetMaintenanceStrategy::MERGE) &&
+                    (dynamic_cast<GaussianRbfKernel<InputType> const*> (kernel) == NULL))
+                    throw SHARKSVMEXCEPTION ("Merging support vectors needs a Gaussian RBF kernel");
+
+                m_kernel = kernel;
+                m_budget = budget;
+                m_strategy = strategy;
+                m_outputs = outputs;
+
+                m_size = 0;
+                m_stride = 0;
+                std::vector<double>().swap (m_inverse);
+
+                if (usesInverse() == false)
+                    return;
+
+                // room for one point beyond the budget, it is removed right away
+                m_stride = std::max (budget, basis.size()) + 1;
+                m_inverse.resize (m_stride * m_stride);
+
+                std::vector<double> kernelRow;
+                for (std::size_t i = 0; i != basis.size(); ++i) {
+                    kernelRow.resize (i);
+                    for (std::size_t j = 0; j != i; ++j)
+                        kernelRow[j] = m_kernel->eval (basis[j], basis[i]);
+                    added (basis[i], kernelRow);
+                }
+            }
+
+
+            /// \brief maximal number of points, 0 means unlimited
+            std::size_t budget() const {
+                return m_budget;
+            }
+
+
+            /// \brief the strategy, one of BudgetMaintenanceStrategy
+            unsigned int strategy() const {
+                return m_strategy;
+            }
+
+
+
+            /// \brief Account for the point that was just appended to the expansion.
+            ///
+            /// \param  point       the new point
+            /// \param  kernelRow   kernel values between the new point and all others
+            ///
+            void added (InputType const &point, std::vector<double> const &kernelRow) {
+                if (usesInverse() == false)
+                    return;
+
+                SHARK_ASSERT (kernelRow.size() == m_size);
+
+                // block inverse of [K k; k^T kappa] from K^-1 with u = K^-1 k,
+                // the Schur complement s is kept away from zero for (nearly) repeated points
+                std::size_t n = m_size;
+                double kappa = m_kernel->eval (point, point);
+
+                if (n + 1 > m_stride)
+                    grow (2 * (n + 1));
+
+                std::vector<double> u (n, 0.0);
+                double s = kappa;
+                for (std::size_t i = 0; i != n; ++i) {
+                    double const* inverseRow = &m_inverse[i * m_stride];
+                    double sum = 0.0;
+                    for (std::size_t j = 0; j != n; ++j)
+                        sum += inverseRow[j] * kernelRow[j];
+                    u[i] = sum;
+                    s -= kernelRow[i] * sum;
+                }
+                s = std::max (s, 1e-8 * std::max (kappa, 1.0));
+
+                for (std::size_t i = 0; i != n; ++i) {
+                    double* inverseRow = &m_inverse[i * m_stride];
+                    double scaled = u[i] / s;
+                    for (std::size_t j = 0; j != n; ++j)
+                        inverseRow[j] += scaled * u[j];
+                    inverseRow[n] = -scaled;
+                    m_inverse[n * m_stride + i] = -scaled;
+                }
+                m_inverse[n * m_stride + n] = 1.0 / s;
+
+                ++m_size;
+            }
+
+
+
+            /// \brief Take points out of the expansion until it fits into the budget.
+            ///
+            /// \param  basis   the points of the expansion
+            /// \param  alpha   their coefficients, outputs per point
+            /// \param  ids     their ids
+            /// \param  nextId  id for the next new point, advanced if one is used
+            ///
+            void maintain (std::vector<InputType> &basis, std::vector<double> &alpha, std::vector<std::size_t> &ids, std::size_t &nextId) {
+                if (m_budget == 0)
+                    return;
+
+                while (basis.size() > m_budget) {
+                    switch (m_strategy) {
+                        case BudgetMaintenanceStrategy::MERGE:
+                            merge (basis, alpha, ids, nextId);
+                            break;
+
+                        case BudgetMaintenanceStrategy::PROJECT:
+                            project (basis, alpha, ids);
+                            break;
+
+                        default:
+                            removePoint (basis, alpha, ids, smallestCoefficients (alpha, basis.size()));
+                    }
+                }
+            }
+
+
+        private:
+
+            /// \brief is the inverse kernel matrix needed?
+            bool usesInverse() const {
+                return (m_budget != 0) && (m_strategy == BudgetMaintenanceStrategy::PROJECT);
+            }
+
+
+
+            /// \brief Make room for more points in the inverse kernel matrix.
+            void grow (std::size_t stride) {
+                std::vector<double> inverse (stride * stride);
+                for (std::size_t i = 0; i != m_size; ++i)
+                    std::copy (&m_inverse[i * m_stride], &m_inverse[i * m_stride] + m_size, &inverse[i * stride]);
+
+                m_inverse.swap (inverse);
+                m_stride = stride;
+            }
+
+
+
+            /// \brief squared norm of the coefficients of point i
+            double squaredNorm (std::vector<double> const &alpha, std::size_t i) const {
+                double sum = 0.0;
+                for (std::size_t c = 0; c != m_outputs; ++c)
+                    sum += alpha[i * m_outputs + c] * alpha[i * m_outputs + c];
+                return sum;
+            }
+
+
+
+            /// \brief point with the coefficients of smallest norm
+            std::size_t smallestCoefficients (std::vector<double> const &alpha, std::size_t size) const {
+                std::size_t best = 0;
+                double bestNorm = std::numeric_limits<double>::infinity();
+                for (std::size_t i = 0; i != size; ++i) {
+                    double norm = squaredNorm (alpha, i);
+                    if (norm < bestNorm) {
+                        bestNorm = norm;
+                        best = i;
+                    }
+                }
+                return best;
+            }
+
+
+
+            /// \brief Remove point p, the points behind it move up by one.
+            void removePoint (std::vector<InputType> &basis, std::vector<double> &alpha, std::vector<std::size_t> &ids, std::size_t p) {
+                std::size_t last = basis.size() - 1;
+
+                // swapping does not copy the points
+                using std::swap;
+                for (std::size_t i = p; i != last; ++i)
+                    swap (basis[i], basis[i + 1]);
+
+                basis.pop_back();
+                alpha.erase (alpha.begin() + p * m_outputs, alpha.begin() + (p + 1) * m_outputs);
+                ids.erase (ids.begin() + p);
+
+                if (usesInverse() == true)
+                    removeFromInverse (p);
+            }
+
+
+
+            /// \brief Inverse kernel matrix without point p from the one with it,
+            /// K_rest^-1 = (K^-1)_rest - b b^T / c, with b = (K^-1)_{rest,p} and c = (K^-1)_pp.
+            void removeFromInverse (std::size_t p) {
+                std::size_t n = m_size;
+                std::size_t last = n - 1;
+
+                double c = m_inverse[p * m_stride + p];
+                std::vector<double> b (n);
+                for (std::size_t i = 0; i != n; ++i)
+                    b[i] = m_inverse[i * m_stride + p];
+
+                for (std::size_t i = 0; i != n; ++i) {
+                    double* inverseRow = &m_inverse[i * m_stride];
+                    double scaled = b[i] / c;
+                    for (std::size_t j = 0; j != n; ++j)
+                        inverseRow[j] -= scaled * b[j];
+                }
+
+                // drop row and column p, every entry only moves towards the front
+                for (std::size_t i = 0; i != n; ++i) {
+                    if (i == p)
+                        continue;
+
+                    double const* source = &m_inverse[i * m_stride];
+                    double* target = &m_inverse[(i - (i > p)) * m_stride];
+                    for (std::size_t j = 0; j != n; ++j) {
+                        if (j != p)
+                            target[j - (j > p)] = source[j];
+                    }
+                }
+
+                m_size = last;
+            }
+
+
+
+            /// \brief Project the point with the least loss onto the others.
+            /// the best approximation of alpha_p k(x_p, .) by the others has coefficients
+            /// -alpha_p b / c, it misses by |alpha_p|^2 / c, both from the inverse.
+            void project (std::vector<InputType> &basis, std::vector<double> &alpha, std::vector<std::size_t> &ids) {
+                std::size_t n = basis.size();
+                SHARK_ASSERT (n == m_size);
+
+                std::size_t best = 0;
+                double bestLoss = std::numeric_limits<double>::infinity();
+                for (std::size_t i = 0; i != n; ++i) {
+                    double loss = squaredNorm (alpha, i) / m_inverse[i * m_stride + i];
+                    if (loss < bestLoss) {
+                        bestLoss = loss;
+                        best = i;
+                    }
+                }
+
+                double c = m_inverse[best * m_stride + best];
+                for (std::size_t i = 0; i != n; ++i) {
+                    if (i == best)
+                        continue;
+
+                    double factor = -m_inverse[i * m_stride + best] / c;
+                    for (std::size_t o = 0; o != m_outputs; ++o)
+                        alpha[i * m_outputs + o] += factor * alpha[best * m_outputs + o];
+                }
+
+                removePoint (basis, alpha, ids, best);
+            }
+
+
+
+            /// \brief Merge the point with the smallest coefficients with its best partner.
+            /// for the Gaussian kernel, z = h x_m + (1-h) x_n has k(x_m, z) = k_mn^((1-h)^2)
+            /// and k(x_n, z) = k_mn^(h^2), so the merge only needs k_mn.
+            void merge (std::vector<InputType> &basis, std::vector<double> &alpha, std::vector<std::size_t> &ids, std::size_t &nextId) {
+                std::size_t n = basis.size();
+                std::size_t m = smallestCoefficients (alpha, n);
+
+                std::size_t bestPartner = (m == 0) ? 1 : 0;
+                double bestH = 0.0;
+                double bestKernel = 0.0;
+                double bestLoss = std::numeric_limits<double>::infinity();
+
+                double normM = squaredNorm (alpha, m);
+                for (std::size_t j = 0; j != n; ++j) {
+                    if (j == m)
+                        continue;
+
+                    double k = m_kernel->eval (basis[m], basis[j]);
+
+                    double product = 0.0;
+                    for (std::size_t c = 0; c != m_outputs; ++c)
+                        product += alpha[m * m_outputs + c] * alpha[j * m_outputs + c];
+
+                    double h = goldenSection (alpha, m, j, k);
+
+                    // squared norm of the pair minus that of its merged point
+                    double loss = normM + squaredNorm (alpha, j) + 2.0 * k * product - mergedNorm (alpha, m, j, k, h);
+                    if (loss < bestLoss) {
+                        bestLoss = loss;
+                        bestPartner = j;
+                        bestH = h;
+                        bestKernel = k;
+                    }
+                }
+
+                double km = std::pow (bestKernel, (1.0 - bestH) * (1.0 - bestH));
+                double kn = std::pow (bestKernel, bestH * bestH);
+
+                InputType z = bestH * basis[m] + (1.0 - bestH) * basis[bestPartner];
+                basis[bestPartner] = z;
+                ids[bestPartner] = nextId++;
+                for (std::size_t c = 0; c != m_outputs; ++c)
+                    alpha[bestPartner * m_outputs + c] = km * alpha[m * m_outputs + c] + kn * alpha[bestPartner * m_outputs + c];
+
+                removePoint (basis, alpha, ids, m);
+            }
+
+
+
+            /// \brief squared norm of the coefficients of the merged point at h
+            double mergedNorm (std::vector<double> const &alpha, std::size_t m, std::size_t n, double k, double h) const {
+                double km = std::pow (k, (1.0 - h) * (1.0 - h));
+                double kn = std::pow (k, h * h);
+
+                double sum = 0.0;
+                for (std::size_t c = 0; c != m_outputs; ++c) {
+                    double merged = km * alpha[m * m_outputs + c] + kn * alpha[n * m_outputs + c];
+                    sum += merged * merged;
+                }
+                return sum;
+            }
+
+
+
+            /// \brief h in [0,1] that maximizes the norm of the merged coefficients
+            double goldenSection (std::vector<double> const &alpha, std::size_t m, std::size_t n, double k) const {
+                static const double ratio = 0.6180339887498949;
+
+                double a = 0.0;
+                double b = 1.0;
+                double x1 = b - ratio * (b - a);
+                double x2 = a + ratio * (b - a);
+                double f1 = mergedNorm (alpha, m, n, k, x1);
+                double f2 = mergedNorm (alpha, m, n, k, x2);
+
+                for (int iteration = 0; iteration != 24; ++iteration) {
+                    if (f1 < f2) {
+                        a = x1;
+                        x1 = x2;
+                        f1 = f2;
+                        x2 = a + ratio * (b - a);
+                        f2 = mergedNorm (alpha, m, n, k, x2);
+                    } else {
+                        b = x2;
+                        x2 = x1;
+                        f2 = f1;
+                        x1 = b - ratio * (b - a);
+                        f1 = mergedNorm (alpha, m, n, k, x1);
+                    }
+                }
+
+                return 0.5 * (a + b);
+            }
+
+
+
+            KernelType* m_kernel;
+
+            std::size_t m_budget;
+
+            unsigned int m_strategy;
+
+            std::size_t m_outputs;
+
+            /// inverse kernel matrix of the expansion, only kept for PROJECT,
+            /// m_size x m_size entries used with row length m_stride
+            std::size_t m_size;
+            std::size_t m_stride;
+            std::vector<double> m_inverse;
+    };
+
+}
+
+#endif
@@ -0,0 +1,261 @@
+//===========================================================================
+/*!
+ *
+ *
+ * \brief       Order in which the points of a dataset are visited per epoch
+ *
+ *
+ *
+ * \author      Aydin Demircioglu
+ * \date        2015
+ *
+ *
+ * \par Copyright 1995-2015 Shark Development Team
+ *
+ * <BR><HR>
+ * This file is part of Shark.
+ * <http://image.diku.dk/shark/>
+ *
+ * Shark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Shark.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+//===========================================================================
+
+#ifndef SHARKSVM_EPOCHSCHEDULER_H
+#define SHARKSVM_EPOCHSCHEDULER_H
+
+#include <algorithm>
+#include <utility>
+#include <vector>
+
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_01.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+
+#include "SharkSVM.h"
+
+
+namespace shark {
+
+
+    /// \brief Hands out the indices of a dataset epoch by epoch.
+    ///
+    /// \par
+    /// The modes are those of EpochModes:
+    /// SEQUENTIAL visits all points in storage order,
+    /// PERMUTATION visits them in a new random order every epoch,
+    /// STRATIFIED does the same, but interleaves the labels so that every
+    /// stretch of the epoch has roughly the label proportions of the whole data,
+    /// SHARDED visits every n-th point starting at k, in storage order, so that
+    /// n workers see disjoint parts of the data.
+    ///
+    /// \par
+    /// Only indices are kept, the data itself is never copied or reordered.
+    /// The order of an epoch is generated when its first index is requested.
+    ///
+    class EpochScheduler {
+        public:
+
+            EpochScheduler() : m_mode (EpochModes::SEQUENTIAL),
+                m_size (0),
+                m_shard (0),
+                m_numberOfShards (1),
+                m_position (0),
+                m_epoch (0),
+                m_stale (true) {}
+
+
+
+            /// \brief Start over with a dataset of the given size, the whole of it until setShard is called again.
+            ///
+            /// \param  size    number of points in the dataset
+            /// \param  mode    one of EpochModes
+            /// \param  labels  labels of the points, only needed for STRATIFIED
+            ///
+            void reset (std::size_t size, unsigned int mode, std::vector<unsigned int> const &labels = std::vector<unsigned int>()) {
+                if ((mode == EpochModes::STRATIFIED) && (labels.size() != size))
+                    throw SHARKSVMEXCEPTION ("Stratified epochs need a label for every point");
+
+                m_mode = mode;
+                m_size = size;
+                m_shard = 0;
+                m_numberOfShards = 1;
+                m_labels = (mode == EpochModes::STRATIFIED) ? labels : std::vector<unsigned int>();
+                std::vector<std::size_t>().swap (m_order);
+                m_position = 0;
+                m_epoch = 0;
+                m_stale = true;
+            }
+
+
+
+            /// \brief Select the part of the data seen in SHARDED mode.
+            ///
+            /// \param  shard           index of this worker, 0 .. numberOfShards-1
+            /// \param  numberOfShards  number of workers
+            ///
+            void setShard (std::size_t shard, std::size_t numberOfShards) {
+                if ((numberOfShards == 0) || (shard >= numberOfShards))
+                    throw SHARKSVMEXCEPTION ("Shard index must be smaller than the number of shards");
+
+                m_shard = shard;
+                m_numberOfShards = numberOfShards;
+                m_position = 0;
+            }
+
+
+
+            /// \brief Seed the generator used for the random orders.
+            void setSeed (unsigned int seed) {
+                m_rng.seed (seed);
+                m_stale = true;
+            }
+
+
+
+            /// \brief number of points visited in one epoch
+            std::size_t epochLength() const {
+                if (m_mode != EpochModes::SHARDED)
+                    return m_size;
+
+                if (m_shard >= m_size)
+                    return 0;
+
+                return (m_size - m_shard + m_numberOfShards - 1) / m_numberOfShards;
+            }
+
+
+
+            /// \brief number of completed epochs
+            std::size_t epoch() const {
+                return m_epoch;
+            }
+
+
+
+            /// \brief Index of the next point, an epoch boundary is crossed silently.
+            /// must not be called if epochLength() is zero.
+            ///
+            std::size_t next() {
+                if (m_position >= epochLength()) {
+                    m_position = 0;
+                    ++m_epoch;
+                    m_stale = true;
+                }
+
+                if (m_stale == true)
+                    regenerate();
+
+                std::size_t position = m_position++;
+
+                switch (m_mode) {
+                    case EpochModes::PERMUTATION:
+                    case EpochModes::STRATIFIED:
+                        return m_order[position];
+
+                    case EpochModes::SHARDED:
+                        return m_shard + position * m_numberOfShards;
+
+                    default:
+                        return position;
+                }
+            }
+
+
+        private:
+
+            /// \brief create the order of the current epoch
+            void regenerate() {
+                m_stale = false;
+
+                if (m_mode == EpochModes::PERMUTATION) {
+                    m_order.resize (m_size);
+                    for (std::size_t i = 0; i != m_size; ++i)
+                        m_order[i] = i;
+                    shuffle (m_order);
+                } else if (m_mode == EpochModes::STRATIFIED) {
+                    stratify();
+                }
+            }
+
+
+
+            /// \brief Fisher-Yates shuffle with our own generator
+            void shuffle (std::vector<std::size_t> &indices) {
+                for (std::size_t i = indices.size(); i > 1; --i) {
+                    boost::random::uniform_int_distribution<std::size_t> pick (0, i - 1);
+                    std::swap (indices[i - 1], indices[pick (m_rng)]);
+                }
+            }
+
+
+
+            /// \brief shuffle every class, then interleave the classes.
+            /// the j-th of n_c points of class c is placed at (j + u) / n_c,
+            /// u uniform in [0,1), so all classes are spread over the whole epoch.
+            void stratify() {
+                std::vector<std::vector<std::size_t> > classes;
+                for (std::size_t i = 0; i != m_size; ++i) {
+                    if (m_labels[i] >= classes.size())
+                        classes.resize (m_labels[i] + 1);
+                    classes[m_labels[i]].push_back (i);
+                }
+
+                boost::random::uniform_01<double> uniform;
+                std::vector<std::pair<double, std::size_t> > keys;
+                keys.reserve (m_size);
+
+                for (std::size_t c = 0; c != classes.size(); ++c) {
+                    shuffle (classes[c]);
+                    double n = static_cast<double> (classes[c].size());
+                    for (std::size_t j = 0; j != classes[c].size(); ++j)
+                        keys.push_back (std::make_pair ((j + uniform (m_rng)) / n, classes[c][j]));
+                }
+
+                std::sort (keys.begin(), keys.end());
+
+                m_order.resize (m_size);
+                for (std::size_t i = 0; i != m_size; ++i)
+                    m_order[i] = keys[i].second;
+            }
+
+
+
+            unsigned int m_mode;
+
+            std::size_t m_size;
+
+            /// labels of all points, kept for STRATIFIED only
+            std::vector<unsigned int> m_labels;
+
+            std::size_t m_shard;
+            std::size_t m_numberOfShards;
+
+            /// order of the current epoch, empty for SEQUENTIAL and SHARDED
+            std::vector<std::size_t> m_order;
+
+            /// position within the current epoch
+            std::size_t m_position;
+
+            std::size_t m_epoch;
+
+            /// the order has to be generated before the next index is handed out
+            bool m_stale;
+
+            boost::random::mt19937 m_rng;
+    };
+
+}
+
+#endif
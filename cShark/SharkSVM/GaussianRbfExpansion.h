@@ -0,0 +1,812 @@
+//===========================================================================
+/*!
+ *
+ *
+ * \brief       Fast evaluation of Gaussian RBF kernel expansions
+ *
+ *
+ *
+ * \author      Aydin Demircioglu
+ * \date        2015
+ *
+ *
+ * \par Copyright 1995-2015 Shark Development Team
+ *
+ * <BR><HR>
+ * This file is part of Shark.
+ * <http://image.diku.dk/shark/>
+ *
+ * Shark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Shark.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+//===========================================================================
+
+#ifndef SHARKSVM_GAUSSIANRBFEXPANSION_H
+#define SHARKSVM_GAUSSIANRBFEXPANSION_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+#include <boost/align/aligned_allocator.hpp>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+#include <shark/Models/Kernels/GaussianRbfKernel.h>
+#include <shark/Models/Kernels/KernelExpansion.h>
+
+#include "SharkSVM.h"
+
+
+namespace shark {
+
+    namespace detail {
+
+        /// \brief SIMD building blocks of GaussianRbfExpansion.
+        ///
+        /// \par
+        /// All rows are padded to a multiple of 8 doubles and aligned to 64 bytes,
+        /// so the loops over a row need no tail handling for AVX2 or AVX-512.
+        /// Without AVX2 and FMA (e.g. no -mavx2 -mfma) the plain loops are used,
+        /// the compiler may still vectorize them.
+        ///
+        class RbfKernels {
+            public:
+
+                /// \brief doubles a row is padded to
+                static const std::size_t padding = 8;
+
+
+                /// \brief Dot products of the rows s[0..3] with x.
+                static void dot4 (double const* s0, double const* s1, double const* s2, double const* s3,
+                                  double const* x, std::size_t length, double* out) {
+#if defined(__AVX512F__)
+                    __m512d a0 = _mm512_setzero_pd();
+                    __m512d a1 = _mm512_setzero_pd();
+                    __m512d a2 = _mm512_setzero_pd();
+                    __m512d a3 = _mm512_setzero_pd();
+                    for (std::size_t j = 0; j < length; j += 8) {
+                        __m512d v = _mm512_load_pd (x + j);
+                        a0 = _mm512_fmadd_pd (_mm512_load_pd (s0 + j), v, a0);
+                        a1 = _mm512_fmadd_pd (_mm512_load_pd (s1 + j), v, a1);
+                        a2 = _mm512_fmadd_pd (_mm512_load_pd (s2 + j), v, a2);
+                        a3 = _mm512_fmadd_pd (_mm512_load_pd (s3 + j), v, a3);
+                    }
+                    out[0] = _mm512_reduce_add_pd (a0);
+                    out[1] = _mm512_reduce_add_pd (a1);
+                    out[2] = _mm512_reduce_add_pd (a2);
+                    out[3] = _mm512_reduce_add_pd (a3);
+#elif defined(__AVX2__) && defined(__FMA__)
+                    __m256d a0 = _mm256_setzero_pd();
+                    __m256d a1 = _mm256_setzero_pd();
+                    __m256d a2 = _mm256_setzero_pd();
+                    __m256d a3 = _mm256_setzero_pd();
+                    for (std::size_t j = 0; j < length; j += 4) {
+                        __m256d v = _mm256_load_pd (x + j);
+                        a0 = _mm256_fmadd_pd (_mm256_load_pd (s0 + j), v, a0);
+                        a1 = _mm256_fmadd_pd (_mm256_load_pd (s1 + j), v, a1);
+                        a2 = _mm256_fmadd_pd (_mm256_load_pd (s2 + j), v, a2);
+                        a3 = _mm256_fmadd_pd (_mm256_load_pd (s3 + j), v, a3);
+                    }
+                    _mm256_storeu_pd (out, reduce4 (a0, a1, a2, a3));
+#else
+                    double a0 = 0.0, a1 = 0.0, a2 = 0.0, a3 = 0.0;
+                    for (std::size_t j = 0; j < length; ++j) {
+                        a0 += s0[j] * x[j];
+                        a1 += s1[j] * x[j];
+                        a2 += s2[j] * x[j];
+                        a3 += s3[j] * x[j];
+                    }
+                    out[0] = a0;
+                    out[1] = a1;
+                    out[2] = a2;
+                    out[3] = a3;
+#endif
+                }
+
+
+                /// \brief Dot products of the rows s[0..3] with the two points x and y.
+                /// the micro kernel of the batch evaluation: every row is loaded once for
+                /// both points, so there are 6 loads per 8 multiply-adds instead of 5 per 4.
+                static void dot4x2 (double const* s0, double const* s1, double const* s2, double const* s3,
+                                    double const* x, double const* y, std::size_t length, double* outX, double* outY) {
+#if defined(__AVX512F__)
+                    __m512d a0 = _mm512_setzero_pd(), b0 = _mm512_setzero_pd();
+                    __m512d a1 = _mm512_setzero_pd(), b1 = _mm512_setzero_pd();
+                    __m512d a2 = _mm512_setzero_pd(), b2 = _mm512_setzero_pd();
+                    __m512d a3 = _mm512_setzero_pd(), b3 = _mm512_setzero_pd();
+                    for (std::size_t j = 0; j < length; j += 8) {
+                        __m512d u = _mm512_load_pd (x + j);
+                        __m512d v = _mm512_load_pd (y + j);
+                        __m512d r = _mm512_load_pd (s0 + j);
+                        a0 = _mm512_fmadd_pd (r, u, a0);
+                        b0 = _mm512_fmadd_pd (r, v, b0);
+                        r = _mm512_load_pd (s1 + j);
+                        a1 = _mm512_fmadd_pd (r, u, a1);
+                        b1 = _mm512_fmadd_pd (r, v, b1);
+                        r = _mm512_load_pd (s2 + j);
+                        a2 = _mm512_fmadd_pd (r, u, a2);
+                        b2 = _mm512_fmadd_pd (r, v, b2);
+                        r = _mm512_load_pd (s3 + j);
+                        a3 = _mm512_fmadd_pd (r, u, a3);
+                        b3 = _mm512_fmadd_pd (r, v, b3);
+                    }
+                    outX[0] = _mm512_reduce_add_pd (a0);
+                    outX[1] = _mm512_reduce_add_pd (a1);
+                    outX[2] = _mm512_reduce_add_pd (a2);
+                    outX[3] = _mm512_reduce_add_pd (a3);
+                    outY[0] = _mm512_reduce_add_pd (b0);
+                    outY[1] = _mm512_reduce_add_pd (b1);
+                    outY[2] = _mm512_reduce_add_pd (b2);
+                    outY[3] = _mm512_reduce_add_pd (b3);
+#elif defined(__AVX2__) && defined(__FMA__)
+                    __m256d a0 = _mm256_setzero_pd(), b0 = _mm256_setzero_pd();
+                    __m256d a1 = _mm256_setzero_pd(), b1 = _mm256_setzero_pd();
+                    __m256d a2 = _mm256_setzero_pd(), b2 = _mm256_setzero_pd();
+                    __m256d a3 = _mm256_setzero_pd(), b3 = _mm256_setzero_pd();
+                    for (std::size_t j = 0; j < length; j += 4) {
+                        __m256d u = _mm256_load_pd (x + j);
+                        __m256d v = _mm256_load_pd (y + j);
+                        __m256d r = _mm256_load_pd (s0 + j);
+                        a0 = _mm256_fmadd_pd (r, u, a0);
+                        b0 = _mm256_fmadd_pd (r, v, b0);
+                        r = _mm256_load_pd (s1 + j);
+                        a1 = _mm256_fmadd_pd (r, u, a1);
+                        b1 = _mm256_fmadd_pd (r, v, b1);
+                        r = _mm256_load_pd (s2 + j);
+                        a2 = _mm256_fmadd_pd (r, u, a2);
+                        b2 = _mm256_fmadd_pd (r, v, b2);
+                        r = _mm256_load_pd (s3 + j);
+                        a3 = _mm256_fmadd_pd (r, u, a3);
+                        b3 = _mm256_fmadd_pd (r, v, b3);
+                    }
+                    _mm256_storeu_pd (outX, reduce4 (a0, a1, a2, a3));
+                    _mm256_storeu_pd (outY, reduce4 (b0, b1, b2, b3));
+#else
+                    dot4 (s0, s1, s2, s3, x, length, outX);
+                    dot4 (s0, s1, s2, s3, y, length, outY);
+#endif
+                }
+
+
+                /// \brief Dot product of two rows.
+                static double dot (double const* s, double const* x, std::size_t length) {
+                    double out[4];
+                    dot4 (s, s, s, s, x, length, out);
+                    return out[0];
+                }
+
+
+
+                /// \brief v[i] = exp(v[i]) for all i, the arguments must not be positive.
+                /// results below the smallest normal double are flushed to zero.
+                static void expNonPositive (double* v, std::size_t n) {
+                    std::size_t i = 0;
+#if defined(__AVX2__) && defined(__FMA__)
+                    for (; i + 4 <= n; i += 4)
+                        _mm256_storeu_pd (v + i, exp4 (_mm256_loadu_pd (v + i)));
+#endif
+                    for (; i < n; ++i)
+                        v[i] = std::exp (v[i]);
+                }
+
+
+            private:
+
+#if defined(__AVX2__) && defined(__FMA__)
+                /// \brief transpose-and-add four accumulators into one vector of their sums
+                static __m256d reduce4 (__m256d a0, __m256d a1, __m256d a2, __m256d a3) {
+                    __m256d h01 = _mm256_hadd_pd (a0, a1);
+                    __m256d h23 = _mm256_hadd_pd (a2, a3);
+                    return _mm256_add_pd (_mm256_permute2f128_pd (h01, h23, 0x20), _mm256_permute2f128_pd (h01, h23, 0x31));
+                }
+
+
+                /// \brief exp for four arguments <= 0, within a few ulp of std::exp.
+                /// x = n ln2 + r with |r| <= ln2/2, exp(r) by its Taylor polynomial of
+                /// degree 13, 2^n put directly into the exponent bits.
+                static __m256d exp4 (__m256d x) {
+                    const __m256d minimum = _mm256_set1_pd (-708.39);
+                    __m256d underflow = _mm256_cmp_pd (x, minimum, _CMP_LT_OQ);
+                    x = _mm256_max_pd (x, minimum);
+
+                    __m256d n = _mm256_round_pd (_mm256_mul_pd (x, _mm256_set1_pd (1.4426950408889634)),
+                                                 _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+                    __m256d r = _mm256_fnmadd_pd (n, _mm256_set1_pd (6.93147180369123816490e-01), x);
+                    r = _mm256_fnmadd_pd (n, _mm256_set1_pd (1.90821492927058770002e-10), r);
+
+                    __m256d p = _mm256_set1_pd (1.0 / 6227020800.0);
+                    p = _mm256_fmadd_pd (p, r, _mm256_set1_pd (1.0 / 479001600.0));
+                    p = _mm256_fmadd_pd (p, r, _mm256_set1_pd (1.0 / 39916800.0));
+                    p = _mm256_fmadd_pd (p, r, _mm256_set1_pd (1.0 / 3628800.0));
+                    p = _mm256_fmadd_pd (p, r, _mm256_set1_pd (1.0 / 362880.0));
+                    p = _mm256_fmadd_pd (p, r, _mm256_set1_pd (1.0 / 40320.0));
+                    p = _mm256_fmadd_pd (p, r, _mm256_set1_pd (1.0 / 5040.0));
+                    p = _mm256_fmadd_pd (p, r, _mm256_set1_pd (1.0 / 720.0));
+                    p = _mm256_fmadd_pd (p, r, _mm256_set1_pd (1.0 / 120.0));
+                    p = _mm256_fmadd_pd (p, r, _mm256_set1_pd (1.0 / 24.0));
+                    p = _mm256_fmadd_pd (p, r, _mm256_set1_pd (1.0 / 6.0));
+                    p = _mm256_fmadd_pd (p, r, _mm256_set1_pd (0.5));
+                    p = _mm256_fmadd_pd (p, r, _mm256_set1_pd (1.0));
+                    p = _mm256_fmadd_pd (p, r, _mm256_set1_pd (1.0));
+
+                    __m256i exponent = _mm256_cvtepi32_epi64 (_mm256_cvtpd_epi32 (n));
+                    exponent = _mm256_slli_epi64 (_mm256_add_epi64 (exponent, _mm256_set1_epi64x (1023)), 52);
+                    __m256d result = _mm256_mul_pd (p, _mm256_castsi256_pd (exponent));
+
+                    return _mm256_andnot_pd (underflow, result);
+                }
+#endif
+        };
+
+    }
+
+
+
+    /// \brief Gaussian RBF kernel expansion f(x) = sum_i alpha_i exp(-gamma |s_i - x|^2) + b for fast prediction.
+    ///
+    /// \par
+    /// The support vectors are stored as rows of one contiguous, aligned matrix,
+    /// each row padded to a multiple of 8 doubles, together with their squared
+    /// norms. Then |s_i - x|^2 = |s_i|^2 - 2 <s_i, x> + |x|^2, so a prediction is
+    /// a blocked matrix-vector product, a vectorized exp and a small product with
+    /// the coefficients. Batches of points are evaluated block by block as a
+    /// matrix-matrix product, so every support vector is loaded once per block.
+    ///
+    /// \par
+    /// Models of sparse points (CompressedRealVector) keep their support vectors
+    /// as sparse rows instead; the query is scattered into a dense vector and each
+    /// inner product visits the stored entries of one support vector only. Sparse
+    /// queries of dense models gather their few entries from every row. Either
+    /// way a kernel value costs O(nnz) instead of O(d).
+    ///
+    /// \par
+    /// Build with AVX2 and FMA (or AVX-512) for the vectorized code paths, else
+    /// the scalar fallback is used. The results agree with KernelExpansion up to
+    /// rounding.
+    ///
+    class GaussianRbfExpansion {
+        public:
+
+            GaussianRbfExpansion() : m_gamma (1.0),
+                m_sparse (false),
+                m_dimension (0),
+                m_stride (0),
+                m_size (0),
+                m_outputs (0) {}
+
+
+
+            /// \brief Copy a trained model, its kernel must be a GaussianRbfKernel.
+            void setModel (KernelExpansion<RealVector> const &model) {
+                GaussianRbfKernel<RealVector> const* kernel = dynamic_cast<GaussianRbfKernel<RealVector> const*> (model.kernel());
+                if (kernel == NULL)
+                    throw SHARKSVMEXCEPTION ("Fast expansion evaluation needs a Gaussian RBF kernel");
+
+                std::vector<RealVector> basis;
+                Data<RealVector> const &data = model.basis();
+                for (std::size_t b = 0; b != data.numberOfBatches(); ++b) {
+                    RealMatrix const &batch = data.batch (b);
+                    for (std::size_t r = 0; r != batch.size1(); ++r)
+                        basis.push_back (row (batch, r));
+                }
+
+                RealVector offset;
+                if (model.hasOffset())
+                    offset = model.offset();
+
+                setStructure (kernel->gamma(), basis, model.alpha(), offset);
+            }
+
+
+
+            /// \brief Copy a trained model of sparse points, its kernel must be a GaussianRbfKernel.
+            void setModel (KernelExpansion<CompressedRealVector> const &model) {
+                GaussianRbfKernel<CompressedRealVector> const* kernel = dynamic_cast<GaussianRbfKernel<CompressedRealVector> const*> (model.kernel());
+                if (kernel == NULL)
+                    throw SHARKSVMEXCEPTION ("Fast expansion evaluation needs a Gaussian RBF kernel");
+
+                std::vector<CompressedRealVector> basis;
+                Data<CompressedRealVector> const &data = model.basis();
+                for (std::size_t b = 0; b != data.numberOfBatches(); ++b) {
+                    CompressedRealMatrix const &batch = data.batch (b);
+                    for (std::size_t r = 0; r != batch.size1(); ++r)
+                        basis.push_back (row (batch, r));
+                }
+
+                RealVector offset;
+                if (model.hasOffset())
+                    offset = model.offset();
+
+                setStructure (kernel->gamma(), basis, model.alpha(), offset);
+            }
+
+
+
+            /// \brief Set the expansion directly.
+            ///
+            /// \param  gamma   bandwidth of the kernel exp(-gamma |a - b|^2)
+            /// \param  basis   the support vectors
+            /// \param  alpha   their coefficients, one row per support vector, one column per output
+            /// \param  offset  one offset per output, or empty for none
+            ///
+            void setStructure (double gamma, std::vector<RealVector> const &basis, RealMatrix const &alpha, RealVector const &offset) {
+                if (alpha.size1() != basis.size())
+                    throw SHARKSVMEXCEPTION ("Need one row of coefficients per support vector");
+
+                m_gamma = gamma;
+                m_sparse = false;
+                m_size = basis.size();
+                m_outputs = alpha.size2();
+                m_dimension = basis.empty() ? 0 : basis[0].size();
+                m_stride = padded (m_dimension);
+
+                // the padding is zero, so it does not change any dot product
+                m_points.assign (std::max<std::size_t> (m_size, 1) * m_stride, 0.0);
+                m_norms.assign (m_size, 0.0);
+                for (std::size_t i = 0; i != m_size; ++i) {
+                    if (basis[i].size() != m_dimension)
+                        throw SHARKSVMEXCEPTION ("All support vectors need the same dimension");
+
+                    double* point = &m_points[i * m_stride];
+                    std::copy (basis[i].begin(), basis[i].end(), point);
+                    m_norms[i] = detail::RbfKernels::dot (point, point, m_stride);
+                }
+
+                setCoefficients (alpha, offset);
+            }
+
+
+
+            /// \brief Set an expansion of sparse support vectors directly, see above.
+            void setStructure (double gamma, std::vector<CompressedRealVector> const &basis, RealMatrix const &alpha, RealVector const &offset) {
+                if (alpha.size1() != basis.size())
+                    throw SHARKSVMEXCEPTION ("Need one row of coefficients per support vector");
+
+                m_gamma = gamma;
+                m_sparse = true;
+                m_size = basis.size();
+                m_outputs = alpha.size2();
+                m_dimension = 0;
+                m_stride = 0;
+                m_points.clear();
+
+                m_rowStart.assign (1, 0);
+                m_columns.clear();
+                m_values.clear();
+                m_norms.assign (m_size, 0.0);
+                for (std::size_t i = 0; i != m_size; ++i) {
+                    m_dimension = std::max (m_dimension, basis[i].size());
+
+                    for (CompressedRealVector::const_iterator it = basis[i].begin(); it != basis[i].end(); ++it) {
+                        if (*it == 0.0)
+                            continue;
+
+                        m_columns.push_back (it.index());
+                        m_values.push_back (*it);
+                        m_norms[i] += *it * *it;
+                    }
+                    m_rowStart.push_back (m_columns.size());
+                }
+
+                setCoefficients (alpha, offset);
+            }
+
+
+
+            /// \brief number of support vectors
+            std::size_t numberOfSupportVectors() const {
+                return m_size;
+            }
+
+
+            /// \brief dimension of the points
+            std::size_t inputSize() const {
+                return m_dimension;
+            }
+
+
+            /// \brief number of decision values
+            std::size_t outputSize() const {
+                return m_outputs;
+            }
+
+
+
+            /// \brief Decision values for a single point.
+            void eval (RealVector const &x, RealVector &f) const {
+                if (constant (f))
+                    return;
+
+                if (x.size() != m_dimension)
+                    throw SHARKSVMEXCEPTION ("Point has the wrong dimension");
+
+                if (f.size() != m_outputs)
+                    f = RealVector (m_outputs);
+
+                if (m_sparse) {
+                    double norm = inner_prod (x, x);
+                    expansion (ScatteredDots (*this, m_dimension == 0 ? NULL : &x (0)), norm, &f (0));
+                    return;
+                }
+
+                AlignedVector padded (m_stride, 0.0);
+                std::copy (x.begin(), x.end(), padded.begin());
+                double norm = detail::RbfKernels::dot (&padded[0], &padded[0], m_stride);
+
+                expansion (DenseDots (*this, &padded[0]), norm, &f (0));
+            }
+
+
+
+            /// \brief Decision values for a single sparse point, entries beyond the dimension of the model may be non-zero.
+            void eval (CompressedRealVector const &x, RealVector &f) const {
+                if (constant (f))
+                    return;
+
+                if (f.size() != m_outputs)
+                    f = RealVector (m_outputs);
+
+                evalSparse (x, &f (0));
+            }
+
+
+
+            /// \brief Decision values for a batch of points, one per row.
+            void eval (RealMatrix const &inputs, RealMatrix &outputs) const {
+                if (constant (inputs.size1(), outputs))
+                    return;
+
+                if ((inputs.size1() != 0) && (inputs.size2() != m_dimension))
+                    throw SHARKSVMEXCEPTION ("Points have the wrong dimension");
+
+                std::size_t n = inputs.size1();
+                if ((outputs.size1() != n) || (outputs.size2() != m_outputs))
+                    outputs = RealMatrix (n, m_outputs);
+
+                if (m_sparse) {
+                    RealVector x;
+                    RealVector f (m_outputs);
+                    for (std::size_t p = 0; p != n; ++p) {
+                        x = row (inputs, p);
+                        eval (x, f);
+                        noalias (row (outputs, p)) = f;
+                    }
+                    return;
+                }
+
+                // copy a block of points into padded rows, then go over all support vectors once
+                AlignedVector block (PointBlock * m_stride, 0.0);
+                double norms[PointBlock];
+                double kernel[Block];
+                double pairKernel[Block];
+                std::vector<double> f (PointBlock * m_outputs);
+
+                for (std::size_t firstPoint = 0; firstPoint < n; firstPoint += PointBlock) {
+                    std::size_t points = std::min<std::size_t> (PointBlock, n - firstPoint);
+
+                    for (std::size_t p = 0; p != points; ++p) {
+                        double* target = &block[p * m_stride];
+                        for (std::size_t j = 0; j != m_dimension; ++j)
+                            target[j] = inputs (firstPoint + p, j);
+                        norms[p] = detail::RbfKernels::dot (target, target, m_stride);
+
+                        for (std::size_t c = 0; c != m_outputs; ++c)
+                            f[p * m_outputs + c] = m_offset (c);
+                    }
+
+                    for (std::size_t first = 0; first < m_size; first += Block) {
+                        std::size_t count = std::min<std::size_t> (Block, m_size - first);
+
+                        // this block of support vectors stays in cache for all points,
+                        // two points at a time share the loads of the support vectors
+                        std::size_t p = 0;
+                        for (; p + 2 <= points; p += 2) {
+                            DenseDotPairs (*this, &block[p * m_stride], &block[ (p + 1) * m_stride]) (first, count, kernel, pairKernel);
+                            kernelValues (norms[p], first, count, kernel);
+                            accumulate (kernel, first, count, &f[p * m_outputs]);
+                            kernelValues (norms[p + 1], first, count, pairKernel);
+                            accumulate (pairKernel, first, count, &f[ (p + 1) * m_outputs]);
+                        }
+                        for (; p != points; ++p) {
+                            DenseDots (*this, &block[p * m_stride]) (first, count, kernel);
+                            kernelValues (norms[p], first, count, kernel);
+                            accumulate (kernel, first, count, &f[p * m_outputs]);
+                        }
+                    }
+
+                    for (std::size_t p = 0; p != points; ++p) {
+                        for (std::size_t c = 0; c != m_outputs; ++c)
+                            outputs (firstPoint + p, c) = f[p * m_outputs + c];
+                    }
+                }
+            }
+
+
+
+            /// \brief Decision values for a batch of sparse points, one per row.
+            void eval (CompressedRealMatrix const &inputs, RealMatrix &outputs) const {
+                if (constant (inputs.size1(), outputs))
+                    return;
+
+                std::size_t n = inputs.size1();
+                if ((outputs.size1() != n) || (outputs.size2() != m_outputs))
+                    outputs = RealMatrix (n, m_outputs);
+
+                RealVector f (m_outputs);
+                for (std::size_t p = 0; p != n; ++p) {
+                    evalSparse (row (inputs, p), &f (0));
+                    noalias (row (outputs, p)) = f;
+                }
+            }
+
+
+        private:
+
+            typedef std::vector<double, boost::alignment::aligned_allocator<double, 64> > AlignedVector;
+
+            /// support vectors handled at once, their kernel values fit on the stack
+            static const std::size_t Block = 256;
+
+            /// points of a batch handled at once
+            static const std::size_t PointBlock = 64;
+
+
+
+            /// \brief row length after padding
+            static std::size_t padded (std::size_t dimension) {
+                std::size_t padding = detail::RbfKernels::padding;
+                return std::max<std::size_t> ((dimension + padding - 1) / padding, 1) * padding;
+            }
+
+
+
+            /// \brief inner products of the padded dense support vectors with a padded dense query
+            struct DenseDots {
+                DenseDots (GaussianRbfExpansion const &expansion, double const* x) : m_expansion (expansion), m_x (x) {}
+
+                void operator() (std::size_t first, std::size_t count, double* dots) const {
+                    std::size_t stride = m_expansion.m_stride;
+                    std::size_t i = 0;
+                    for (; i + 4 <= count; i += 4) {
+                        double const* s = &m_expansion.m_points[(first + i) * stride];
+                        detail::RbfKernels::dot4 (s, s + stride, s + 2 * stride, s + 3 * stride, m_x, stride, dots + i);
+                    }
+                    for (; i < count; ++i)
+                        dots[i] = detail::RbfKernels::dot (&m_expansion.m_points[(first + i) * stride], m_x, stride);
+                }
+
+                GaussianRbfExpansion const &m_expansion;
+                double const* m_x;
+            };
+
+
+            /// \brief inner products of the padded dense support vectors with two padded dense queries
+            struct DenseDotPairs {
+                DenseDotPairs (GaussianRbfExpansion const &expansion, double const* x, double const* y) : m_expansion (expansion), m_x (x), m_y (y) {}
+
+                void operator() (std::size_t first, std::size_t count, double* dotsX, double* dotsY) const {
+                    std::size_t stride = m_expansion.m_stride;
+                    std::size_t i = 0;
+                    for (; i + 4 <= count; i += 4) {
+                        double const* s = &m_expansion.m_points[(first + i) * stride];
+                        detail::RbfKernels::dot4x2 (s, s + stride, s + 2 * stride, s + 3 * stride, m_x, m_y, stride, dotsX + i, dotsY + i);
+                    }
+                    for (; i < count; ++i) {
+                        dotsX[i] = detail::RbfKernels::dot (&m_expansion.m_points[(first + i) * stride], m_x, stride);
+                        dotsY[i] = detail::RbfKernels::dot (&m_expansion.m_points[(first + i) * stride], m_y, stride);
+                    }
+                }
+
+                GaussianRbfExpansion const &m_expansion;
+                double const* m_x;
+                double const* m_y;
+            };
+
+
+            /// \brief inner products of the padded dense support vectors with a sparse query
+            struct GatherDots {
+                GatherDots (GaussianRbfExpansion const &expansion, std::vector<std::size_t> const &indices, std::vector<double> const &values) :
+                    m_expansion (expansion), m_indices (indices), m_values (values) {}
+
+                void operator() (std::size_t first, std::size_t count, double* dots) const {
+                    for (std::size_t i = 0; i != count; ++i) {
+                        double const* s = &m_expansion.m_points[(first + i) * m_expansion.m_stride];
+                        double sum = 0.0;
+                        for (std::size_t k = 0; k != m_indices.size(); ++k)
+                            sum += s[m_indices[k]] * m_values[k];
+                        dots[i] = sum;
+                    }
+                }
+
+                GaussianRbfExpansion const &m_expansion;
+                std::vector<std::size_t> const &m_indices;
+                std::vector<double> const &m_values;
+            };
+
+
+            /// \brief inner products of the sparse support vectors with a query scattered into a dense vector
+            struct ScatteredDots {
+                ScatteredDots (GaussianRbfExpansion const &expansion, double const* x) : m_expansion (expansion), m_x (x) {}
+
+                void operator() (std::size_t first, std::size_t count, double* dots) const {
+                    std::size_t const* columns = m_expansion.m_columns.empty() ? NULL : &m_expansion.m_columns[0];
+                    double const* values = m_expansion.m_values.empty() ? NULL : &m_expansion.m_values[0];
+
+                    for (std::size_t i = 0; i != count; ++i) {
+                        double sum = 0.0;
+                        for (std::size_t k = m_expansion.m_rowStart[first + i]; k != m_expansion.m_rowStart[first + i + 1]; ++k)
+                            sum += values[k] * m_x[columns[k]];
+                        dots[i] = sum;
+                    }
+                }
+
+                GaussianRbfExpansion const &m_expansion;
+                double const* m_x;
+            };
+
+
+
+            /// \brief Decision values of an expansion without support vectors, e.g. a default
+            /// constructed one or a model before its first step: no outputs, or just the offset.
+            bool constant (RealVector &f) const {
+                if (m_size != 0)
+                    return false;
+
+                f = m_offset;
+                return true;
+            }
+
+
+            /// \brief the same for a batch of n points
+            bool constant (std::size_t n, RealMatrix &outputs) const {
+                if (m_size != 0)
+                    return false;
+
+                outputs = RealMatrix (n, m_outputs);
+                for (std::size_t p = 0; p != n; ++p)
+                    noalias (row (outputs, p)) = m_offset;
+                return true;
+            }
+
+
+
+            /// \brief f = b + sum_i alpha_i k(s_i, x), the inner products with x come from dots
+            template <class Dots>
+            void expansion (Dots const &dots, double norm, double* f) const {
+                for (std::size_t c = 0; c != m_outputs; ++c)
+                    f[c] = m_offset (c);
+
+                double kernel[Block];
+                for (std::size_t first = 0; first < m_size; first += Block) {
+                    std::size_t count = std::min<std::size_t> (Block, m_size - first);
+                    dots (first, count, kernel);
+                    kernelValues (norm, first, count, kernel);
+                    accumulate (kernel, first, count, f);
+                }
+            }
+
+
+
+            /// \brief decision values of a sparse point, visiting only its stored entries
+            template <class Vector>
+            void evalSparse (Vector const &x, double* f) const {
+                // entries beyond the dimension of the model only add to the norm
+                std::vector<std::size_t> indices;
+                std::vector<double> values;
+                double norm = 0.0;
+                for (typename Vector::const_iterator it = x.begin(); it != x.end(); ++it) {
+                    norm += *it * *it;
+                    if ((*it != 0.0) && (it.index() < m_dimension)) {
+                        indices.push_back (it.index());
+                        values.push_back (*it);
+                    }
+                }
+
+                if (!m_sparse) {
+                    expansion (GatherDots (*this, indices, values), norm, f);
+                    return;
+                }
+
+                std::vector<double> scattered (std::max<std::size_t> (m_dimension, 1), 0.0);
+                for (std::size_t k = 0; k != indices.size(); ++k)
+                    scattered[indices[k]] = values[k];
+                expansion (ScatteredDots (*this, &scattered[0]), norm, f);
+            }
+
+
+
+            /// \brief copy coefficients and offset
+            void setCoefficients (RealMatrix const &alpha, RealVector const &offset) {
+                m_alpha.assign (m_size * m_outputs, 0.0);
+                for (std::size_t i = 0; i != m_size; ++i) {
+                    for (std::size_t c = 0; c != m_outputs; ++c)
+                        m_alpha[i * m_outputs + c] = alpha (i, c);
+                }
+
+                m_offset = RealVector (m_outputs, 0.0);
+                if (offset.size() == m_outputs)
+                    m_offset = offset;
+            }
+
+
+
+            /// \brief turn the inner products of support vectors first .. first+count-1 with x into kernel values
+            void kernelValues (double norm, std::size_t first, std::size_t count, double* kernel) const {
+                // rounding can make the distance slightly negative
+                for (std::size_t i = 0; i != count; ++i) {
+                    double distance = m_norms[first + i] + norm - 2.0 * kernel[i];
+                    kernel[i] = -m_gamma * std::max (distance, 0.0);
+                }
+
+                detail::RbfKernels::expNonPositive (kernel, count);
+            }
+
+
+
+            /// \brief f += alpha^T k for a block of support vectors
+            void accumulate (double const* kernel, std::size_t first, std::size_t count, double* f) const {
+                double const* alpha = &m_alpha[first * m_outputs];
+
+                if (m_outputs == 1) {
+                    double sum = 0.0;
+                    for (std::size_t i = 0; i != count; ++i)
+                        sum += alpha[i] * kernel[i];
+                    f[0] += sum;
+                    return;
+                }
+
+                for (std::size_t i = 0; i != count; ++i) {
+                    for (std::size_t c = 0; c != m_outputs; ++c)
+                        f[c] += alpha[i * m_outputs + c] * kernel[i];
+                }
+            }
+
+
+
+            double m_gamma;
+
+            /// whether the support vectors are kept as sparse rows
+            bool m_sparse;
+
+            std::size_t m_dimension;
+
+            /// row length of m_points, a multiple of the padding
+            std::size_t m_stride;
+
+            std::size_t m_size;
+
+            std::size_t m_outputs;
+
+            /// support vectors as padded rows, and their squared norms
+            AlignedVector m_points;
+            std::vector<double> m_norms;
+
+            /// sparse support vectors, row i has the entries m_rowStart[i] .. m_rowStart[i+1]-1
+            std::vector<std::size_t> m_rowStart;
+            std::vector<std::size_t> m_columns;
+            std::vector<double> m_values;
+
+            /// coefficients, m_outputs per support vector
+            std::vector<double> m_alpha;
+
+            RealVector m_offset;
+    };
+
+}
+
+#endif
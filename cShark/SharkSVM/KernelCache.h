@@ -0,0 +1,250 @@
+//===========================================================================
+/*!
+ *
+ *
+ * \brief       Memory bounded cache of kernel values between support vectors and points
+ *
+ *
+ *
+ * \author      Aydin Demircioglu
+ * \date        2015
+ *
+ *
+ * \par Copyright 1995-2015 Shark Development Team
+ *
+ * <BR><HR>
+ * This file is part of Shark.
+ * <http://image.diku.dk/shark/>
+ *
+ * Shark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Shark.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+//===========================================================================
+
+#ifndef SHARKSVM_KERNELCACHE_H
+#define SHARKSVM_KERNELCACHE_H
+
+#include <algorithm>
+#include <limits>
+#include <list>
+#include <vector>
+
+#include <boost/unordered_map.hpp>
+
+
+namespace shark {
+
+
+    /// \brief Kernel values k(s, x_i) between support vectors s and points x_i.
+    ///
+    /// \par
+    /// Support vectors are known by an id, points by their index in the data.
+    /// Every support vector has one line holding its kernel values with all
+    /// points seen so far, entries not computed yet are NaN. Lines grow with
+    /// the largest point index asked for. The whole cache never holds more
+    /// than the given number of bytes; if a line does not fit, the lines
+    /// used least recently are evicted. Lines of support vectors that left
+    /// the model are never asked for again and so are evicted first.
+    ///
+    /// \par
+    /// CacheType float halves the memory of the cache, the kernel values
+    /// then have single precision.
+    ///
+    template <class CacheType = float>
+    class KernelCache {
+        public:
+
+            KernelCache() : m_capacity (0),
+                m_used (0),
+                m_hits (0),
+                m_misses (0),
+                m_evictions (0) {}
+
+
+
+            /// \brief Value k(s, x_index) of the support vector with the given id.
+            ///
+            /// \param  id          id of the support vector
+            /// \param  index       index of the point
+            /// \param  evaluate    computes the kernel value if it is not cached
+            ///
+            template <class Evaluate>
+            double value (std::size_t id, std::size_t index, Evaluate const &evaluate) {
+                CacheType* entry = find (id, index);
+
+                if ((entry != NULL) && (*entry == *entry)) {
+                    ++m_hits;
+                    return *entry;
+                }
+
+                ++m_misses;
+                double result = evaluate();
+                if (entry != NULL)
+                    *entry = static_cast<CacheType> (result);
+                return result;
+            }
+
+
+
+            /// \brief Set the size of the cache in bytes, 0 disables it.
+            void setSize (std::size_t bytes) {
+                m_capacity = bytes / sizeof (CacheType);
+                while (m_used > m_capacity)
+                    evict();
+            }
+
+
+            /// \brief size of the cache in bytes
+            std::size_t size() const {
+                return m_capacity * sizeof (CacheType);
+            }
+
+
+            /// \brief bytes used by the lines held right now
+            std::size_t usedSize() const {
+                return m_used * sizeof (CacheType);
+            }
+
+
+            /// \brief Drop all lines, e.g. when the kernel changed.
+            void clear() {
+                m_lines.clear();
+                m_order.clear();
+                m_used = 0;
+            }
+
+
+            /// \brief Forget the line of a support vector.
+            void remove (std::size_t id) {
+                typename LineMap::iterator line = m_lines.find (id);
+                if (line == m_lines.end())
+                    return;
+
+                m_used -= line->second.values.size();
+                m_order.erase (line->second.position);
+                m_lines.erase (line);
+            }
+
+
+            /// \brief number of kernel values found in the cache
+            std::size_t hits() const {
+                return m_hits;
+            }
+
+
+            /// \brief number of kernel values that had to be computed
+            std::size_t misses() const {
+                return m_misses;
+            }
+
+
+            /// \brief number of lines evicted to make room
+            std::size_t evictions() const {
+                return m_evictions;
+            }
+
+
+            /// \brief fraction of kernel values found in the cache
+            double hitRate() const {
+                std::size_t total = m_hits + m_misses;
+                return (total == 0) ? 0.0 : static_cast<double> (m_hits) / total;
+            }
+
+
+            /// \brief Start counting hits, misses and evictions anew.
+            void resetStatistics() {
+                m_hits = 0;
+                m_misses = 0;
+                m_evictions = 0;
+            }
+
+
+        private:
+
+            /// \brief the kernel values of one support vector and its place in the usage order
+            struct Line {
+                std::vector<CacheType> values;
+                std::list<std::size_t>::iterator position;
+            };
+
+            typedef boost::unordered_map<std::size_t, Line> LineMap;
+
+
+
+            /// \brief Entry for (id, index), the line is created or grown if needed.
+            /// \return NULL if the line cannot be held
+            CacheType* find (std::size_t id, std::size_t index) {
+                if (index >= m_capacity)
+                    return NULL;
+
+                typename LineMap::iterator line = m_lines.find (id);
+                if (line == m_lines.end()) {
+                    line = m_lines.insert (std::make_pair (id, Line())).first;
+                    m_order.push_front (id);
+                    line->second.position = m_order.begin();
+                } else if (line->second.position != m_order.begin()) {
+                    // most recently used lines are in front
+                    m_order.splice (m_order.begin(), m_order, line->second.position);
+                }
+
+                std::vector<CacheType> &values = line->second.values;
+                if (index >= values.size()) {
+                    // grow geometrically, points are often visited in random order
+                    std::size_t length = std::min (std::max (index + 1, 2 * values.size()), m_capacity);
+                    std::size_t added = length - values.size();
+
+                    while ((m_used + added > m_capacity) && (m_order.back() != id))
+                        evict();
+
+                    if (m_used + added > m_capacity)
+                        return NULL;
+
+                    values.resize (length, std::numeric_limits<CacheType>::quiet_NaN());
+                    m_used += added;
+                }
+
+                return &values[index];
+            }
+
+
+
+            /// \brief drop the least recently used line
+            void evict() {
+                std::size_t id = m_order.back();
+                typename LineMap::iterator line = m_lines.find (id);
+
+                m_used -= line->second.values.size();
+                m_lines.erase (line);
+                m_order.pop_back();
+                ++m_evictions;
+            }
+
+
+
+            /// size of the cache and the part in use, in entries
+            std::size_t m_capacity;
+            std::size_t m_used;
+
+            /// lines by support vector id, and the ids from most to least recently used
+            LineMap m_lines;
+            std::list<std::size_t> m_order;
+
+            std::size_t m_hits;
+            std::size_t m_misses;
+            std::size_t m_evictions;
+    };
+
+}
+
+#endif
@@ -0,0 +1,715 @@
+//===========================================================================
+/*!
+ *
+ *
+ * \brief       Dual coordinate descent training of linear SVMs, as in LIBLINEAR
+ *
+ *
+ *
+ * \author      Aydin Demircioglu
+ * \date        2015
+ *
+ *
+ * \par Copyright 1995-2015 Shark Development Team
+ *
+ * <BR><HR>
+ * This file is part of Shark.
+ * <http://image.diku.dk/shark/>
+ *
+ * Shark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Shark.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+//===========================================================================
+
+#ifndef SHARKSVM_LINEARDCDSOLVER_H
+#define SHARKSVM_LINEARDCDSOLVER_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+#include <boost/atomic.hpp>
+#include <boost/scoped_array.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+
+#include <shark/Data/Dataset.h>
+
+#include "SharkSVM.h"
+#include "ParallelFor.h"
+
+
+namespace shark {
+
+
+    /// \brief Linear SVM training by dual coordinate descent.
+    ///
+    /// \par
+    /// Solves the dual of
+    /// \f[
+    ///     \min_w \frac{1}{2} |w|^2 + C \sum_i \xi(w; x_i, y_i)
+    /// \f]
+    /// for the hinge loss (L1-loss SVM) or the squared hinge loss (L2-loss
+    /// SVM), one coordinate at a time, with the weight vector w = sum_i
+    /// a_i y_i x_i kept up to date (Hsieh, Chang, Lin, Keerthi and
+    /// Sundararajan, "A dual coordinate descent method for large-scale
+    /// linear SVM", ICML 2008; the solver of LIBLINEAR). A step costs the
+    /// number of non-zeros of its point, independent of the size of the data.
+    ///
+    /// \par
+    /// Every epoch visits the active points in a new random order. Points at
+    /// a bound whose gradient points out of the box by more than the largest
+    /// violation of the last epoch are shrunk, i.e. not visited again until
+    /// the active points are optimal; then all points are checked once more.
+    ///
+    /// \par
+    /// The points are copied once into compressed rows, so dense and sparse
+    /// data are trained alike and zeros cost nothing. As in LIBLINEAR, the
+    /// offset is a constant feature of value 1 and thus regularized like the
+    /// weights.
+    ///
+    /// \par
+    /// With more than one thread, the points are split into one contiguous
+    /// part per thread, every thread visits only the coefficients of its
+    /// part. By default all threads read and update the same weight vector
+    /// through relaxed atomic operations, without any lock (Hogwild, as
+    /// PASSCoDe-Atomic of Hsieh, Yu and Dhillon, "PASSCoDe: parallel
+    /// asynchronous stochastic dual co-ordinate descent", ICML 2015). A thread
+    /// may see the weights a little out of date, so the result depends on the
+    /// timing of the threads. It scales best if the points of different parts
+    /// share few features, and the offset, shared by all points, is a point
+    /// of contention. In deterministic mode, every thread instead collects the
+    /// updates of its part in a vector of its own during an epoch, and the
+    /// vectors are added to the weights at its end, in a fixed order; the
+    /// result only depends on the number of threads and the seed.
+    ///
+    /// \par
+    /// Labels must be 0 and 1, label 1 is the positive class.
+    ///
+    class LinearDcdSolver {
+        public:
+
+            /// \brief Constructor
+            ///
+            /// \param  C           regularization parameter, the weight of the losses
+            /// \param  loss        LossTypes::HINGE or LossTypes::SQUARED_HINGE
+            /// \param  offset      whether the model has an offset
+            ///
+            LinearDcdSolver (double C, unsigned int loss, bool offset) : m_C (C),
+                m_loss (loss),
+                m_offset (offset),
+                m_epsilon (0.1),
+                m_epochs (0),
+                m_shrinking (true),
+                m_threads (1),
+                m_deterministic (false),
+                m_seed (0),
+                m_iterations (0),
+                m_dimension (0) {
+                RANGE_CHECK (C > 0.0);
+                if ((loss != LossTypes::HINGE) && (loss != LossTypes::SQUARED_HINGE))
+                    throw SHARKSVMEXCEPTION ("Dual coordinate descent supports the hinge and the squared hinge loss only.");
+            }
+
+
+
+            /// \brief Tolerance of the largest violation of the optimality conditions, LIBLINEAR's default is 0.1.
+            void setEpsilon (double epsilon) {
+                RANGE_CHECK (epsilon > 0.0);
+                m_epsilon = epsilon;
+            }
+
+
+            /// \brief Maximal number of epochs, 0 for LIBLINEAR's 1000.
+            void setMaxEpochs (std::size_t epochs) {
+                m_epochs = epochs;
+            }
+
+
+            /// \brief Whether points at a bound are left out until the others are optimal.
+            void setShrinking (bool shrinking) {
+                m_shrinking = shrinking;
+            }
+
+
+            /// \brief Number of threads training at the same time, 0 for all cores.
+            void setNumberOfThreads (std::size_t threads) {
+                m_threads = threads;
+            }
+
+
+            /// \brief Whether the threads add up their updates at the end of every epoch, see above.
+            void setDeterministic (bool deterministic) {
+                m_deterministic = deterministic;
+            }
+
+
+            /// \brief Seed the generators of the visiting orders, the thread with number t uses seed + t.
+            void setSeed (unsigned int seed) {
+                m_seed = seed;
+            }
+
+
+            /// \brief number of epochs of the last training
+            std::size_t iterations() const {
+                return m_iterations;
+            }
+
+
+
+            /// \brief Train a model.
+            ///
+            /// \param  data        training points with labels 0 and 1, dense or sparse
+            /// \param  weights     the weight vector, as long as the points
+            /// \param  offset      the offset, 0 without one
+            /// \param  cancel      the training stops without a model as soon as this is true, may be NULL
+            /// \return false if the training was cancelled
+            ///
+            template <class InputType>
+            bool train (LabeledData<InputType, unsigned int> const &data, RealVector &weights, double &offset, boost::atomic<bool> const* cancel = NULL) {
+                setData (data);
+                if (m_y.empty())
+                    throw SHARKSVMEXCEPTION ("Cannot train on an empty dataset.");
+
+                m_alpha.assign (m_y.size(), 0.0);
+                m_w.assign (m_dimension, 0.0);
+                m_bias = 0.0;
+
+                if (!solve (cancel))
+                    return false;
+
+                writeModel (weights, offset);
+                return true;
+            }
+
+
+
+            /// \brief Whether there is data of an earlier training to continue on.
+            bool hasData() const {
+                return !m_y.empty();
+            }
+
+
+            /// \brief Whether the data of the earlier training are exactly these points and labels, so
+            /// warmStart() would continue on them. Compares every non-zero, the cost of one epoch.
+            template <class InputType>
+            bool hasData (LabeledData<InputType, unsigned int> const &data) const {
+                if (!hasData() || (data.numberOfElements() != m_y.size()))
+                    return false;
+
+                std::size_t i = 0;
+                std::size_t dimension = 0;
+                for (std::size_t b = 0; b != data.numberOfBatches(); ++b) {
+                    typename Batch<InputType>::type const &inputs = data.inputs().batch (b);
+                    UIntVector const &labels = data.labels().batch (b);
+                    for (std::size_t r = 0; r != inputs.size1(); ++r, ++i) {
+                        if ((labels (r) > 1) || (m_y[i] != ((labels (r) == 1) ? 1.0 : -1.0)))
+                            return false;
+                        if (!sameRow (row (inputs, r), i))
+                            return false;
+                    }
+                    dimension = std::max<std::size_t> (dimension, inputs.size2());
+                }
+                return dimension == m_dimension;
+            }
+
+
+            /// \brief Set C, the current coefficients, weights and offset are scaled by the ratio of the new and
+            /// the old C.
+            ///
+            /// \par
+            /// The scaled coefficients stay feasible for both losses, and for
+            /// a small change of C they are close to the new optimum (Chu, Ho,
+            /// Lin and Lin, "Warm start for parameter selection of linear
+            /// classifiers", KDD 2015).
+            void setC (double C) {
+                RANGE_CHECK (C > 0.0);
+                double ratio = C / m_C;
+                for (std::size_t i = 0; i != m_alpha.size(); ++i) {
+                    // coefficients at the bound of the hinge loss stay exactly there
+                    if ((m_loss == LossTypes::HINGE) && (m_alpha[i] >= m_C))
+                        m_alpha[i] = C;
+                    else
+                        m_alpha[i] *= ratio;
+                }
+                for (std::size_t j = 0; j != m_w.size(); ++j)
+                    m_w[j] *= ratio;
+                m_bias *= ratio;
+                m_C = C;
+            }
+
+
+            /// \brief Train again on the data of the last training, starting from its solution.
+            ///
+            /// \par
+            /// The solution is that of the last training, rescaled by setC(),
+            /// also if it was cancelled; the coefficients are always feasible.
+            /// If the data may have changed since, ask hasData(data) first.
+            ///
+            /// \param  weights     the weight vector, as long as the points
+            /// \param  offset      the offset, 0 without one
+            /// \param  cancel      the training stops without a model as soon as this is true, may be NULL
+            /// \return false if the training was cancelled
+            ///
+            bool warmStart (RealVector &weights, double &offset, boost::atomic<bool> const* cancel = NULL) {
+                if (!hasData())
+                    throw SHARKSVMEXCEPTION ("There is no earlier training to continue.");
+
+                if (!solve (cancel))
+                    return false;
+
+                writeModel (weights, offset);
+                return true;
+            }
+
+
+        private:
+
+            /// \brief copy the non-zeros of the points into compressed rows, labels to +1 / -1
+            template <class InputType>
+            void setData (LabeledData<InputType, unsigned int> const &data) {
+                m_rowStart.assign (1, 0);
+                m_columns.clear();
+                m_values.clear();
+                m_y.clear();
+                m_y.reserve (data.numberOfElements());
+                m_dimension = 0;
+
+                for (std::size_t b = 0; b != data.numberOfBatches(); ++b) {
+                    typename Batch<InputType>::type const &inputs = data.inputs().batch (b);
+                    UIntVector const &labels = data.labels().batch (b);
+                    for (std::size_t r = 0; r != inputs.size1(); ++r) {
+                        if (labels (r) > 1)
+                            throw SHARKSVMEXCEPTION ("Dual coordinate descent needs the binary labels 0 and 1.");
+
+                        appendRow (row (inputs, r));
+                        m_y.push_back ((labels (r) == 1) ? 1.0 : -1.0);
+                    }
+                    m_dimension = std::max<std::size_t> (m_dimension, inputs.size2());
+                }
+
+                std::size_t ell = m_y.size();
+                m_norms.assign (ell, m_offset ? 1.0 : 0.0);
+                for (std::size_t i = 0; i != ell; ++i) {
+                    for (std::size_t k = m_rowStart[i]; k != m_rowStart[i + 1]; ++k)
+                        m_norms[i] += m_values[k] * m_values[k];
+                }
+            }
+
+
+            /// \brief whether the non-zeros of a point are those of row i
+            template <class Row>
+            bool sameRow (Row const &x, std::size_t i) const {
+                std::size_t k = m_rowStart[i];
+                for (typename Row::const_iterator it = x.begin(); it != x.end(); ++it) {
+                    if (*it == 0.0)
+                        continue;
+
+                    if ((k == m_rowStart[i + 1]) || (m_columns[k] != it.index()) || (m_values[k] != *it))
+                        return false;
+                    ++k;
+                }
+                return k == m_rowStart[i + 1];
+            }
+
+
+            /// \brief append the non-zeros of a point as the next row, the iterators of sparse rows skip the zeros
+            template <class Row>
+            void appendRow (Row const &x) {
+                for (typename Row::const_iterator it = x.begin(); it != x.end(); ++it) {
+                    if (*it == 0.0)
+                        continue;
+
+                    m_columns.push_back (static_cast<unsigned int> (it.index()));
+                    m_values.push_back (*it);
+                }
+                m_rowStart.push_back (m_columns.size());
+            }
+
+
+
+            /// \brief the points of one thread and its state within an epoch
+            struct Part {
+                /// the points, the active ones first
+                std::vector<std::size_t> index;
+                std::size_t active;
+
+                /// generator of the visiting orders of the part, seeded by its number
+                boost::random::mt19937 rng;
+
+                /// largest and smallest projected gradient of the current epoch
+                double maxNew;
+                double minNew;
+
+                /// updates of the weights and the offset in this epoch, deterministic mode only
+                std::vector<double> delta;
+                double deltaBias;
+            };
+
+
+
+            /// \brief weights read and written directly, single thread only
+            struct PlainWeights {
+                PlainWeights (LinearDcdSolver &solver) : m_solver (solver) {}
+
+                double decision (std::size_t i) const {
+                    double sum = m_solver.m_bias;
+                    for (std::size_t k = m_solver.m_rowStart[i]; k != m_solver.m_rowStart[i + 1]; ++k)
+                        sum += m_solver.m_w[m_solver.m_columns[k]] * m_solver.m_values[k];
+                    return sum;
+                }
+
+                void add (std::size_t i, double d) {
+                    for (std::size_t k = m_solver.m_rowStart[i]; k != m_solver.m_rowStart[i + 1]; ++k)
+                        m_solver.m_w[m_solver.m_columns[k]] += d * m_solver.m_values[k];
+                    if (m_solver.m_offset)
+                        m_solver.m_bias += d;
+                }
+
+                double scale() const {
+                    return 1.0;
+                }
+
+                LinearDcdSolver &m_solver;
+            };
+
+
+            /// \brief weights shared by all threads without locks (Hogwild): every read and every
+            /// addition is atomic, but a thread may read weights other threads are about to change
+            struct SharedWeights {
+                SharedWeights (LinearDcdSolver &solver) : m_solver (solver) {}
+
+                double decision (std::size_t i) const {
+                    double sum = m_solver.m_sharedBias.load (boost::memory_order_relaxed);
+                    for (std::size_t k = m_solver.m_rowStart[i]; k != m_solver.m_rowStart[i + 1]; ++k)
+                        sum += m_solver.m_sharedW[m_solver.m_columns[k]].load (boost::memory_order_relaxed) * m_solver.m_values[k];
+                    return sum;
+                }
+
+                void add (std::size_t i, double d) {
+                    for (std::size_t k = m_solver.m_rowStart[i]; k != m_solver.m_rowStart[i + 1]; ++k)
+                        atomicAdd (m_solver.m_sharedW[m_solver.m_columns[k]], d * m_solver.m_values[k]);
+                    if (m_solver.m_offset)
+                        atomicAdd (m_solver.m_sharedBias, d);
+                }
+
+                double scale() const {
+                    return 1.0;
+                }
+
+                static void atomicAdd (boost::atomic<double> &target, double d) {
+                    double old = target.load (boost::memory_order_relaxed);
+                    while (!target.compare_exchange_weak (old, old + d, boost::memory_order_relaxed))
+                        ;
+                }
+
+                LinearDcdSolver &m_solver;
+            };
+
+
+            /// \brief the weights of the last reduction plus the updates of one part, scaled by the number
+            /// of parts (CoCoA+, Ma, Smith, Jaggi, Jordan, Richtarik and Takac, "Adding vs. averaging in
+            /// distributed primal-dual optimization", ICML 2015), so that adding up the updates of all
+            /// parts cannot overshoot
+            struct LocalWeights {
+                LocalWeights (LinearDcdSolver &solver, Part &part) : m_solver (solver), m_part (part) {}
+
+                double decision (std::size_t i) const {
+                    double sigma = scale();
+                    double sum = m_solver.m_bias + sigma * m_part.deltaBias;
+                    for (std::size_t k = m_solver.m_rowStart[i]; k != m_solver.m_rowStart[i + 1]; ++k) {
+                        unsigned int j = m_solver.m_columns[k];
+                        sum += (m_solver.m_w[j] + sigma * m_part.delta[j]) * m_solver.m_values[k];
+                    }
+                    return sum;
+                }
+
+                void add (std::size_t i, double d) {
+                    for (std::size_t k = m_solver.m_rowStart[i]; k != m_solver.m_rowStart[i + 1]; ++k)
+                        m_part.delta[m_solver.m_columns[k]] += d * m_solver.m_values[k];
+                    if (m_solver.m_offset)
+                        m_part.deltaBias += d;
+                }
+
+                double scale() const {
+                    return static_cast<double> (m_solver.m_parts.size());
+                }
+
+                LinearDcdSolver &m_solver;
+                Part &m_part;
+            };
+
+
+
+            /// \brief the coordinate descent itself, LIBLINEAR's solve_l2r_l1l2_svc, on parts of the points
+            bool solve (boost::atomic<bool> const* cancel) {
+                std::size_t ell = m_y.size();
+
+                // the hinge loss bounds the coefficients by C, the squared hinge loss adds 1/(2C) to the diagonal
+                m_upper = m_C;
+                m_diagonal = 0.0;
+                if (m_loss == LossTypes::SQUARED_HINGE) {
+                    m_upper = std::numeric_limits<double>::infinity();
+                    m_diagonal = 0.5 / m_C;
+                }
+
+                // every thread owns a contiguous range of the points and their coefficients
+                std::size_t parts = std::max<std::size_t> (std::min (resolveNumberOfThreads (m_threads), ell), 1);
+                m_parts.assign (parts, Part());
+                for (std::size_t p = 0; p != parts; ++p) {
+                    Part &part = m_parts[p];
+                    for (std::size_t i = ell * p / parts; i != ell * (p + 1) / parts; ++i)
+                        part.index.push_back (i);
+                    part.active = part.index.size();
+                    part.rng.seed (m_seed + static_cast<unsigned int> (p));
+                    if (m_deterministic && (parts > 1))
+                        part.delta.assign (m_dimension, 0.0);
+                    part.deltaBias = 0.0;
+                }
+
+                if (!m_deterministic && (parts > 1)) {
+                    m_sharedW.reset (new boost::atomic<double>[m_dimension]);
+                    for (std::size_t j = 0; j != m_dimension; ++j)
+                        m_sharedW[j].store (m_w[j], boost::memory_order_relaxed);
+                    m_sharedBias.store (m_bias, boost::memory_order_relaxed);
+                }
+
+                // violations of the last epoch, the thresholds for shrinking
+                m_maxOld = std::numeric_limits<double>::infinity();
+                m_minOld = -std::numeric_limits<double>::infinity();
+
+                // a cancelled training still leaves weights that belong to its coefficients, to start from later
+                bool cancelled = false;
+                std::size_t maxEpochs = (m_epochs == 0) ? 1000 : m_epochs;
+                for (m_iterations = 0; m_iterations != maxEpochs;) {
+                    if ((cancel != NULL) && cancel->load (boost::memory_order_relaxed)) {
+                        cancelled = true;
+                        break;
+                    }
+
+                    if (parts == 1) {
+                        PlainWeights weights (*this);
+                        sweep (m_parts[0], weights);
+                    } else if (m_deterministic) {
+                        parallelFor (parts, parts, LocalSweeps (*this));
+                        reduce();
+                    } else {
+                        parallelFor (parts, parts, SharedSweeps (*this));
+                    }
+
+                    double maxNew = -std::numeric_limits<double>::infinity();
+                    double minNew = std::numeric_limits<double>::infinity();
+                    bool shrunk = false;
+                    for (std::size_t p = 0; p != parts; ++p) {
+                        maxNew = std::max (maxNew, m_parts[p].maxNew);
+                        minNew = std::min (minNew, m_parts[p].minNew);
+                        shrunk = shrunk || (m_parts[p].active != m_parts[p].index.size());
+                    }
+
+                    ++m_iterations;
+
+                    if (maxNew - minNew <= m_epsilon) {
+                        // optimal on the active points, check all of them once more before stopping
+                        if (!shrunk)
+                            break;
+
+                        for (std::size_t p = 0; p != parts; ++p)
+                            m_parts[p].active = m_parts[p].index.size();
+                        m_maxOld = std::numeric_limits<double>::infinity();
+                        m_minOld = -std::numeric_limits<double>::infinity();
+                        continue;
+                    }
+
+                    m_maxOld = (maxNew > 0.0) ? maxNew : std::numeric_limits<double>::infinity();
+                    m_minOld = (minNew < 0.0) ? minNew : -std::numeric_limits<double>::infinity();
+                }
+
+                if (!m_deterministic && (parts > 1)) {
+                    for (std::size_t j = 0; j != m_dimension; ++j)
+                        m_w[j] = m_sharedW[j].load (boost::memory_order_relaxed);
+                    m_bias = m_sharedBias.load (boost::memory_order_relaxed);
+                    m_sharedW.reset();
+                }
+                m_parts.clear();
+
+                return !cancelled;
+            }
+
+
+
+            /// \brief one epoch over the active points of a part, in a new random order
+            template <class Weights>
+            void sweep (Part &part, Weights &weights) {
+                part.maxNew = -std::numeric_limits<double>::infinity();
+                part.minNew = std::numeric_limits<double>::infinity();
+
+                std::vector<std::size_t> &index = part.index;
+                for (std::size_t s = part.active; s > 1; --s) {
+                    boost::random::uniform_int_distribution<std::size_t> pick (0, s - 1);
+                    std::swap (index[s - 1], index[pick (part.rng)]);
+                }
+
+                double sigma = weights.scale();
+                for (std::size_t s = 0; s < part.active; ++s) {
+                    std::size_t i = index[s];
+                    double G = m_y[i] * weights.decision (i) - 1.0 + m_diagonal * m_alpha[i];
+
+                    // projected gradient, points at a bound pointing outwards are shrunk
+                    double PG = 0.0;
+                    if (m_alpha[i] == 0.0) {
+                        if (m_shrinking && (G > m_maxOld)) {
+                            --part.active;
+                            std::swap (index[s], index[part.active]);
+                            --s;
+                            continue;
+                        }
+                        if (G < 0.0)
+                            PG = G;
+                    } else if (m_alpha[i] == m_upper) {
+                        if (m_shrinking && (G < m_minOld)) {
+                            --part.active;
+                            std::swap (index[s], index[part.active]);
+                            --s;
+                            continue;
+                        }
+                        if (G > 0.0)
+                            PG = G;
+                    } else {
+                        PG = G;
+                    }
+
+                    part.maxNew = std::max (part.maxNew, PG);
+                    part.minNew = std::min (part.minNew, PG);
+
+                    if (std::abs (PG) > 1.0e-12) {
+                        double old = m_alpha[i];
+                        m_alpha[i] = std::min (std::max (old - G / (sigma * m_norms[i] + m_diagonal), 0.0), m_upper);
+                        weights.add (i, (m_alpha[i] - old) * m_y[i]);
+                    }
+                }
+            }
+
+
+            /// \brief epochs of the parts on the shared weights, run by parallelFor
+            struct SharedSweeps {
+                SharedSweeps (LinearDcdSolver &solver) : m_solver (solver) {}
+
+                void operator() (std::size_t thread, std::size_t begin, std::size_t end) const {
+                    SharedWeights weights (m_solver);
+                    for (std::size_t p = begin; p != end; ++p)
+                        m_solver.sweep (m_solver.m_parts[p], weights);
+                }
+
+                LinearDcdSolver &m_solver;
+            };
+
+
+            /// \brief epochs of the parts on their own updates, run by parallelFor
+            struct LocalSweeps {
+                LocalSweeps (LinearDcdSolver &solver) : m_solver (solver) {}
+
+                void operator() (std::size_t thread, std::size_t begin, std::size_t end) const {
+                    for (std::size_t p = begin; p != end; ++p) {
+                        Part &part = m_solver.m_parts[p];
+                        std::fill (part.delta.begin(), part.delta.end(), 0.0);
+                        part.deltaBias = 0.0;
+
+                        LocalWeights weights (m_solver, part);
+                        m_solver.sweep (part, weights);
+                    }
+                }
+
+                LinearDcdSolver &m_solver;
+            };
+
+
+            /// \brief add the updates of all parts to the weights, always in the same order
+            void reduce() {
+                parallelFor (m_dimension, m_threads, ReduceWeights (*this));
+                for (std::size_t p = 0; p != m_parts.size(); ++p)
+                    m_bias += m_parts[p].deltaBias;
+            }
+
+
+            /// \brief adds the updates of a range of the weights, run by parallelFor
+            struct ReduceWeights {
+                ReduceWeights (LinearDcdSolver &solver) : m_solver (solver) {}
+
+                void operator() (std::size_t thread, std::size_t begin, std::size_t end) const {
+                    for (std::size_t p = 0; p != m_solver.m_parts.size(); ++p) {
+                        double const* delta = &m_solver.m_parts[p].delta[0];
+                        for (std::size_t j = begin; j != end; ++j)
+                            m_solver.m_w[j] += delta[j];
+                    }
+                }
+
+                LinearDcdSolver &m_solver;
+            };
+
+
+
+            void writeModel (RealVector &weights, double &offset) const {
+                weights.resize (m_dimension);
+                std::copy (m_w.begin(), m_w.end(), weights.begin());
+                offset = m_bias;
+            }
+
+
+
+            double m_C;
+            unsigned int m_loss;
+            bool m_offset;
+            double m_epsilon;
+            std::size_t m_epochs;
+            bool m_shrinking;
+            std::size_t m_threads;
+            bool m_deterministic;
+            unsigned int m_seed;
+            std::size_t m_iterations;
+
+            /// points as compressed rows: row i has the entries m_rowStart[i] .. m_rowStart[i+1]-1
+            std::vector<std::size_t> m_rowStart;
+            std::vector<unsigned int> m_columns;
+            std::vector<double> m_values;
+            std::vector<double> m_y;
+            std::size_t m_dimension;
+
+            /// squared norms of the points, plus 1 for the offset
+            std::vector<double> m_norms;
+
+            /// bound of the coefficients and addition to the diagonal, depending on the loss
+            double m_upper;
+            double m_diagonal;
+
+            /// shrinking thresholds, the violations of the last epoch
+            double m_maxOld;
+            double m_minOld;
+
+            /// the points of every thread
+            std::vector<Part> m_parts;
+
+            /// dual variables, weights and offset of the current solution
+            std::vector<double> m_alpha;
+            std::vector<double> m_w;
+            double m_bias;
+
+            /// the weights and offset during a Hogwild training
+            boost::scoped_array<boost::atomic<double> > m_sharedW;
+            boost::atomic<double> m_sharedBias;
+    };
+
+}
+
+#endif
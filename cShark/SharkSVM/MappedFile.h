@@ -0,0 +1,178 @@
+//===========================================================================
+/*!
+ *
+ *
+ * \brief       Read-only memory mapping of regular files
+ *
+ *
+ *
+ * \author      Aydin Demircioglu
+ * \date        2015
+ *
+ *
+ * \par Copyright 1995-2015 Shark Development Team
+ *
+ * <BR><HR>
+ * This file is part of Shark.
+ * <http://image.diku.dk/shark/>
+ *
+ * Shark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Shark.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+//===========================================================================
+
+#ifndef SHARKSVM_MAPPEDFILE_H
+#define SHARKSVM_MAPPEDFILE_H
+
+#include <string>
+
+#include <boost/noncopyable.hpp>
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+
+namespace shark {
+
+
+    /// \brief Maps a whole regular file read-only into memory.
+    ///
+    /// \par
+    /// Only regular files can be mapped; for pipes, character devices like
+    /// stdin, or on platforms without mmap, open() returns false and the
+    /// caller is expected to fall back to stream based reading.
+    ///
+    class MappedFile : boost::noncopyable {
+        public:
+
+            MappedFile() : m_data (NULL), m_size (0), m_open (false) {}
+
+
+            virtual ~MappedFile() {
+                close();
+            }
+
+
+            /// \brief Map the given file.
+            ///
+            /// \param  fn          path of the file
+            /// \param  sequential  hint to the kernel that the file will be read front to back
+            /// \return true if the file is mapped (an empty file counts as mapped)
+            ///
+            bool open (std::string const &fn, bool sequential = true) {
+                close();
+
+#ifndef _WIN32
+                int fd = ::open (fn.c_str(), O_RDONLY);
+                if (fd < 0)
+                    return false;
+
+                struct stat info;
+                if ((fstat (fd, &info) != 0) || !S_ISREG (info.st_mode)) {
+                    ::close (fd);
+                    return false;
+                }
+
+                m_size = static_cast<std::size_t> (info.st_size);
+
+                if (m_size > 0) {
+                    void* address = mmap (NULL, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                    if (address == MAP_FAILED) {
+                        ::close (fd);
+                        m_size = 0;
+                        return false;
+                    }
+
+                    m_data = static_cast<const char*> (address);
+
+                    if (sequential)
+                        madvise (address, m_size, MADV_SEQUENTIAL);
+                }
+
+                // the mapping stays valid without the descriptor
+                ::close (fd);
+                m_open = true;
+                return true;
+#else
+                (void) fn;
+                (void) sequential;
+                return false;
+#endif
+            }
+
+
+            /// \brief Release the mapping.
+            void close() {
+#ifndef _WIN32
+                if (m_data != NULL)
+                    munmap (const_cast<char*> (m_data), m_size);
+#endif
+                m_data = NULL;
+                m_size = 0;
+                m_open = false;
+            }
+
+
+            /// \brief Drop the pages of a part that was read and is not needed again from memory.
+            /// they are read from the file again if the part is touched after all.
+            ///
+            /// \param  begin       start of the part, inside the mapping
+            /// \param  end         end of the part
+            ///
+            void release (const char* begin, const char* end) {
+#ifndef _WIN32
+                // only whole pages inside the part, the neighbours may still be read
+                std::size_t pageSize = static_cast<std::size_t> (sysconf (_SC_PAGESIZE));
+                std::size_t first = ((begin - m_data) + pageSize - 1) / pageSize * pageSize;
+                std::size_t last = (end - m_data) / pageSize * pageSize;
+                if (last > first)
+                    madvise (const_cast<char*> (m_data) + first, last - first, MADV_DONTNEED);
+#else
+                (void) begin;
+                (void) end;
+#endif
+            }
+
+
+            bool isOpen() const {
+                return m_open;
+            }
+
+
+            const char* data() const {
+                return m_data;
+            }
+
+
+            std::size_t size() const {
+                return m_size;
+            }
+
+
+        private:
+
+            const char* m_data;
+
+            std::size_t m_size;
+
+            bool m_open;
+    };
+
+}
+
+#endif
@@ -0,0 +1,151 @@
+//===========================================================================
+/*!
+ *
+ *
+ * \brief       Lock-free publication of models from one writer to many readers
+ *
+ *
+ *
+ * \author      Aydin Demircioglu
+ * \date        2015
+ *
+ *
+ * \par Copyright 1995-2015 Shark Development Team
+ *
+ * <BR><HR>
+ * This file is part of Shark.
+ * <http://image.diku.dk/shark/>
+ *
+ * Shark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Shark.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+//===========================================================================
+
+#ifndef SHARKSVM_MODELPUBLISHER_H
+#define SHARKSVM_MODELPUBLISHER_H
+
+#include <boost/atomic.hpp>
+#include <boost/noncopyable.hpp>
+
+
+namespace shark {
+
+
+    /// \brief Double buffer through which one writer hands models to readers on other threads.
+    ///
+    /// \par
+    /// The writer fills the buffer that is not published (back) and makes it
+    /// the published one with a single atomic store (publish). Readers pin the
+    /// published buffer for as long as a Reader object exists, so they always
+    /// see a complete model and never wait for the writer. If a reader still
+    /// pins the back buffer, back() returns NULL and the writer tries again
+    /// later, so the writer never waits for the readers either.
+    ///
+    /// \par
+    /// There must be only one writer at a time, any number of readers.
+    /// Readers should keep a Reader only as long as they use the model:
+    /// while they pin an older model, no new one can be published.
+    ///
+    template <class Model>
+    class ModelPublisher : boost::noncopyable {
+        public:
+
+            ModelPublisher() : m_published (0),
+                m_publications (0) {
+                m_readers[0] = 0;
+                m_readers[1] = 0;
+            }
+
+
+
+            /// \brief Read access to the model published last.
+            class Reader : boost::noncopyable {
+                public:
+
+                    explicit Reader (ModelPublisher const &publisher) : m_publisher (publisher) {
+                        // pin a buffer, then make sure the writer did not move on meanwhile,
+                        // this only repeats if a new model was published right in between
+                        for (;;) {
+                            m_buffer = publisher.m_published.load();
+                            publisher.m_readers[m_buffer].fetch_add (1);
+                            if (publisher.m_published.load() == m_buffer)
+                                break;
+                            publisher.m_readers[m_buffer].fetch_sub (1);
+                        }
+                    }
+
+
+                    ~Reader() {
+                        m_publisher.m_readers[m_buffer].fetch_sub (1);
+                    }
+
+
+                    Model const& operator*() const {
+                        return m_publisher.m_models[m_buffer];
+                    }
+
+                    Model const* operator->() const {
+                        return &m_publisher.m_models[m_buffer];
+                    }
+
+
+                private:
+
+                    ModelPublisher const &m_publisher;
+                    unsigned int m_buffer;
+            };
+
+
+
+            /// \brief The buffer to write the next model to, or NULL if a reader still pins it.
+            Model* back() {
+                // only the writer changes which buffer is published
+                unsigned int buffer = 1 - m_published.load (boost::memory_order_relaxed);
+                if (m_readers[buffer].load() != 0)
+                    return NULL;
+                return &m_models[buffer];
+            }
+
+
+
+            /// \brief Make the model written to back() the published one.
+            void publish() {
+                m_published.store (1 - m_published.load (boost::memory_order_relaxed));
+                m_publications.fetch_add (1, boost::memory_order_relaxed);
+            }
+
+
+
+            /// \brief number of models published so far
+            std::size_t publications() const {
+                return m_publications.load (boost::memory_order_relaxed);
+            }
+
+
+        private:
+
+            Model m_models[2];
+
+            /// index of the published buffer
+            boost::atomic<unsigned int> m_published;
+
+            /// number of readers pinning each buffer
+            mutable boost::atomic<unsigned int> m_readers[2];
+
+            boost::atomic<std::size_t> m_publications;
+    };
+
+}
+
+#endif
@@ -0,0 +1,117 @@
+//===========================================================================
+/*!
+ *
+ *
+ * \brief       Minimal helper to split a loop over several threads
+ *
+ *
+ *
+ * \author      Aydin Demircioglu
+ * \date        2015
+ *
+ *
+ * \par Copyright 1995-2015 Shark Development Team
+ *
+ * <BR><HR>
+ * This file is part of Shark.
+ * <http://image.diku.dk/shark/>
+ *
+ * Shark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Shark.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+//===========================================================================
+
+#ifndef SHARKSVM_PARALLELFOR_H
+#define SHARKSVM_PARALLELFOR_H
+
+#include <algorithm>
+#include <exception>
+#include <vector>
+
+#include <boost/bind.hpp>
+#include <boost/thread.hpp>
+
+
+namespace shark {
+
+
+    /// \brief Resolve a requested number of threads, 0 meaning all cores.
+    ///
+    inline std::size_t resolveNumberOfThreads (std::size_t requested) {
+        if (requested != 0)
+            return requested;
+
+        std::size_t cores = boost::thread::hardware_concurrency();
+        return (cores == 0) ? 1 : cores;
+    }
+
+
+
+    namespace detail {
+
+        template <class Function>
+        void runParallelRange (Function f, std::size_t thread, std::size_t begin, std::size_t end, std::exception_ptr *error) {
+            try {
+                f (thread, begin, end);
+            } catch (...) {
+                *error = std::current_exception();
+            }
+        }
+
+    }
+
+
+
+    /// \brief Split [0, n) into contiguous ranges and process them in parallel.
+    ///
+    /// \par
+    /// f is called as f(thread, begin, end) for every non-empty range, thread
+    /// being the index of the range. The call blocks until all ranges are
+    /// done; the first exception thrown by any range is rethrown afterwards.
+    /// With a single thread, everything runs in the calling thread.
+    ///
+    /// \param  n           number of items
+    /// \param  numThreads  number of threads, 0 for all cores
+    /// \param  f           functor processing one range
+    ///
+    template <class Function>
+    void parallelFor (std::size_t n, std::size_t numThreads, Function f) {
+        numThreads = std::min (resolveNumberOfThreads (numThreads), std::max<std::size_t> (n, 1));
+
+        if (numThreads <= 1) {
+            if (n > 0)
+                f (0, 0, n);
+            return;
+        }
+
+        std::vector<std::exception_ptr> errors (numThreads);
+        boost::thread_group threads;
+
+        for (std::size_t t = 0; t < numThreads; ++t) {
+            std::size_t begin = (n * t) / numThreads;
+            std::size_t end = (n * (t + 1)) / numThreads;
+            threads.create_thread (boost::bind (&detail::runParallelRange<Function>, f, t, begin, end, &errors[t]));
+        }
+
+        threads.join_all();
+
+        for (std::size_t t = 0; t < numThreads; ++t) {
+            if (errors[t])
+                std::rethrow_exception (errors[t]);
+        }
+    }
+
+}
+
+#endif
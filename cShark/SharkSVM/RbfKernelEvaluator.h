@@ -0,0 +1,194 @@
+//===========================================================================
+/*!
+ *
+ *
+ * \brief       Gaussian kernel values from inner products and cached norms
+ *
+ *
+ *
+ * \author      Aydin Demircioglu
+ * \date        2015
+ *
+ *
+ * \par Copyright 1995-2015 Shark Development Team
+ *
+ * <BR><HR>
+ * This file is part of Shark.
+ * <http://image.diku.dk/shark/>
+ *
+ * Shark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Shark.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+//===========================================================================
+
+#ifndef SHARKSVM_RBFKERNELEVALUATOR_H
+#define SHARKSVM_RBFKERNELEVALUATOR_H
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <shark/Models/Kernels/GaussianRbfKernel.h>
+
+
+namespace shark {
+
+
+    /// \brief Values exp(-gamma |s - x|^2) of a Gaussian kernel between many points s and one query x.
+    ///
+    /// \par
+    /// |s - x|^2 = |s|^2 + |x|^2 - 2 <s, x>, where the squared norms of the
+    /// points s are computed once by the caller (squaredNorm) and kept along
+    /// with them. The query is scattered into a dense buffer, so each inner
+    /// product only visits the stored entries of s: a kernel value costs
+    /// O(nnz(s)) for sparse points (CompressedRealVector) instead of O(d).
+    /// Scattering and clearing the query costs O(nnz(x)) per query.
+    ///
+    /// \par
+    /// Only Gaussian kernels are handled, enabled() tells whether the kernel
+    /// given to setKernel is one; otherwise the caller evaluates the kernel
+    /// as usual.
+    ///
+    template <class InputType>
+    class RbfKernelEvaluator {
+        public:
+
+            RbfKernelEvaluator() : m_kernel (NULL),
+                m_queryNorm (0.0) {}
+
+
+
+            /// \brief Use the given kernel, returns whether it is a Gaussian kernel.
+            bool setKernel (AbstractKernelFunction<InputType> const* kernel) {
+                m_kernel = dynamic_cast<GaussianRbfKernel<InputType> const*> (kernel);
+                return enabled();
+            }
+
+
+            /// \brief whether kernel values can be computed here
+            bool enabled() const {
+                return m_kernel != NULL;
+            }
+
+
+
+            /// \brief largest dimension of the points seen so far
+            std::size_t dimension() const {
+                return m_query.size();
+            }
+
+
+            /// \brief Prepare for points of up to the given dimension, e.g. for a copy used by another thread.
+            void reserve (std::size_t dimension) {
+                if (dimension > m_query.size())
+                    m_query.resize (dimension, 0.0);
+            }
+
+
+
+            /// \brief Squared norm of a point, to be kept along with it.
+            template <class Vector>
+            double squaredNorm (Vector const &s) {
+                // the buffer must cover every index of the points
+                if (s.size() > m_query.size())
+                    m_query.resize (s.size(), 0.0);
+
+                double norm = 0.0;
+                for (typename Vector::const_iterator it = s.begin(); it != s.end(); ++it)
+                    norm += *it * *it;
+                return norm;
+            }
+
+
+
+            /// \brief Make x the query of the following kernel values.
+            template <class Vector>
+            void setQuery (Vector const &x) {
+                clearQuery();
+
+                if (x.size() > m_query.size())
+                    m_query.resize (x.size(), 0.0);
+
+                m_queryNorm = 0.0;
+                for (typename Vector::const_iterator it = x.begin(); it != x.end(); ++it) {
+                    if (*it == 0.0)
+                        continue;
+
+                    m_query[it.index()] = *it;
+                    m_queryIndices.push_back (it.index());
+                    m_queryNorm += *it * *it;
+                }
+            }
+
+
+
+            /// \brief Kernel value between a point with the given squared norm and the query.
+            template <class Vector>
+            double operator() (Vector const &s, double norm) const {
+                double distance = norm + m_queryNorm - 2.0 * dot (s);
+
+                // rounding can make the distance slightly negative
+                return std::exp (-m_kernel->gamma() * std::max (distance, 0.0));
+            }
+
+
+        private:
+
+            /// \brief <s, x> of a dense point
+            double dot (RealVector const &s) const {
+                // the query is zero beyond the buffer, and an empty buffer has no &m_query[0]
+                std::size_t n = std::min (s.size(), m_query.size());
+                if (n == 0)
+                    return 0.0;
+
+                double const* query = &m_query[0];
+                double sum = 0.0;
+                for (std::size_t j = 0; j != n; ++j)
+                    sum += s (j) * query[j];
+                return sum;
+            }
+
+
+            /// \brief <s, x>, visiting the stored entries of s only
+            template <class Vector>
+            double dot (Vector const &s) const {
+                double sum = 0.0;
+                for (typename Vector::const_iterator it = s.begin(); it != s.end(); ++it)
+                    sum += *it * m_query[it.index()];
+                return sum;
+            }
+
+
+
+            /// \brief zero the entries set by the last query
+            void clearQuery() {
+                for (std::size_t k = 0; k != m_queryIndices.size(); ++k)
+                    m_query[m_queryIndices[k]] = 0.0;
+                m_queryIndices.clear();
+            }
+
+
+
+            GaussianRbfKernel<InputType> const* m_kernel;
+
+            /// the query scattered into a dense vector, and the indices of its non-zero entries
+            std::vector<double> m_query;
+            std::vector<std::size_t> m_queryIndices;
+
+            double m_queryNorm;
+    };
+
+}
+
+#endif
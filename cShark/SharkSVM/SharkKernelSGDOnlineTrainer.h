@@ -40,12 +40,19 @@
 
 #include <shark/Algorithms/Trainers/AbstractTrainer.h>
 #include <shark/Core/IParameterizable.h>
-#include <shark/LinAlg/KernelMatrix.h>
-#include <shark/LinAlg/PartlyPrecomputedMatrix.h>
 #include <shark/Models/Kernels/KernelExpansion.h>
 #include <shark/Models/Kernels/KernelHelpers.h>
 #include <shark/ObjectiveFunctions/Loss/AbstractLoss.h>
 
+#include "SharkSVM.h"
+#include "BudgetMaintenance.h"
+#include "KernelCache.h"
+#include "ParallelFor.h"
+#include "RbfKernelEvaluator.h"
+
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+
 
 using namespace shark;
 
@@ -54,6 +61,28 @@ namespace shark
 {
 
 
+namespace detail
+{
+	/// kernel evaluation without virtual dispatch if the type of the kernel is known
+	template <class KernelFunction>
+	struct KernelCall
+	{
+		template <class A, class B>
+		static double eval(KernelFunction const* kernel, A const& a, B const& b)
+		{ return kernel->KernelFunction::eval(a, b); }
+	};
+
+	/// any kernel, through its virtual eval
+	template <class InputType>
+	struct KernelCall< AbstractKernelFunction<InputType> >
+	{
+		template <class A, class B>
+		static double eval(AbstractKernelFunction<InputType> const* kernel, A const& a, B const& b)
+		{ return kernel->eval(a, b); }
+	};
+}
+
+
 ///
 /// \brief Generic stochastic gradient descent training for kernel-based models.
 ///
@@ -84,25 +113,80 @@ namespace shark
 /// scaling with factor (1 - 1/t) in constant time.
 ///
 /// \par
+/// Used online, oneStep() performs one Pegasos step with learning rate
+/// 1/(lambda t) on a single labeled point. With this learning rate the
+/// weight vector after t steps is exactly (1/t) times the sum of all
+/// coefficients added so far, so alphaScale is simply 1/t and the shrink
+/// costs nothing. A point is added to the expansion only if the loss
+/// subgradient at its prediction is non-zero. The offset is scaled and
+/// regularized the same way, as if the kernel had an additional constant 1,
+/// so the large first steps do not stick to it.
+///
+/// \par
+/// Labels run from 0 to numberOfClasses()-1. Two classes have a single
+/// decision value, more classes one decision value (weight vector w_j) per
+/// class, which needs a loss for that many outputs. All classes share the
+/// points of the expansion: every point stores one coefficient per class,
+/// so the kernel row of a step is computed once for all classes, and the
+/// predictions and updates are a single pass over the coefficients.
+///
+/// \par
+/// With a budget, the expansion never holds more than that many points;
+/// the excess is taken out after every step by one of the strategies of
+/// BudgetMaintenanceStrategy (see BudgetMaintenance), so the cost of a
+/// step stays constant on arbitrarily long streams.
+///
+/// \par
+/// If the index of a point in its dataset is passed along, the kernel
+/// values between it and the support vectors are kept in a cache of
+/// cacheSize bytes, so later sweeps over the same data mostly look them up.
+/// The cache is keyed by that index, so whoever hands out the indices must
+/// call setDataGeneration with a new value whenever an index may name
+/// another point than before (other data, another file, ...).
+///
+/// \par
+/// train() runs epochs over the data in a new random order every time. With
+/// a batch size b > 1 it takes one step per mini-batch of b points: the
+/// predictions (and so the subgradients) of the points are computed in
+/// parallel, then all b points enter the expansion with their coefficients
+/// divided by b. With b = 1 this is exactly the sequence of oneStep() calls.
+/// The kernel cache is only used with b = 1, its bookkeeping is not shared
+/// between threads.
+///
+/// \par
+/// Gaussian kernels are evaluated from inner products and the squared
+/// norms of the points, which are computed once per point of the expansion
+/// (see RbfKernelEvaluator). For sparse inputs a kernel value then costs
+/// O(nnz) instead of O(d).
+///
+/// \par
+/// KernelFunction may be a concrete kernel class, e.g. LinearKernel<InputType>,
+/// the kernel is then called without virtual dispatch in the inner loops. The
+/// default takes any kernel. The loss is evaluated once per step, through
+/// AbstractLoss.
+///
+/// \par
 /// NOTE: Being an SGD-based solver, this algorithm is relatively fast for
 /// differentiable loss functions such as the logistic loss (class CrossEntropy).
 /// It suffers from significantly slower convergence for non-differentiable
 /// losses, e.g., the hinge loss for SVM training.
 ///
-template <class InputType, class CacheType = float>
+template <class InputType, class CacheType = float, class KernelFunction = AbstractKernelFunction<InputType> >
 class KernelSGDOnlineTrainer : public AbstractTrainer< KernelClassifier<InputType> >, public IParameterizable
 {
 public:
 	typedef AbstractTrainer< KernelExpansion<InputType> > base_type;
-	typedef AbstractKernelFunction<InputType> KernelType;
+	typedef KernelFunction KernelType;
 	typedef KernelClassifier<InputType> ClassifierType;
 	typedef KernelExpansion<InputType> ModelType;
 	typedef AbstractLoss<unsigned int, RealVector> LossType;
 	typedef typename ConstProxyReference<typename Batch<InputType>::type const>::type ConstBatchInputReference;
+	typedef typename ConstProxyReference<InputType const>::type ConstInputReference;
 	typedef CacheType QpFloatType;
+	typedef KernelCache<QpFloatType> KernelCacheType;
 
-	typedef KernelMatrix<InputType, QpFloatType> KernelMatrixType;
-	typedef PartlyPrecomputedMatrix< KernelMatrixType > PartlyPrecomputedMatrixType;
+	/// index of a point that is not part of a dataset, its kernel values are not cached
+	static const std::size_t NoIndex = static_cast<std::size_t>(-1);
 
 
 	/// \brief Constructor
@@ -112,7 +196,7 @@ public:
 	/// \param  labmda               regularization parameter - always the 'true' value of lambda, even when unconstrained is set
 	/// \param  offset          whether to train with offset/bias parameter or not
 	/// \param  unconstrained   when a C-value is given via setParameter, should it be piped through the exp-function before using it in the solver?
-	/// \param  cacheSize       size of the cache
+	/// \param  cacheSize       size of the kernel cache in bytes, 0 disables it
 	KernelSGDOnlineTrainer(KernelType* kernel, const LossType* loss, double lambda, bool offset, bool unconstrained = false, size_t cacheSize = 0x4000000)
 		: m_kernel(kernel)
 		, m_loss(loss)
@@ -120,10 +204,22 @@ public:
 		, m_offset(offset)
 		, m_unconstrained(unconstrained)
 		, m_epochs(0)
+		, m_batchSize(1)
+		, m_threads(0)
 		, m_cacheSize(cacheSize)
+		, m_dataGeneration(0)
 		, m_iter(0)
-	{ 
-		double alphaScale = 1.0;
+		, m_nextId(0)
+		, m_normNextId(0)
+		, alphaScale(1.0)
+		, m_classes(2)
+		, m_outputs(1)
+		, m_bias(1, 0.0)
+		, m_prediction(1, 0.0)
+		, m_derivative(1, 0.0)
+	{
+		m_cache.setSize(m_cacheSize);
+		m_rbfKernel.setKernel(m_kernel);
 	}
 
 	
@@ -134,20 +230,298 @@ public:
 	
 
 	
-	void oneStep (RealVector v) {
-		// take the input
-		// update model
-		cedar::aux::LogSingleton::getInstance()->message( "Taking one step..", "SharkKernelSGDOnlineTrainer");
+	/// \brief Forget everything learned so far.
+	void reset()
+	{
+		m_basis.clear();
+		m_basisIds.clear();
+		m_nextId = 0;
+		m_alpha.clear();
+		m_bias.clear();
+		m_iter = 0;
+		alphaScale = 1.0;
+		m_cache.clear();
+		m_cache.resetStatistics();
+		m_budgetMaintenance.reset(m_kernel, budget(), budgetStrategy(), m_outputs, m_basis);
+		m_basisNorms.clear();
+		m_normIds.clear();
+		m_normNextId = 0;
 	}
 
 
-	void finializeModel () {
-		cedar::aux::LogSingleton::getInstance()->message("Finalizing model..", "SharkKernelSGDOnlineTrainer");
+	/// \brief Continue from a given model, as if it was the result of the given number of steps.
+	///
+	/// The points of the expansion are kept with their coefficients, but
+	/// evaluated with the kernel of this trainer, e.g. after a change of the
+	/// kernel or its bandwidth. The number of steps sets the learning rate of
+	/// the following steps. The model is taken within the budget right away.
+	///
+	/// \param  model       expansion with one output per decision value of this trainer
+	/// \param  iterations  number of steps that led to the model
+	void warmStart(ModelType const& model, std::size_t iterations)
+	{
+		if (model.outputSize() != m_outputs)
+			throw SHARKSVMEXCEPTION("The model has a different number of outputs.");
+
+		reset();
+		m_iter = std::max<std::size_t>(iterations, 1);
+		alphaScale = 1.0 / m_iter;
+
+		// the coefficients are stored unscaled
+		RealMatrix const& alpha = model.alpha();
+		std::size_t i = 0;
+		for (std::size_t b = 0; b != model.basis().numberOfBatches(); ++b) {
+			std::size_t rows = model.basis().batch(b).size1();
+			for (std::size_t r = 0; r != rows; ++r, ++i) {
+				m_basis.push_back(InputType(row(model.basis().batch(b), r)));
+				m_basisIds.push_back(m_nextId++);
+				for (std::size_t c = 0; c != m_outputs; ++c)
+					m_alpha.push_back(m_iter * alpha(i, c));
+			}
+		}
+
+		if (m_offset && model.hasOffset())
+			noalias(m_bias) = m_iter * model.offset();
+
+		m_budgetMaintenance.reset(m_kernel, budget(), budgetStrategy(), m_outputs, m_basis);
+		m_budgetMaintenance.maintain(m_basis, m_alpha, m_basisIds, m_nextId);
+		updateBasisNorms();
 	}
 
-	
+
+	/// \brief Decision value(s) of the current model for a point.
+	///
+	/// \param  x       the point
+	/// \param  f       the decision values, one per output
+	void decisionFunction(ConstInputReference x, RealVector& f)
+	{
+		computeKernelRow(x, NoIndex);
+		predictFromKernelRow(f);
+	}
+
+
+	/// \brief One Pegasos step on a single labeled point.
+	///
+	/// \param  x       the point
+	/// \param  y       its label, 0 .. numberOfClasses()-1
+	/// \param  index   index of the point in its dataset, used for caching, or NoIndex
+	/// \return the decision value(s) of the model before the step
+	RealVector const& oneStep(ConstInputReference x, unsigned int y, std::size_t index = NoIndex)
+	{
+		if (y >= m_classes)
+			throw SHARKSVMEXCEPTION("Label is out of range for the number of classes.");
+
+		// prediction of the current model
+		computeKernelRow(x, index);
+		predictFromKernelRow(m_prediction);
+
+		// subgradient of the loss at this prediction
+		m_derivative.clear();
+		m_loss->evalDerivative(y, m_prediction, m_derivative);
+
+		// t w_{t+1} = (t-1) w_t - g_t / lambda, so the coefficients just
+		// accumulate and the shrink by (1 - 1/t) is a new scale of 1/t
+		++m_iter;
+		alphaScale = 1.0 / m_iter;
+
+		// points with zero subgradient do not change the expansion
+		if (norm_inf(m_derivative) > 0.0) {
+			m_basis.push_back(InputType(x));
+			m_basisIds.push_back(m_nextId++);
+			for (std::size_t c = 0; c != m_outputs; ++c)
+				m_alpha.push_back(-m_derivative(c) / m_lambda);
+
+			m_budgetMaintenance.added(m_basis.back(), m_kernelRow);
+			m_budgetMaintenance.maintain(m_basis, m_alpha, m_basisIds, m_nextId);
+			updateBasisNorms();
+		}
+
+		// the offset accumulates like the coefficients, as if the kernel had an additional constant 1
+		if (m_offset)
+			noalias(m_bias) -= m_derivative / m_lambda;
+
+		return m_prediction;
+	}
+
+
+	/// \brief One Pegasos step on a mini-batch of labeled points.
+	///
+	/// The subgradients are computed in parallel for the current model, then
+	/// every point with a non-zero subgradient is added with its coefficients
+	/// divided by the size of the batch. For a single point this is oneStep()
+	/// without the kernel cache.
+	///
+	/// \param  points  the points
+	/// \param  labels  their labels, 0 .. numberOfClasses()-1
+	void miniBatchStep(std::vector<InputType> const& points, std::vector<unsigned int> const& labels)
+	{
+		SHARK_ASSERT(points.size() == labels.size());
+
+		std::size_t size = points.size();
+		if (size == 0)
+			return;
+
+		for (std::size_t j = 0; j != size; ++j) {
+			if (labels[j] >= m_classes)
+				throw SHARKSVMEXCEPTION("Label is out of range for the number of classes.");
+		}
+
+		// the evaluations of the current model are independent
+		std::size_t threads = std::min(resolveNumberOfThreads(m_threads), size);
+		if (m_workspaces.size() < threads)
+			m_workspaces.resize(threads);
+		for (std::size_t t = 0; t != threads; ++t) {
+			m_workspaces[t].rbfKernel.setKernel(m_kernel);
+			m_workspaces[t].rbfKernel.reserve(m_rbfKernel.dimension());
+		}
+
+		m_batchDerivatives.resize(size * m_outputs);
+		parallelFor(size, threads, BatchSubgradients(*this, points, labels));
+
+		++m_iter;
+		alphaScale = 1.0 / m_iter;
+
+		// add all points before maintaining the budget, so all subgradients belong to the same model
+		RealVector derivativeSum(m_outputs, 0.0);
+		for (std::size_t j = 0; j != size; ++j) {
+			double const* derivative = &m_batchDerivatives[j * m_outputs];
+
+			bool zero = true;
+			for (std::size_t c = 0; c != m_outputs; ++c) {
+				derivativeSum(c) += derivative[c];
+				if (derivative[c] != 0.0)
+					zero = false;
+			}
+			if (zero)
+				continue;
+
+			// only projection needs the kernel values with the points added before
+			if (budget() != 0 && budgetStrategy() == BudgetMaintenanceStrategy::PROJECT) {
+				updateBasisNorms();
+				computeKernelRow(points[j], NoIndex);
+			}
+
+			m_basis.push_back(points[j]);
+			m_basisIds.push_back(m_nextId++);
+			for (std::size_t c = 0; c != m_outputs; ++c)
+				m_alpha.push_back(-derivative[c] / (m_lambda * size));
+
+			m_budgetMaintenance.added(m_basis.back(), m_kernelRow);
+		}
+
+		m_budgetMaintenance.maintain(m_basis, m_alpha, m_basisIds, m_nextId);
+		updateBasisNorms();
+
+		if (m_offset)
+			noalias(m_bias) -= derivativeSum / (m_lambda * size);
+	}
+
+
+	/// \brief Write the current model into a classifier.
+	void finalizeModel(ClassifierType& classifier) const
+	{
+		ModelType& model = classifier.decisionFunction();
+		model.setStructure(m_kernel, createDataFromRange(m_basis), m_offset, m_outputs);
+
+		RealMatrix& alpha = model.alpha();
+		for (std::size_t i = 0; i != m_basis.size(); ++i) {
+			for (std::size_t c = 0; c != m_outputs; ++c)
+				alpha(i, c) = alphaScale * m_alpha[i * m_outputs + c];
+		}
+
+		if (m_offset)
+			noalias(model.offset()) = alphaScale * m_bias;
+	}
+
+
+	/// \brief Number of classes of the labels.
+	std::size_t numberOfClasses() const
+	{ return m_classes; }
+
+
+	/// \brief Set the number of classes, this forgets the current model.
+	/// Two classes have one decision value, more classes one per class.
+	void setNumberOfClasses(std::size_t classes)
+	{
+		RANGE_CHECK(classes >= 2);
+		m_classes = classes;
+		m_outputs = (classes == 2) ? 1 : classes;
+		m_bias = RealVector(m_outputs, 0.0);
+		m_prediction = RealVector(m_outputs, 0.0);
+		m_derivative = RealVector(m_outputs, 0.0);
+		reset();
+	}
+
+
+	/// \brief Number of points in the expansion.
+	std::size_t numberOfSupportVectors() const
+	{ return m_basis.size(); }
+
+
+	/// \brief Number of steps taken so far.
+	std::size_t iterations() const
+	{ return m_iter; }
+
+
+	/// \brief Train from scratch with epochs over the data in random order,
+	/// one step per point or per mini-batch (see setBatchSize).
 	void train(ClassifierType& classifier, const LabeledData<InputType, unsigned int>& dataset)
 	{
+		reset();
+
+		// positions (batch, row) of all points, the index of a point is its place in this list
+		std::vector<std::pair<std::size_t, std::size_t> > positions;
+		for (std::size_t b = 0; b != dataset.numberOfBatches(); ++b) {
+			std::size_t rows = dataset.labels().batch(b).size();
+			for (std::size_t r = 0; r != rows; ++r)
+				positions.push_back(std::make_pair(b, r));
+		}
+
+		std::size_t ell = positions.size();
+		if (ell == 0)
+			throw SHARKSVMEXCEPTION("Cannot train on an empty dataset.");
+
+		// the C of the equivalent C-SVM is 1 / (lambda ell)
+		std::size_t epochs = m_epochs;
+		if (epochs == 0)
+			epochs = std::max<std::size_t>(10, static_cast<std::size_t>(std::ceil(1.0 / (m_lambda * ell))));
+
+		std::vector<std::size_t> order(ell);
+		for (std::size_t i = 0; i != ell; ++i)
+			order[i] = i;
+
+		std::vector<InputType> points;
+		std::vector<unsigned int> labels;
+
+		for (std::size_t epoch = 0; epoch != epochs; ++epoch) {
+			// Fisher-Yates shuffle
+			for (std::size_t i = ell - 1; i > 0; --i) {
+				boost::random::uniform_int_distribution<std::size_t> pick(0, i);
+				std::swap(order[i], order[pick(m_rng)]);
+			}
+
+			for (std::size_t first = 0; first < ell; first += m_batchSize) {
+				std::size_t last = std::min(first + m_batchSize, ell);
+
+				if (m_batchSize == 1) {
+					std::size_t index = order[first];
+					oneStep(row(dataset.inputs().batch(positions[index].first), positions[index].second),
+						dataset.labels().batch(positions[index].first)(positions[index].second), index);
+					continue;
+				}
+
+				points.clear();
+				labels.clear();
+				for (std::size_t i = first; i != last; ++i) {
+					std::pair<std::size_t, std::size_t> const& position = positions[order[i]];
+					points.push_back(InputType(row(dataset.inputs().batch(position.first), position.second)));
+					labels.push_back(dataset.labels().batch(position.first)(position.second));
+				}
+				miniBatchStep(points, labels);
+			}
+		}
+
+		finalizeModel(classifier);
 	}
 
 
@@ -163,6 +537,83 @@ public:
 	{ m_epochs = value; }
 
 	
+	/// Return the number of points per step of train().
+	std::size_t batchSize() const
+	{ return m_batchSize; }
+
+	/// Set the number of points per step of train(), 1 for plain Pegasos.
+	void setBatchSize(std::size_t value)
+	{
+		RANGE_CHECK(value > 0);
+		m_batchSize = value;
+	}
+
+	/// Return the number of threads evaluating a mini-batch, 0 means all cores.
+	std::size_t numberOfThreads() const
+	{ return m_threads; }
+
+	/// Set the number of threads evaluating a mini-batch, 0 means all cores.
+	void setNumberOfThreads(std::size_t value)
+	{ m_threads = value; }
+
+	/// Seed the generator of the random orders of train().
+	void setSeed(unsigned int seed)
+	{ m_rng.seed(seed); }
+
+	/// Return the maximal number of points in the expansion, 0 means unlimited.
+	std::size_t budget() const
+	{ return m_budgetMaintenance.budget(); }
+
+	/// Return the budget maintenance strategy, one of BudgetMaintenanceStrategy.
+	unsigned int budgetStrategy() const
+	{ return m_budgetMaintenance.strategy(); }
+
+	/// Set the maximal number of points in the expansion (0 for unlimited)
+	/// and the strategy used to stay within it. A model that is already
+	/// larger is reduced right away.
+	void setBudget(std::size_t budget, unsigned int strategy = BudgetMaintenanceStrategy::REMOVE)
+	{
+		m_budgetMaintenance.reset(m_kernel, budget, strategy, m_outputs, m_basis);
+		m_budgetMaintenance.maintain(m_basis, m_alpha, m_basisIds, m_nextId);
+		updateBasisNorms();
+	}
+
+	/// Return the size of the kernel cache in bytes.
+	std::size_t cacheSize() const
+	{ return m_cacheSize; }
+
+	/// Set the size of the kernel cache in bytes, 0 disables it.
+	void setCacheSize(std::size_t bytes)
+	{
+		m_cacheSize = bytes;
+		m_cache.setSize(bytes);
+	}
+
+	/// the kernel cache, e.g. for its hit rate and number of evictions
+	KernelCacheType const& cache() const
+	{ return m_cache; }
+
+	/// \brief Generation of the data the indices given to oneStep refer to.
+	///
+	/// A new generation means the indices name other points now, so the
+	/// cached kernel values are dropped and the norms of the expansion are
+	/// computed anew. The model is kept.
+	void setDataGeneration(std::size_t generation)
+	{
+		if (generation == m_dataGeneration)
+			return;
+
+		m_dataGeneration = generation;
+		m_cache.clear();
+		m_normIds.clear();
+		m_normNextId = 0;
+		updateBasisNorms();
+	}
+
+	/// generation of the data the cached kernel values belong to
+	std::size_t dataGeneration() const
+	{ return m_dataGeneration; }
+
 	/// get the kernel function
 	KernelType* kernel()
 	{ return m_kernel; }
@@ -171,7 +622,17 @@ public:
 	{ return m_kernel; }
 	/// set the kernel function
 	void setKernel(KernelType* kernel)
-	{ m_kernel = kernel; }
+	{
+		m_kernel = kernel;
+		m_cache.clear();
+		m_budgetMaintenance.reset(m_kernel, budget(), budgetStrategy(), m_outputs, m_basis);
+
+		// all norms are computed anew
+		m_rbfKernel.setKernel(m_kernel);
+		m_normIds.clear();
+		m_normNextId = 0;
+		updateBasisNorms();
+	}
 
 	/// check whether the parameter C is represented as log(C), thus,
 	/// in a form suitable for unconstrained optimization, in the
@@ -184,9 +645,20 @@ public:
 	{ return m_lambda; }
 
 	/// set the value of the regularization parameter (must be positive)
+	///
+	/// The current model is kept and rescaled as if all steps so far had been
+	/// taken with the new value, the following steps use the learning rate
+	/// 1/(lambda t) of the new value.
 	void setLambda(double value)
 	{
 		RANGE_CHECK(value > 0.0);
+
+		// every coefficient and the offset are a sum of -g/lambda
+		double factor = m_lambda / value;
+		for (std::size_t i = 0; i != m_alpha.size(); ++i)
+			m_alpha[i] *= factor;
+		m_bias *= factor;
+
 		m_lambda = value;
 	}
 
@@ -194,6 +666,13 @@ public:
 	bool trainOffset() const
 	{ return m_offset; }
 
+	/// set whether the model should include an offset term, the offset starts at zero
+	void setTrainOffset(bool offset)
+	{
+		m_offset = offset;
+		m_bias.clear();
+	}
+
 	///\brief  Returns the vector of hyper-parameters.
 	RealVector parameterVector() const
 	{
@@ -211,8 +690,15 @@ public:
 	{
 		size_t kp = m_kernel->numberOfParameters();
 		SHARK_ASSERT(newParameters.size() == kp + 1);
-		init(newParameters) >> parameters(m_kernel), m_lambda;
-		if(m_unconstrained) m_lambda = exp(m_lambda);
+		double lambda;
+		init(newParameters) >> parameters(m_kernel), lambda;
+		if(m_unconstrained) lambda = exp(lambda);
+
+		// the model so far is rescaled to the new lambda like in setLambda
+		setLambda(lambda);
+
+		// the cached kernel values and the bandwidth of the fast RBF path belong to the old parameters
+		setKernel(m_kernel);
 	}
 
 	///\brief Returns the number of hyper-parameters.
@@ -228,13 +714,226 @@ protected:
 	bool m_offset;                            ///< should the resulting model have an offset term?
 	bool m_unconstrained;                     ///< should C be stored as log(C) as a parameter?
 	std::size_t m_epochs;                     ///< number of training epochs (sweeps over the data), or 0 for default = max(10, C)
+	std::size_t m_batchSize;                  ///< number of points per step of train()
+	std::size_t m_threads;                    ///< number of threads for a mini-batch, 0 for all cores
+
+	/// generator of the random orders of train()
+	boost::random::mt19937 m_rng;
 
 	// size of cache to use.
 	std::size_t m_cacheSize;
 
+	/// kernel values between support vectors and dataset points
+	KernelCacheType m_cache;
+
+	/// generation of the data the indices of the cache refer to, see setDataGeneration
+	std::size_t m_dataGeneration;
+
 	// current iteration number
 	std::size_t m_iter;
+
+	/// scale of all coefficients, the model is alphaScale * sum_i alpha_i k(x_i, .)
 	double alphaScale;
+
+	/// number of classes, and of decision values, 1 for binary problems
+	std::size_t m_classes;
+	std::size_t m_outputs;
+
+	/// points of the expansion and their unscaled coefficients, m_outputs per point
+	std::vector<InputType> m_basis;
+	std::vector<double> m_alpha;
+
+	/// ids of the points of the expansion, a point keeps its id as long as it is unchanged
+	std::vector<std::size_t> m_basisIds;
+	std::size_t m_nextId;
+
+	/// unscaled offset, one per output
+	RealVector m_bias;
+
+	/// keeps the expansion within the budget
+	BudgetMaintenance<InputType> m_budgetMaintenance;
+
+	/// Gaussian kernel values from the squared norms of the points of the expansion
+	RbfKernelEvaluator<InputType> m_rbfKernel;
+	std::vector<double> m_basisNorms;
+
+	/// ids of the points the norms belong to, norms of ids from m_normNextId on are not known yet
+	std::vector<std::size_t> m_normIds;
+	std::size_t m_normNextId;
+	std::vector<double> m_normBuffer;
+
+	/// buffers reused in every step
+	std::vector<double> m_kernelRow;
+	RealVector m_prediction;
+	RealVector m_derivative;
+
+	/// buffers of one thread evaluating a mini-batch
+	struct Workspace
+	{
+		RbfKernelEvaluator<InputType> rbfKernel;
+		std::vector<double> kernelRow;
+		RealVector prediction;
+		RealVector derivative;
+	};
+
+	std::vector<Workspace> m_workspaces;
+
+	/// subgradients of the points of a mini-batch, m_outputs per point
+	std::vector<double> m_batchDerivatives;
+
+
+	/// subgradients of a range of the points of a mini-batch, run by parallelFor
+	struct BatchSubgradients
+	{
+		BatchSubgradients(KernelSGDOnlineTrainer& trainer, std::vector<InputType> const& points, std::vector<unsigned int> const& labels)
+			: m_trainer(trainer), m_points(points), m_labels(labels)
+		{ }
+
+		void operator()(std::size_t thread, std::size_t begin, std::size_t end) const
+		{
+			Workspace& workspace = m_trainer.m_workspaces[thread];
+			for (std::size_t j = begin; j != end; ++j)
+				m_trainer.subgradient(workspace, m_points[j], m_labels[j], &m_trainer.m_batchDerivatives[j * m_trainer.m_outputs]);
+		}
+
+		KernelSGDOnlineTrainer& m_trainer;
+		std::vector<InputType> const& m_points;
+		std::vector<unsigned int> const& m_labels;
+	};
+
+
+	/// kernel value of one point of the expansion and x, evaluated on a cache miss
+	struct KernelEvaluation
+	{
+		KernelEvaluation(KernelSGDOnlineTrainer const& trainer, std::size_t i, ConstInputReference x)
+			: m_trainer(trainer), m_i(i), m_x(x)
+		{ }
+
+		double operator()() const
+		{ return m_trainer.kernelValue(m_i, m_x); }
+
+		KernelSGDOnlineTrainer const& m_trainer;
+		std::size_t m_i;
+		ConstInputReference m_x;
+	};
+
+
+	/// kernel value between point i of the expansion and the current query x
+	double kernelValue(std::size_t i, ConstInputReference x) const
+	{
+		if (m_rbfKernel.enabled())
+			return m_rbfKernel(m_basis[i], m_basisNorms[i]);
+		return detail::KernelCall<KernelType>::eval(m_kernel, m_basis[i], x);
+	}
+
+
+	/// kernel values between all points of the expansion and x
+	void computeKernelRow(ConstInputReference x, std::size_t index)
+	{
+		m_kernelRow.resize(m_basis.size());
+
+		if (m_rbfKernel.enabled())
+			m_rbfKernel.setQuery(x);
+
+		if (index == NoIndex || m_cacheSize == 0) {
+			for (std::size_t i = 0; i != m_basis.size(); ++i)
+				m_kernelRow[i] = kernelValue(i, x);
+			return;
+		}
+
+		for (std::size_t i = 0; i != m_basis.size(); ++i)
+			m_kernelRow[i] = m_cache.value(m_basisIds[i], index, KernelEvaluation(*this, i, x));
+	}
+
+
+	/// squared norms of the points of the expansion after it changed
+	void updateBasisNorms()
+	{
+		if (!m_rbfKernel.enabled())
+			return;
+
+		// the budget maintenance keeps the order of the remaining points
+		// and gives every new or changed point a new id
+		m_normBuffer.resize(m_basis.size());
+		std::size_t j = 0;
+		for (std::size_t i = 0; i != m_basis.size(); ++i) {
+			if (m_basisIds[i] >= m_normNextId) {
+				m_normBuffer[i] = m_rbfKernel.squaredNorm(m_basis[i]);
+				continue;
+			}
+
+			while (m_normIds[j] != m_basisIds[i])
+				++j;
+			m_normBuffer[i] = m_basisNorms[j];
+		}
+
+		m_basisNorms.swap(m_normBuffer);
+		m_normIds = m_basisIds;
+		m_normNextId = m_nextId;
+	}
+
+
+	/// loss subgradient at the prediction of the current model for x, only touches the workspace
+	void subgradient(Workspace& workspace, InputType const& x, unsigned int y, double* derivative) const
+	{
+		std::vector<double>& kernelRow = workspace.kernelRow;
+		kernelRow.resize(m_basis.size());
+
+		if (m_rbfKernel.enabled()) {
+			workspace.rbfKernel.setQuery(x);
+			for (std::size_t i = 0; i != m_basis.size(); ++i)
+				kernelRow[i] = workspace.rbfKernel(m_basis[i], m_basisNorms[i]);
+		} else {
+			for (std::size_t i = 0; i != m_basis.size(); ++i)
+				kernelRow[i] = detail::KernelCall<KernelType>::eval(m_kernel, m_basis[i], x);
+		}
+
+		predictFromKernelRow(kernelRow, workspace.prediction);
+
+		if (workspace.derivative.size() != m_outputs)
+			workspace.derivative = RealVector(m_outputs);
+		workspace.derivative.clear();
+		m_loss->evalDerivative(y, workspace.prediction, workspace.derivative);
+
+		for (std::size_t c = 0; c != m_outputs; ++c)
+			derivative[c] = workspace.derivative(c);
+	}
+
+
+	/// decision values from the kernel row
+	void predictFromKernelRow(RealVector& f) const
+	{
+		predictFromKernelRow(m_kernelRow, f);
+	}
+
+
+	/// decision values from a kernel row
+	void predictFromKernelRow(std::vector<double> const& kernelRow, RealVector& f) const
+	{
+		if (f.size() != m_outputs)
+			f = RealVector(m_outputs);
+		f.clear();
+
+		// the coefficients of a point are contiguous, one pass over them covers all classes
+		double* out = &f(0);
+		if (m_outputs == 1) {
+			double sum = 0.0;
+			for (std::size_t i = 0; i != kernelRow.size(); ++i)
+				sum += m_alpha[i] * kernelRow[i];
+			out[0] = sum;
+		} else {
+			for (std::size_t i = 0; i != kernelRow.size(); ++i) {
+				double const* alpha = &m_alpha[i * m_outputs];
+				double k = kernelRow[i];
+				for (std::size_t c = 0; c != m_outputs; ++c)
+					out[c] += alpha[c] * k;
+			}
+		}
+
+		if (m_offset)
+			noalias(f) += m_bias;
+		f *= alphaScale;
+	}
 };
 
 
@@ -118,6 +118,31 @@ namespace shark {
     };
 
 
+    ///! losses for the sgd solvers.
+    ///
+    class LossTypes {
+        public:
+            enum _LossTypes {
+                HINGE = 0,
+                SQUARED_HINGE = 1,
+                LOGISTIC = 2
+            };
+    };
+
+
+    ///! orders in which the points of a dataset are visited per epoch.
+    ///
+    class EpochModes {
+        public:
+            enum _EpochModes {
+                SEQUENTIAL = 0,
+                PERMUTATION = 1,
+                STRATIFIED = 2,
+                SHARDED = 3
+            };
+    };
+
+
     ///! strategies for budgeted sgd.
     ///
     class BudgetMaintenanceStrategy {
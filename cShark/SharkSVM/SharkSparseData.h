@@ -41,11 +41,15 @@
 #ifndef SHARKSVM_DATA_SPARSEDATA_H
 #define SHARKSVM_DATA_SPARSEDATA_H
 
+#include <algorithm>
+#include <cstring>
+#include <deque>
 #include <fstream>
 #include <limits>
+#include <string>
+#include <vector>
 
-#include <boost/spirit/include/qi.hpp>
-#include <boost/fusion/adapted/std_pair.hpp>
+#include <boost/thread/mutex.hpp>
 
 #include <shark/Core/IConfigurable.h>
 #include <shark/Core/INameable.h>
@@ -54,6 +58,11 @@
 
 #include "SharkSVM.h"
 #include "LabelOrder.h"
+#include "MappedFile.h"
+#include "ParallelFor.h"
+#include "SparseDataCache.h"
+#include "SparseDataParser.h"
+#include "SparseDataWriter.h"
 
 
 namespace shark {
@@ -62,6 +71,10 @@ namespace shark {
     /// \brief A class that handles import and export of Sparse Data (also called
     /// LibSVM format sometimes).
     ///
+    /// \par
+    /// InputType can be a dense (RealVector) or a sparse (CompressedRealVector)
+    /// vector type; the latter keeps only the non-zero entries in memory.
+    ///
     template <class InputType>
     class SparseDataModel : public INameable, IConfigurable, ISerializable {
         private:
@@ -70,7 +83,6 @@ namespace shark {
 
             typedef std::pair< unsigned int, size_t > LabelSortPair;
             typedef typename shark::LabeledData<InputType, unsigned int>::element_reference ElemRef;
-            typedef std::pair<int, std::vector<std::pair<std::size_t, double> > > LibSVMPoint;
 
 
             /// \brief  for sorting in decreasing order
@@ -80,7 +92,7 @@ namespace shark {
 
 
             /// \brief constructor
-            SparseDataModel()  {};
+            SparseDataModel() : m_numberOfThreads (0), m_useCache (false) {};
 
 
             /// \brief destructor
@@ -89,6 +101,8 @@ namespace shark {
 
 
             /// \brief Export data to sparse data (libSVM) format.
+            /// the lines are formatted block-wise in parallel (see setNumberOfThreads)
+            /// and written in order.
             ///
             /// \param  dataset     Container storing the  data
             /// \param  fn          Output file
@@ -108,9 +122,9 @@ namespace shark {
 
                 // shall we append only or overwrite?
                 if (append == true) {
-                    ofs.open (fn.c_str(), std::fstream::out | std::fstream::app);
+                    ofs.open (fn.c_str(), std::fstream::out | std::fstream::app | std::fstream::binary);
                 } else {
-                    ofs.open (fn.c_str());
+                    ofs.open (fn.c_str(), std::fstream::out | std::fstream::binary);
                 }
 
                 if (!ofs) {
@@ -125,32 +139,35 @@ namespace shark {
 
                 if (sortLabels) {
                     for (std::size_t i = 0; i < elements; i++)
-                        L.push_back (LabelSortPair (dataset.element (i).label, i));
+                        L.push_back (LabelSortPair (dataset.labels().element (i), i));
 
                     std::sort (L.begin(), L.end(), cmpLabelSortPair);
                 }
 
-                for (std::size_t ii = 0; ii < elements; ii++) {
-                    // apply mapping to sorted indices
-                    std::size_t i = 0;
+                // where the batches start, to find points without walking the dataset
+                std::vector<std::size_t> batchOffsets (1, 0);
+                for (std::size_t b = 0; b != dataset.numberOfBatches(); ++b)
+                    batchOffsets.push_back (batchOffsets.back() + dataset.labels().batch (b).size());
 
-                    if (sortLabels) i = L[ii].second;
-                    else i = ii;
+                // format one round of blocks in parallel, then write them in order
+                const std::size_t blockSize = 4096;
+                std::size_t numberOfThreads = resolveNumberOfThreads (m_numberOfThreads);
+                std::vector<std::string> blocks (numberOfThreads);
 
-                    // apply transformation to label and write it to file
-                    if (oneMinusOne) ofs << 2 * int (dataset.element (i).label) - 1 << " ";
-                    //libsvm file format documentation is scarce, but by convention the first class seems to be 1..
-                    else ofs << dataset.element (i).label + 1 << " ";
+                for (std::size_t start = 0; start < elements; start += numberOfThreads * blockSize) {
+                    std::size_t numberOfBlocks = std::min (numberOfThreads, (elements - start + blockSize - 1) / blockSize);
 
-                    // write input data to file
-                    for (std::size_t j = 0; j < dim; j++) {
-                        if (dense)
-                            ofs << " " << j + 1 << ":" << dataset.element (i).input (j);
-                        else if (dataset.element (i).input (j) != 0)
-                            ofs << " " << j + 1 << ":" << dataset.element (i).input (j);
-                    }
+                    parallelFor (numberOfBlocks, numberOfThreads,
+                                 FormatBlocks (dataset, L, batchOffsets, start, blockSize, dense, oneMinusOne, dim, blocks));
+
+                    for (std::size_t b = 0; b != numberOfBlocks; ++b)
+                        ofs.write (blocks[b].data(), blocks[b].size());
+                }
+
+                ofs.close();
 
-                    ofs << std::endl;
+                if (!ofs) {
+                    throw (SHARKSVMEXCEPTION ("Failed to write to file"));
                 }
             }
 
@@ -168,216 +185,491 @@ namespace shark {
             /// \param  dimensions  highest feature index, or 0 for auto-detection
             /// \param  batchSize     size of batch
             ///
-            LabeledData<RealVector, unsigned int> importData (
+            LabeledData<InputType, unsigned int> importData (
                 std::istream& stream,
                 LabelOrder &labelOrder,
                 bool normallizeLabels = true,
                 unsigned int dimensions = 0,
                 std::size_t batchSize = LabeledData<InputType, unsigned int>::DefaultBatchSize) {
-                //read contents of stream
-                std::vector<LibSVMPoint> contents = importSparseDataReader (stream);
-                std::size_t numPoints = contents.size();
+                // read contents of stream, one chunk per read buffer, so the chunks can
+                // be released one by one while the batches are filled
+                std::vector<SparseDataArena> chunks;
+                importSparseDataReader (stream, chunks);
+                return createDataset (chunks, labelOrder, normallizeLabels, dimensions, batchSize);
+            }
 
-                //find data dimension by getting the maximum index
-                std::size_t maxIndex = 0;
-                for (std::size_t i = 0; i != numPoints; ++i) {
-                    std::vector<std::pair<std::size_t, double> > const& inputs = contents[i].second;
 
-                    if (!inputs.empty())
-                        maxIndex = std::max (maxIndex, inputs.back().first);
-                }
 
+            /// \brief Import data from sparse data (libSVM) format.
+            ///
+            /// \param  dataset       container storing the loaded data
+            /// \param  fn      filename
+            /// \param  normalizeLabels     if true, the labels will be normalized,
+            ///                                                    if false, the labels will not be modified.
+            /// \param  dimensions  highest feature index, or 0 for auto-detection
+            /// \param  batchSize     size of batch
+            ///
+            LabeledData<InputType, unsigned int> importData (
+                std::string fn,
+                bool normallizeLabels = true,
+                unsigned int dimensions = 0,
+                std::size_t batchSize = LabeledData<InputType, unsigned int>::DefaultBatchSize) {
+                // create a dummy labelorder and forget it again
+                LabelOrder labelOrder;
+                return importData (fn, labelOrder, normallizeLabels, dimensions, batchSize);
+            }
 
-                // did we specify a dimension?
-                if (dimensions == 0) {
-                    // no, so we take what the max index/dimension we saw
-                    dimensions = maxIndex;
-                } else {
-                    // check if the given dimension matches
-                    if (maxIndex > dimensions)
-                        throw SHARKSVMEXCEPTION ("Number of dimensions supplied is smaller than actual index data");
-                }
 
 
-                //check labels for conformity
-                bool binaryLabels = false;
-                int minPositiveLabel = std::numeric_limits<int>::max();
-                {
-                    int maxPositiveLabel = -1;
-
-                    for (std::size_t i = 0; i != numPoints; ++i) {
-                        int label = contents[i].first;
-
-                        if (label < -1)
-                            throw SHARKSVMEXCEPTION ("Negative labels are only allowed for classes -1/1");
-                        else if (label == -1)
-                            binaryLabels = true;
-                        else if (label < minPositiveLabel)
-                            minPositiveLabel = label;
-                        else if (label > maxPositiveLabel)
-                            maxPositiveLabel = label;
-                    }
+            /// \brief Import data from sparse data (libSVM) format.
+            /// regular files are memory mapped, cut into chunks at line breaks
+            /// and parsed in parallel, everything else (pipes, stdin, ..) is
+            /// read through a stream. if the binary cache is enabled, a valid
+            /// cache is loaded instead of parsing, and a new one is written
+            /// after parsing.
+            ///
+            /// \param  dataset       container storing the loaded data
+            /// \param  fn      filename
+            /// \param  normalizeLabels     if true, the labels will be normalized,
+            ///                                                    if false, the labels will not be modified.
+            /// \param  dimensions  highest feature index, or 0 for auto-detection
+            /// \param  batchSize     size of batch
+            ///
+            LabeledData<InputType, unsigned int> importData (
+                std::string fn,
+                LabelOrder &labelOrder,
+                bool normallizeLabels = true,
+                unsigned int dimensions = 0,
+                std::size_t batchSize = LabeledData<InputType, unsigned int>::DefaultBatchSize) {
+                // first try the cache
+                SparseDataCache::Signature signature;
+                bool cacheable = m_useCache && SparseDataCache::signature (fn, signature);
+
+                if (cacheable == true) {
+                    MappedFile cacheFile;
+                    SparseDataStatistics statistics;
+                    std::vector<SparseDataRows> parts (1);
 
-                    if (binaryLabels && (minPositiveLabel == 0 ||  maxPositiveLabel > 1))
-                        throw SHARKSVMEXCEPTION ("Negative labels are only allowed for classes -1/1");
+                    if (SparseDataCache::load (fn, signature, cacheFile, statistics, parts[0]))
+                        return createDataset (parts, statistics, NULL, labelOrder, normallizeLabels, dimensions, batchSize);
                 }
 
-                // check for feature index zero (non-standard, but it happens)
-                bool haszero = false;
+                MappedFile mappedFile;
 
-                for (std::size_t i = 0; i < numPoints; i++) {
-                    std::vector<std::pair<std::size_t, double> > const& input = contents[i].second;
+                if (!mappedFile.open (fn)) {
+                    std::ifstream ifs (fn.c_str());
 
-                    if (input.empty()) continue;
+                    if (! ifs.good())
+                        throw SHARKSVMEXCEPTION ("Failed to open file for input");
 
-                    if (input[0].first == 0) {
-                        haszero = true;
-                        break;
-                    }
+                    return importData (ifs, labelOrder, normallizeLabels, dimensions, batchSize);
                 }
 
+                // small files are not worth the threads. large files get more chunks than
+                // threads, a chunk can only be released once all of its points are copied
+                const char* begin = mappedFile.data();
+                const char* end = begin + mappedFile.size();
+                std::size_t numberOfThreads = resolveNumberOfThreads (m_numberOfThreads);
+                std::size_t numberOfChunks = std::min (numberOfThreads, mappedFile.size() / (1024 * 1024));
+                numberOfChunks = std::max<std::size_t> (1, std::max (numberOfChunks, mappedFile.size() / ChunkBytes));
+
+                // cut at line breaks, so every chunk holds complete lines only
+                std::vector<const char*> boundaries (1, begin);
+                for (std::size_t c = 1; c < numberOfChunks; ++c) {
+                    const char* cut = std::max (begin + (mappedFile.size() * c) / numberOfChunks, boundaries.back());
+                    const char* lineBreak = static_cast<const char*> (std::memchr (cut, '\n', end - cut));
+                    boundaries.push_back ((lineBreak == NULL) ? end : lineBreak + 1);
+                }
+                boundaries.push_back (end);
 
-                // copy contents into a new dataset
-                // and one normalize labels on the fly
+                std::vector<SparseDataArena> chunks (numberOfChunks);
+                parallelFor (numberOfChunks, numberOfThreads, ParseChunks (mappedFile, boundaries, chunks));
+                mappedFile.close();
 
-                // array that tracks what we already encountered
-                std::vector<int> tmpLabelOrder;
+                if (cacheable == true)
+                    SparseDataCache::write (fn, signature, chunks);
 
-                // create dataset with the right structure
-                typename shark::LabeledData<InputType, unsigned int>::element_type blueprint (InputType (maxIndex + (haszero ? 1 : 0)), 0);
-                shark::LabeledData<InputType, unsigned int> data (numPoints, blueprint, batchSize);
+                return createDataset (chunks, labelOrder, normallizeLabels, dimensions, batchSize);
+            }
 
-                size_t delta = (haszero ? 0 : 1);
-                std::size_t i = 0;
-                BOOST_FOREACH (ElemRef element, data.elements()) {
-                    element.input.clear();
-                    int tmpLabel = contents[i].first;
-
-                    // do we know that label already?
-                    if (std::find (tmpLabelOrder.begin(), tmpLabelOrder.end(), tmpLabel) == tmpLabelOrder.end()) {
-                        // no, so we add it to the tmpLabelOrder
-                        tmpLabelOrder.push_back (tmpLabel);
+
+
+            /// \brief Set the number of threads used for importing and exporting files.
+            ///
+            /// \param  numberOfThreads     number of threads, 0 uses all cores
+            ///
+            void setNumberOfThreads (std::size_t numberOfThreads) {
+                m_numberOfThreads = numberOfThreads;
+            }
+
+
+            /// \brief Number of threads used for importing and exporting files, 0 means all cores.
+            std::size_t numberOfThreads() const {
+                return m_numberOfThreads;
+            }
+
+
+            /// \brief Enable the binary cache written next to imported files.
+            ///
+            /// \param  useCache    if true, files are loaded from and parsed into a cache
+            ///
+            void setUseCache (bool useCache) {
+                m_useCache = useCache;
+            }
+
+
+            /// \brief Is the binary cache used?
+            bool useCache() const {
+                return m_useCache;
+            }
+
+
+        private:
+
+            /// \brief Formats blocks of consecutive lines of an export.
+            struct FormatBlocks {
+                FormatBlocks (LabeledData<InputType, unsigned int> const &dataset,
+                              std::vector<LabelSortPair> const &order,
+                              std::vector<std::size_t> const &batchOffsets,
+                              std::size_t start,
+                              std::size_t blockSize,
+                              bool dense,
+                              bool oneMinusOne,
+                              std::size_t dim,
+                              std::vector<std::string> &blocks)
+                    : m_dataset (&dataset),
+                      m_order (&order),
+                      m_batchOffsets (&batchOffsets),
+                      m_start (start),
+                      m_blockSize (blockSize),
+                      m_dense (dense),
+                      m_oneMinusOne (oneMinusOne),
+                      m_dim (dim),
+                      m_blocks (&blocks) {}
+
+                void operator() (std::size_t, std::size_t begin, std::size_t end) const {
+                    std::size_t elements = m_dataset->numberOfElements();
+
+                    for (std::size_t block = begin; block != end; ++block) {
+                        std::string &out = (*m_blocks)[block];
+                        out.clear();
+
+                        std::size_t first = m_start + block * m_blockSize;
+                        std::size_t last = std::min (first + m_blockSize, elements);
+
+                        for (std::size_t ii = first; ii != last; ++ii) {
+                            // apply mapping to sorted indices
+                            std::size_t i = m_order->empty() ? ii : (*m_order)[ii].second;
+                            std::size_t b = std::upper_bound (m_batchOffsets->begin(), m_batchOffsets->end(), i) - m_batchOffsets->begin() - 1;
+                            std::size_t r = i - (*m_batchOffsets)[b];
+
+                            unsigned int label = m_dataset->labels().batch (b) (r);
+
+                            // apply transformation to label, libsvm file format documentation is scarce,
+                            // but by convention the first class seems to be 1..
+                            long long fileLabel = m_oneMinusOne ? 2 * (long long) label - 1 : (long long) label + 1;
+
+                            SparseDataWriter::formatLine (out, fileLabel, row (m_dataset->inputs().batch (b), r), m_dense, m_dim);
+                        }
                     }
+                }
 
-                    // now we can assume that the label is already in our ordering.
-                    // so we reverse-map the label
-                    std::vector<int>::iterator pos = std::find (tmpLabelOrder.begin(), tmpLabelOrder.end(), tmpLabel);
-                    unsigned int mappedLabel = pos - tmpLabelOrder.begin() ;
-
-                    // if we want to normalize the labels, we overwrite the default value
-                    element.label = tmpLabel;
-                    if (normallizeLabels == true)
-                        element.label = mappedLabel;
-                    
-                    // copy over the components of the current vector
-                    std::vector<std::pair<std::size_t, double> > const& inputs = contents[i].second;
-                    for (std::size_t j = 0; j != inputs.size(); ++j)
-                        element.input (inputs[j].first - delta) = inputs[j].second; 
-
-                    ++i;
+                LabeledData<InputType, unsigned int> const *m_dataset;
+                std::vector<LabelSortPair> const *m_order;
+                std::vector<std::size_t> const *m_batchOffsets;
+                std::size_t m_start;
+                std::size_t m_blockSize;
+                bool m_dense;
+                bool m_oneMinusOne;
+                std::size_t m_dim;
+                std::vector<std::string> *m_blocks;
+            };
+
+
+
+            /// \brief Parses the chunks between the given boundaries, the text of
+            /// a parsed chunk is dropped from memory right away.
+            struct ParseChunks {
+                ParseChunks (MappedFile &mappedFile, std::vector<const char*> const &boundaries, std::vector<SparseDataArena> &chunks)
+                    : m_mappedFile (&mappedFile), m_boundaries (&boundaries), m_chunks (&chunks) {}
+
+                void operator() (std::size_t, std::size_t begin, std::size_t end) const {
+                    for (std::size_t c = begin; c != end; ++c) {
+                        SparseDataParser::parse ((*m_boundaries)[c], (*m_boundaries)[c + 1], true, (*m_chunks)[c]);
+                        m_mappedFile->release ((*m_boundaries)[c], (*m_boundaries)[c + 1]);
+                    }
                 }
 
-                // TODO: sanity check for one-class?
+                MappedFile *m_mappedFile;
+                std::vector<const char*> const *m_boundaries;
+                std::vector<SparseDataArena> *m_chunks;
+            };
+
+
+
+            /// \brief Creates the batches of the dataset and copies the parsed points into them.
+            /// a batch is only allocated when it is filled, and if the parts are views
+            /// of parsed chunks, every chunk is released as soon as all of its points
+            /// are copied, so the parsed points and the dataset do not coexist in full.
+            struct FillBatches {
+                FillBatches (InputType const &blueprint,
+                             std::vector<SparseDataRows> const &parts,
+                             std::vector<SparseDataArena> *chunks,
+                             std::vector<std::size_t> const &chunkOffsets,
+                             std::vector<std::size_t> &remainingRows,
+                             boost::mutex &chunkMutex,
+                             std::vector<std::size_t> const &batchOffsets,
+                             SparseDataStatistics const &statistics,
+                             bool normalizeLabels,
+                             std::size_t delta,
+                             LabeledData<InputType, unsigned int> &data)
+                    : m_blueprint (&blueprint),
+                      m_parts (&parts),
+                      m_chunks (chunks),
+                      m_chunkOffsets (&chunkOffsets),
+                      m_remainingRows (&remainingRows),
+                      m_chunkMutex (&chunkMutex),
+                      m_batchOffsets (&batchOffsets),
+                      m_statistics (&statistics),
+                      m_normalizeLabels (normalizeLabels),
+                      m_delta (delta),
+                      m_data (&data) {}
+
+                void operator() (std::size_t, std::size_t begin, std::size_t end) const {
+                    for (std::size_t b = begin; b != end; ++b) {
+                        std::size_t batchSize = (*m_batchOffsets)[b + 1] - (*m_batchOffsets)[b];
+                        typename Batch<InputType>::type &inputs = m_data->inputs().batch (b);
+                        typename Batch<unsigned int>::type &labels = m_data->labels().batch (b);
+                        inputs = Batch<InputType>::createBatch (*m_blueprint, batchSize);
+                        labels = Batch<unsigned int>::createBatch (0, batchSize);
+                        inputs.clear();
+
+                        // find the chunk holding the first point of the batch
+                        std::size_t point = (*m_batchOffsets)[b];
+                        std::size_t c = std::upper_bound (m_chunkOffsets->begin(), m_chunkOffsets->end(), point) - m_chunkOffsets->begin() - 1;
+                        std::size_t copied = 0;
+
+                        for (std::size_t r = 0; r != inputs.size1(); ++r, ++point) {
+                            while (point >= (*m_chunkOffsets)[c + 1]) {
+                                consumed (c, copied);
+                                copied = 0;
+                                ++c;
+                            }
+
+                            SparseDataRows const &chunk = (*m_parts)[c];
+                            std::size_t i = point - (*m_chunkOffsets)[c];
+                            int tmpLabel = chunk.labels[i];
+
+                            // if we want to normalize the labels, we overwrite the default value
+                            labels (r) = tmpLabel;
+                            if (m_normalizeLabels == true)
+                                labels (r) = m_statistics->labelPosition (tmpLabel);
+
+                            // copy over the components of the current vector
+                            for (std::size_t j = chunk.rowPointers[i]; j != chunk.rowPointers[i + 1]; ++j)
+                                inputs (r, chunk.indices[j] - m_delta) = chunk.values[j];
+
+                            ++copied;
+                        }
+
+                        consumed (c, copied);
+                    }
+                }
 
-                if ((tmpLabelOrder.size() != 2) && (binaryLabels == true))
-                    throw SHARKSVMEXCEPTION ("Negative label indicated binary data, but found more than two labels.");
-                
+                /// release the chunk once the last of its points was copied
+                void consumed (std::size_t c, std::size_t rows) const {
+                    if ((rows == 0) || (m_chunks == NULL))
+                        return;
 
-                // finally add our new found labels to the ordering we were given
-                labelOrder.setLabelOrder (tmpLabelOrder);
+                    boost::mutex::scoped_lock lock (*m_chunkMutex);
+                    (*m_remainingRows)[c] -= rows;
+                    if ((*m_remainingRows)[c] == 0)
+                        (*m_chunks)[c].release();
+                }
 
-                return (data);
-            }
+                InputType const *m_blueprint;
+                std::vector<SparseDataRows> const *m_parts;
+                std::vector<SparseDataArena> *m_chunks;
+                std::vector<std::size_t> const *m_chunkOffsets;
+                std::vector<std::size_t> *m_remainingRows;
+                boost::mutex *m_chunkMutex;
+                std::vector<std::size_t> const *m_batchOffsets;
+                SparseDataStatistics const *m_statistics;
+                bool m_normalizeLabels;
+                std::size_t m_delta;
+                LabeledData<InputType, unsigned int> *m_data;
+            };
 
 
 
-            /// \brief Import data from sparse data (libSVM) format.
+            /// \brief Create the dataset from the parsed chunks.
+            /// the statistics gathered while parsing are merged in file order,
+            /// the chunks are emptied on the way.
             ///
-            /// \param  dataset       container storing the loaded data
-            /// \param  fn      filename
+            /// \param  chunks      the parsed points, in file order
+            /// \param  labelOrder      the label order extracted from the data
             /// \param  normalizeLabels     if true, the labels will be normalized,
             ///                                                    if false, the labels will not be modified.
             /// \param  dimensions  highest feature index, or 0 for auto-detection
             /// \param  batchSize     size of batch
             ///
-            LabeledData<RealVector, unsigned int> importData (
-                std::string fn,
-                bool normallizeLabels = true,
-                unsigned int dimensions = 0,
-                std::size_t batchSize = LabeledData<InputType, unsigned int>::DefaultBatchSize) {
-                std::ifstream ifs (fn.c_str());
-
-                if (! ifs.good())
-                    throw SHARKSVMEXCEPTION ("Failed to open file for input");
+            LabeledData<InputType, unsigned int> createDataset (
+                std::vector<SparseDataArena> &chunks,
+                LabelOrder &labelOrder,
+                bool normallizeLabels,
+                unsigned int dimensions,
+                std::size_t batchSize) {
+                // merge the statistics of the chunks
+                SparseDataStatistics statistics;
+                std::vector<SparseDataRows> parts;
+                for (std::size_t c = 0; c != chunks.size(); ++c) {
+                    statistics.merge (chunks[c].statistics);
+                    parts.push_back (SparseDataRows (chunks[c]));
+                }
 
-                // create a dummy labelorder and forget it again
-                LabelOrder labelOrder;
-                return importData (ifs, labelOrder, normallizeLabels, dimensions, batchSize);
+                return createDataset (parts, statistics, &chunks, labelOrder, normallizeLabels, dimensions, batchSize);
             }
 
 
 
-            /// \brief Import data from sparse data (libSVM) format.
+            /// \brief Create the dataset from rows in CSR form.
+            /// the batches are filled in parallel.
             ///
-            /// \param  dataset       container storing the loaded data
-            /// \param  fn      filename
+            /// \param  parts       the points, in file order
+            /// \param  statistics  the merged statistics of all parts
+            /// \param  chunks      chunks the parts are views of, they are released
+            ///                     once copied; NULL if the parts are owned elsewhere
+            /// \param  labelOrder      the label order extracted from the data
             /// \param  normalizeLabels     if true, the labels will be normalized,
             ///                                                    if false, the labels will not be modified.
             /// \param  dimensions  highest feature index, or 0 for auto-detection
             /// \param  batchSize     size of batch
             ///
-            LabeledData<RealVector, unsigned int> importData (
-                std::string fn,
+            LabeledData<InputType, unsigned int> createDataset (
+                std::vector<SparseDataRows> const &parts,
+                SparseDataStatistics const &statistics,
+                std::vector<SparseDataArena> *chunks,
                 LabelOrder &labelOrder,
-                bool normallizeLabels = true,
-                unsigned int dimensions = 0,
-                std::size_t batchSize = LabeledData<InputType, unsigned int>::DefaultBatchSize) {
-                std::ifstream ifs (fn.c_str());
+                bool normallizeLabels,
+                unsigned int dimensions,
+                std::size_t batchSize) {
+                std::vector<std::size_t> chunkOffsets (1, 0);
+                std::vector<std::size_t> remainingRows;
+                for (std::size_t c = 0; c != parts.size(); ++c) {
+                    chunkOffsets.push_back (chunkOffsets.back() + parts[c].numberOfRows());
+                    remainingRows.push_back (parts[c].numberOfRows());
+                }
+
+                std::size_t numPoints = chunkOffsets.back();
+                std::size_t maxIndex = statistics.maxIndex;
+
+                // did we specify a dimension?
+                if (dimensions == 0) {
+                    // no, so we take what the max index/dimension we saw
+                    dimensions = maxIndex;
+                } else {
+                    // check if the given dimension matches
+                    if (maxIndex > dimensions)
+                        throw SHARKSVMEXCEPTION ("Number of dimensions supplied is smaller than actual index data");
+                }
+
+
+                //check labels for conformity
+                bool binaryLabels = statistics.hasMinusOne;
+                if (statistics.minLabel < -1)
+                    throw SHARKSVMEXCEPTION ("Negative labels are only allowed for classes -1/1");
+
+                if (binaryLabels && (statistics.minPositiveLabel == 0 ||  statistics.maxPositiveLabel > 1))
+                    throw SHARKSVMEXCEPTION ("Negative labels are only allowed for classes -1/1");
+
+                // TODO: sanity check for one-class?
+
+                // the labels in the order they were seen
+                std::vector<int> tmpLabelOrder = statistics.labelOrder;
+
+                if ((tmpLabelOrder.size() != 2) && (binaryLabels == true))
+                    throw SHARKSVMEXCEPTION ("Negative label indicated binary data, but found more than two labels.");
+
 
-                if (! ifs.good())
-                    throw SHARKSVMEXCEPTION ("Failed to open file for input");
+                // create dataset with the right structure, but empty batches; they are
+                // allocated while they are filled. for sparse input types the blueprint
+                // holds no entries, so memory stays proportional to the number of non-zeros.
+                bool haszero = statistics.hasZero;
+                InputType blueprint (dimensions + (haszero ? 1 : 0));
 
-                return importData (ifs, labelOrder, normallizeLabels, dimensions, batchSize);
+                // split the points evenly into batches, as shark does
+                std::size_t numberOfBatches = (numPoints + batchSize - 1) / batchSize;
+                std::vector<std::size_t> batchOffsets (1, 0);
+                for (std::size_t b = 0; b != numberOfBatches; ++b)
+                    batchOffsets.push_back (batchOffsets.back() + numPoints / numberOfBatches + ((b < numPoints % numberOfBatches) ? 1 : 0));
+
+                shark::LabeledData<InputType, unsigned int> data (numberOfBatches);
+
+                // copy contents into the new dataset, batch by batch
+                // and normalize labels on the fly
+                size_t delta = (haszero ? 0 : 1);
+                boost::mutex chunkMutex;
+                parallelFor (numberOfBatches, m_numberOfThreads,
+                             FillBatches (blueprint, parts, chunks, chunkOffsets, remainingRows, chunkMutex, batchOffsets, statistics, normallizeLabels, delta, data));
+
+                // finally add our new found labels to the ordering we were given
+                labelOrder.setLabelOrder (tmpLabelOrder);
+
+                return (data);
             }
 
 
-        private:
 
-            inline std::vector<LibSVMPoint>
+            /// \brief Read the whole stream buffer-wise and parse every buffer into an arena of its own.
+            ///
+            /// \param  stream      stream to be read from
+            /// \param  chunks      the arenas, in file order
+            ///
+            inline void
             importSparseDataReader (
-                std::istream& stream) {
-                std::vector<LibSVMPoint>  fileContents;
-
-                while (stream) {
-                    std::string line;
-                    std::getline (stream, line);
-
-                    if (line.empty()) continue;
-
-                    using namespace boost::spirit::qi;
-                    std::string::const_iterator first = line.begin();
-                    std::string::const_iterator last = line.end();
-
-                    LibSVMPoint newPoint;
-                    bool r = phrase_parse (
-                                 first, last,
-                                 int_   >> - (lit ('.') >> +lit ('0')) //we also want to be able to parse 1.00000 as label 1
-                                 >> * (uint_ >> ':' >> double_),
-                                 space , newPoint
-                             );
-
-                    if (!r || first != last) {
-                        std::cout << std::string (first, last) << std::endl;
-                        throw SHARKSVMEXCEPTION ("Problems parsing the sparse data file.");
-                    }
+                std::istream& stream,
+                std::vector<SparseDataArena> &chunks) {
+                // read in large chunks, the buffer only grows for overlong lines.
+                // the deque does not move the arenas parsed so far when it grows
+                std::deque<SparseDataArena> arenas;
+                std::vector<char> buffer (ChunkBytes);
+                std::size_t carry = 0;
+
+                while (true) {
+                    stream.read (&buffer[carry], buffer.size() - carry);
+                    std::size_t filled = carry + static_cast<std::size_t> (stream.gcount());
+                    bool atEnd = !stream;
+
+                    const char* begin = &buffer[0];
+                    arenas.push_back (SparseDataArena());
+                    const char* rest = SparseDataParser::parse (begin, begin + filled, atEnd, arenas.back());
+
+                    if (atEnd)
+                        break;
 
-                    fileContents.push_back (newPoint);
+                    // move the incomplete last line to the front, grow if one line fills the whole buffer
+                    carry = filled - (rest - begin);
+                    std::memmove (&buffer[0], rest, carry);
+                    if (carry == buffer.size())
+                        buffer.resize (2 * buffer.size());
                 }
 
-                return fileContents;
+                chunks.resize (arenas.size());
+                for (std::size_t c = 0; c != arenas.size(); ++c)
+                    chunks[c].swap (arenas[c]);
             }
 
 
+            /// text parsed into one chunk, the unit in which parsed points are released
+            static const std::size_t ChunkBytes = 4 * 1024 * 1024;
+
+            /// number of threads for importing and exporting, 0 means all cores
+            std::size_t m_numberOfThreads;
+
+            /// load from and write to the binary cache next to imported files
+            bool m_useCache;
+
+
     };
 
 } // namespace detail
@@ -0,0 +1,541 @@
+//===========================================================================
+/*!
+ *
+ *
+ * \brief       SMO training of Gaussian kernel SVMs with a cache of kernel rows
+ *
+ *
+ *
+ * \author      Aydin Demircioglu
+ * \date        2015
+ *
+ *
+ * \par Copyright 1995-2015 Shark Development Team
+ *
+ * <BR><HR>
+ * This file is part of Shark.
+ * <http://image.diku.dk/shark/>
+ *
+ * Shark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Shark.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+//===========================================================================
+
+#ifndef SHARKSVM_SMOSOLVER_H
+#define SHARKSVM_SMOSOLVER_H
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <list>
+#include <vector>
+
+#include <boost/align/aligned_allocator.hpp>
+#include <boost/atomic.hpp>
+
+#include <shark/Data/Dataset.h>
+
+#include "SharkSVM.h"
+#include "GaussianRbfExpansion.h"
+
+
+namespace shark {
+
+
+    /// \brief C-SVM training with a Gaussian kernel by sequential minimal optimization (SMO).
+    ///
+    /// \par
+    /// Solves the dual problem
+    /// \f[
+    ///     \min_a \frac{1}{2} \sum_{i,j} a_i a_j y_i y_j k(x_i, x_j) - \sum_i a_i, \quad 0 \leq a_i \leq C,
+    /// \f]
+    /// with the additional constraint sum_i y_i a_i = 0 if the model has an
+    /// offset. With an offset every step optimizes a pair of variables, picked
+    /// by the second order working set selection of LIBSVM (Fan, Chen and Lin,
+    /// "Working set selection using second order information for training
+    /// SVM", JMLR 6, 2005); without one, the single variable violating the
+    /// optimality conditions most.
+    ///
+    /// \par
+    /// The kernel rows k(x_i, .) of the chosen variables are kept in a cache
+    /// of a given number of bytes, in single precision, the rows used least
+    /// recently are evicted. The points are stored as aligned, padded rows with
+    /// their squared norms; a missing row is computed from inner products with
+    /// four points at a time and one vectorized exp over the whole row (see
+    /// detail::RbfKernels).
+    ///
+    /// \par
+    /// The solver stops when the largest violation of the optimality
+    /// conditions is below epsilon, after the given number of sweeps (ell
+    /// steps each), or when the flag given to train() is set.
+    ///
+    /// \par
+    /// Labels must be 0 and 1, label 1 is the positive class.
+    ///
+    class SmoSolver {
+        public:
+
+            /// \brief Constructor
+            ///
+            /// \param  gamma       bandwidth of the kernel exp(-gamma |a - b|^2)
+            /// \param  C           upper bound of the coefficients
+            /// \param  offset      whether the model has an offset
+            /// \param  cacheSize   size of the kernel row cache in bytes, at least two rows are always kept
+            ///
+            SmoSolver (double gamma, double C, bool offset, std::size_t cacheSize = 0x4000000) : m_gamma (gamma),
+                m_C (C),
+                m_offset (offset),
+                m_cacheSize (cacheSize),
+                m_epsilon (1e-3),
+                m_sweeps (0),
+                m_iterations (0),
+                m_hits (0),
+                m_misses (0),
+                m_ell (0),
+                m_stride (0) {
+                RANGE_CHECK (gamma > 0.0);
+                RANGE_CHECK (C > 0.0);
+            }
+
+
+
+            /// \brief Tolerance of the optimality conditions.
+            void setEpsilon (double epsilon) {
+                RANGE_CHECK (epsilon > 0.0);
+                m_epsilon = epsilon;
+            }
+
+
+            /// \brief Maximal number of sweeps of ell steps, 0 for no limit but LIBSVM's max(10^7, 100 ell) steps.
+            void setMaxSweeps (std::size_t sweeps) {
+                m_sweeps = sweeps;
+            }
+
+
+            /// \brief number of steps of the last training
+            std::size_t iterations() const {
+                return m_iterations;
+            }
+
+
+            /// \brief number of kernel rows found in the cache during the last training
+            std::size_t cacheHits() const {
+                return m_hits;
+            }
+
+
+            /// \brief number of kernel rows computed during the last training
+            std::size_t cacheMisses() const {
+                return m_misses;
+            }
+
+
+
+            /// \brief Train a model.
+            ///
+            /// \param  data        training points with labels 0 and 1
+            /// \param  model       the trained model, only points with non-zero coefficients are kept
+            /// \param  cancel      the training stops without a model as soon as this is true, may be NULL
+            /// \return false if the training was cancelled
+            ///
+            bool train (LabeledData<RealVector, unsigned int> const &data, GaussianRbfExpansion &model, boost::atomic<bool> const* cancel = NULL) {
+                setData (data);
+                if (m_ell == 0)
+                    throw SHARKSVMEXCEPTION ("Cannot train on an empty dataset.");
+
+                m_alpha.assign (m_ell, 0.0);
+                m_gradient.assign (m_ell, -1.0);
+                m_iterations = 0;
+                m_hits = 0;
+                m_misses = 0;
+                initCache();
+
+                std::size_t maxIterations = m_sweeps * m_ell;
+                if (m_sweeps == 0)
+                    maxIterations = std::max<std::size_t> (10000000, 100 * m_ell);
+
+                for (; m_iterations != maxIterations; ++m_iterations) {
+                    if ((cancel != NULL) && cancel->load (boost::memory_order_relaxed))
+                        return false;
+
+                    bool optimal = m_offset ? pairStep() : singleStep();
+                    if (optimal)
+                        break;
+                }
+
+                writeModel (model);
+                releaseCache();
+                return true;
+            }
+
+
+        private:
+
+            typedef std::vector<double, boost::alignment::aligned_allocator<double, 64> > AlignedVector;
+
+            /// \brief number of doubles of a padded row of the given length
+            static std::size_t padded (std::size_t length) {
+                std::size_t padding = detail::RbfKernels::padding;
+                return std::max<std::size_t> ((length + padding - 1) / padding * padding, padding);
+            }
+
+
+
+            /// \brief copy the points into padded rows, labels to +1 / -1
+            void setData (LabeledData<RealVector, unsigned int> const &data) {
+                m_ell = data.numberOfElements();
+                m_dimension = 0;
+                for (std::size_t b = 0; b != data.numberOfBatches(); ++b) {
+                    if (data.inputs().batch (b).size1() != 0)
+                        m_dimension = data.inputs().batch (b).size2();
+                }
+                m_stride = padded (m_dimension);
+
+                m_points.assign (std::max<std::size_t> (m_ell, 1) * m_stride, 0.0);
+                m_norms.assign (m_ell, 0.0);
+                m_y.assign (m_ell, 0.0);
+
+                std::size_t i = 0;
+                for (std::size_t b = 0; b != data.numberOfBatches(); ++b) {
+                    RealMatrix const &inputs = data.inputs().batch (b);
+                    UIntVector const &labels = data.labels().batch (b);
+                    for (std::size_t r = 0; r != inputs.size1(); ++r, ++i) {
+                        if (labels (r) > 1)
+                            throw SHARKSVMEXCEPTION ("The SMO solver needs the binary labels 0 and 1.");
+
+                        double* point = &m_points[i * m_stride];
+                        for (std::size_t j = 0; j != m_dimension; ++j)
+                            point[j] = inputs (r, j);
+                        m_norms[i] = detail::RbfKernels::dot (point, point, m_stride);
+                        m_y[i] = (labels (r) == 1) ? 1.0 : -1.0;
+                    }
+                }
+            }
+
+
+
+            /// \brief One step on the pair of variables violating the optimality conditions most,
+            /// returns true if there is none within epsilon.
+            bool pairStep() {
+                // i maximizes -y_t G_t over the variables that can move up
+                double gMax = -std::numeric_limits<double>::infinity();
+                std::size_t i = m_ell;
+                for (std::size_t t = 0; t != m_ell; ++t) {
+                    if (isUp (t) && (-m_y[t] * m_gradient[t] >= gMax)) {
+                        gMax = -m_y[t] * m_gradient[t];
+                        i = t;
+                    }
+                }
+                if (i == m_ell)
+                    return true;
+
+                // j gives the largest decrease of the objective with i, among the variables that can move down
+                float const* ki = row (i);
+                double kii = 1.0;
+                double gMin = std::numeric_limits<double>::infinity();
+                double best = std::numeric_limits<double>::infinity();
+                std::size_t j = m_ell;
+                for (std::size_t t = 0; t != m_ell; ++t) {
+                    if (!isLow (t))
+                        continue;
+
+                    double g = -m_y[t] * m_gradient[t];
+                    gMin = std::min (gMin, g);
+
+                    double b = gMax - g;
+                    if (b <= 0.0)
+                        continue;
+
+                    // the Gaussian kernel has k(x, x) = 1
+                    double a = std::max (kii + 1.0 - 2.0 * ki[t], 1e-12);
+                    if (-(b * b) / a <= best) {
+                        best = -(b * b) / a;
+                        j = t;
+                    }
+                }
+                if ((j == m_ell) || (gMax - gMin < m_epsilon))
+                    return true;
+
+                // fetching the row of j keeps the one of i, the cache holds at least two rows
+                float const* kj = row (j);
+
+                double oldAi = m_alpha[i];
+                double oldAj = m_alpha[j];
+                updatePair (i, j, ki[j]);
+
+                double di = (m_alpha[i] - oldAi) * m_y[i];
+                double dj = (m_alpha[j] - oldAj) * m_y[j];
+                for (std::size_t t = 0; t != m_ell; ++t)
+                    m_gradient[t] += m_y[t] * (di * ki[t] + dj * kj[t]);
+                return false;
+            }
+
+
+
+            /// \brief the pair update of LIBSVM, with the result clipped to the box
+            void updatePair (std::size_t i, std::size_t j, double kij) {
+                double& ai = m_alpha[i];
+                double& aj = m_alpha[j];
+                double gi = m_gradient[i];
+                double gj = m_gradient[j];
+
+                // k(x_i, x_i) + k(x_j, x_j) - 2 k(x_i, x_j) in both cases
+                double quad = std::max (2.0 - 2.0 * kij, 1e-12);
+
+                if (m_y[i] != m_y[j]) {
+                    double delta = (-gi - gj) / quad;
+                    double diff = ai - aj;
+                    ai += delta;
+                    aj += delta;
+
+                    if ((diff > 0.0) && (aj < 0.0)) {
+                        aj = 0.0;
+                        ai = diff;
+                    } else if ((diff <= 0.0) && (ai < 0.0)) {
+                        ai = 0.0;
+                        aj = -diff;
+                    }
+                    if ((diff > 0.0) && (ai > m_C)) {
+                        ai = m_C;
+                        aj = m_C - diff;
+                    } else if ((diff <= 0.0) && (aj > m_C)) {
+                        aj = m_C;
+                        ai = m_C + diff;
+                    }
+                } else {
+                    double delta = (gi - gj) / quad;
+                    double sum = ai + aj;
+                    ai -= delta;
+                    aj += delta;
+
+                    if ((sum > m_C) && (ai > m_C)) {
+                        ai = m_C;
+                        aj = sum - m_C;
+                    } else if ((sum <= m_C) && (aj < 0.0)) {
+                        aj = 0.0;
+                        ai = sum;
+                    }
+                    if ((sum > m_C) && (aj > m_C)) {
+                        aj = m_C;
+                        ai = sum - m_C;
+                    } else if ((sum <= m_C) && (ai < 0.0)) {
+                        ai = 0.0;
+                        aj = sum;
+                    }
+                }
+            }
+
+
+
+            /// \brief One step on the variable violating the optimality conditions most (no offset),
+            /// returns true if there is none within epsilon.
+            bool singleStep() {
+                // projected gradient, the bounds block one direction
+                double violation = 0.0;
+                std::size_t i = m_ell;
+                for (std::size_t t = 0; t != m_ell; ++t) {
+                    double g = m_gradient[t];
+                    if (m_alpha[t] <= 0.0)
+                        g = std::min (g, 0.0);
+                    else if (m_alpha[t] >= m_C)
+                        g = std::max (g, 0.0);
+
+                    if (std::abs (g) > violation) {
+                        violation = std::abs (g);
+                        i = t;
+                    }
+                }
+                if ((i == m_ell) || (violation < m_epsilon))
+                    return true;
+
+                // k(x_i, x_i) = 1
+                float const* ki = row (i);
+                double old = m_alpha[i];
+                m_alpha[i] = std::min (std::max (old - m_gradient[i], 0.0), m_C);
+
+                double di = (m_alpha[i] - old) * m_y[i];
+                for (std::size_t t = 0; t != m_ell; ++t)
+                    m_gradient[t] += m_y[t] * di * ki[t];
+                return false;
+            }
+
+
+
+            /// \brief whether a_t can move in the direction of y_t
+            bool isUp (std::size_t t) const {
+                return (m_y[t] > 0.0) ? (m_alpha[t] < m_C) : (m_alpha[t] > 0.0);
+            }
+
+            /// \brief whether a_t can move against the direction of y_t
+            bool isLow (std::size_t t) const {
+                return (m_y[t] > 0.0) ? (m_alpha[t] > 0.0) : (m_alpha[t] < m_C);
+            }
+
+
+
+            /// \brief alpha_i y_i of the free variables, and the offset of LIBSVM
+            void writeModel (GaussianRbfExpansion &model) const {
+                // the offset is the average over the free variables, or the middle of the feasible interval
+                double offset = 0.0;
+                if (m_offset) {
+                    double upper = std::numeric_limits<double>::infinity();
+                    double lower = -std::numeric_limits<double>::infinity();
+                    double sum = 0.0;
+                    std::size_t free = 0;
+                    for (std::size_t t = 0; t != m_ell; ++t) {
+                        double yg = m_y[t] * m_gradient[t];
+                        if ((m_alpha[t] > 0.0) && (m_alpha[t] < m_C)) {
+                            sum += yg;
+                            ++free;
+                        } else if (isUp (t)) {
+                            // a_t = 0 for y = 1, a_t = C for y = -1
+                            upper = std::min (upper, yg);
+                        } else {
+                            lower = std::max (lower, yg);
+                        }
+                    }
+                    double rho = (free != 0) ? sum / free : (upper + lower) / 2.0;
+                    offset = -rho;
+                }
+
+                std::vector<RealVector> basis;
+                std::vector<double> coefficients;
+                for (std::size_t t = 0; t != m_ell; ++t) {
+                    if (m_alpha[t] == 0.0)
+                        continue;
+
+                    double const* point = &m_points[t * m_stride];
+                    basis.push_back (RealVector (m_dimension));
+                    std::copy (point, point + m_dimension, basis.back().begin());
+                    coefficients.push_back (m_alpha[t] * m_y[t]);
+                }
+
+                RealMatrix alpha (basis.size(), 1);
+                for (std::size_t s = 0; s != basis.size(); ++s)
+                    alpha (s, 0) = coefficients[s];
+
+                model.setStructure (m_gamma, basis, alpha, RealVector (1, offset));
+            }
+
+
+
+            /// \brief make room for as many rows as fit into the cache size, at least two
+            void initCache() {
+                m_capacity = std::max<std::size_t> (m_cacheSize / (m_ell * sizeof (float)), 2);
+                m_rows.assign (m_ell, std::vector<float>());
+                m_lru.clear();
+                m_position.assign (m_ell, m_lru.end());
+                m_buffer.assign (m_ell, 0.0);
+            }
+
+
+            /// \brief free all rows
+            void releaseCache() {
+                std::vector<std::vector<float> >().swap (m_rows);
+                m_lru.clear();
+                std::vector<std::list<std::size_t>::iterator>().swap (m_position);
+            }
+
+
+
+            /// \brief kernel row of i, from the cache if possible
+            float const* row (std::size_t i) {
+                if (!m_rows[i].empty()) {
+                    ++m_hits;
+                } else {
+                    computeRow (i);
+                    ++m_misses;
+                }
+                touch (i);
+                return &m_rows[i][0];
+            }
+
+
+
+            /// \brief make row i the most recently used one, evicting the least recently used rows
+            void touch (std::size_t i) {
+                if (m_position[i] != m_lru.end())
+                    m_lru.erase (m_position[i]);
+                m_lru.push_front (i);
+                m_position[i] = m_lru.begin();
+
+                while (m_lru.size() > m_capacity) {
+                    std::size_t evicted = m_lru.back();
+                    m_lru.pop_back();
+                    m_position[evicted] = m_lru.end();
+                    std::vector<float>().swap (m_rows[evicted]);
+                }
+            }
+
+
+
+            /// \brief compute the kernel row of i into the cache
+            void computeRow (std::size_t i) {
+                double const* x = &m_points[i * m_stride];
+                double* dots = &m_buffer[0];
+
+                std::size_t t = 0;
+                for (; t + 4 <= m_ell; t += 4) {
+                    double const* s = &m_points[t * m_stride];
+                    detail::RbfKernels::dot4 (s, s + m_stride, s + 2 * m_stride, s + 3 * m_stride, x, m_stride, dots + t);
+                }
+                for (; t != m_ell; ++t)
+                    dots[t] = detail::RbfKernels::dot (&m_points[t * m_stride], x, m_stride);
+
+                // rounding can make the distance slightly negative
+                for (t = 0; t != m_ell; ++t)
+                    dots[t] = -m_gamma * std::max (m_norms[i] + m_norms[t] - 2.0 * dots[t], 0.0);
+                detail::RbfKernels::expNonPositive (dots, m_ell);
+
+                m_rows[i].assign (dots, dots + m_ell);
+            }
+
+
+
+            double m_gamma;
+            double m_C;
+            bool m_offset;
+            std::size_t m_cacheSize;
+            double m_epsilon;
+            std::size_t m_sweeps;
+
+            std::size_t m_iterations;
+            std::size_t m_hits;
+            std::size_t m_misses;
+
+            /// the points as padded rows, their squared norms and labels +1 / -1
+            std::size_t m_ell;
+            std::size_t m_dimension;
+            std::size_t m_stride;
+            AlignedVector m_points;
+            std::vector<double> m_norms;
+            std::vector<double> m_y;
+
+            /// dual variables and the gradient of the dual objective
+            std::vector<double> m_alpha;
+            std::vector<double> m_gradient;
+
+            /// cached kernel rows, empty if not cached, and their order of use, most recent first
+            std::size_t m_capacity;
+            std::vector<std::vector<float> > m_rows;
+            std::list<std::size_t> m_lru;
+            std::vector<std::list<std::size_t>::iterator> m_position;
+
+            /// inner products of a row being computed
+            std::vector<double> m_buffer;
+    };
+
+}
+
+#endif
@@ -0,0 +1,383 @@
+//===========================================================================
+/*!
+ *
+ *
+ * \brief       Binary sidecar cache for sparse data files
+ *
+ *
+ *
+ * \author      Aydin Demircioglu
+ * \date        2015
+ *
+ *
+ * \par Copyright 1995-2015 Shark Development Team
+ *
+ * <BR><HR>
+ * This file is part of Shark.
+ * <http://image.diku.dk/shark/>
+ *
+ * Shark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Shark.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+//===========================================================================
+
+#ifndef SHARKSVM_SPARSEDATACACHE_H
+#define SHARKSVM_SPARSEDATACACHE_H
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+
+#ifndef _WIN32
+#include <sys/stat.h>
+#endif
+
+#include "MappedFile.h"
+#include "SparseDataParser.h"
+
+
+namespace shark {
+
+
+    /// \brief Binary sidecar cache of a parsed sparse data file.
+    ///
+    /// \par
+    /// The cache lives next to the data file (name + ".cache") and holds a
+    /// fixed header followed by the label order and the raw CSR arrays
+    /// (labels, row pointers, indices, values), each aligned to 8 bytes.
+    /// On reload the file is memory mapped and the arrays are used in place,
+    /// nothing is parsed.
+    ///
+    /// \par
+    /// A cache is only used if size, modification time (in nanoseconds, so
+    /// two edits within one second are told apart) and a hash of the data
+    /// file match the values stored in its header. The hash covers the first,
+    /// middle and last block of the file, reading it as a whole would cost
+    /// as much I/O as parsing it. The format is in native byte order, a cache
+    /// written on a different architecture is ignored.
+    ///
+    class SparseDataCache {
+        public:
+
+            /// \brief What identifies the contents of a data file.
+            struct Signature {
+                Signature() : size (0), modified (0), hash (0) {}
+
+                boost::uint64_t size;
+                /// modification time in nanoseconds since the epoch
+                boost::uint64_t modified;
+                boost::uint64_t hash;
+            };
+
+
+
+            /// \brief name of the cache belonging to the given data file
+            static std::string cacheFilename (std::string const &fn) {
+                return fn + ".cache";
+            }
+
+
+
+            /// \brief Compute the signature of a data file.
+            ///
+            /// \param  fn          data file
+            /// \param[out] signature   the signature
+            /// \return false if the file is no regular file or caching is not supported
+            ///
+            static bool signature (std::string const &fn, Signature &signature) {
+#ifndef _WIN32
+                struct stat info;
+                if ((stat (fn.c_str(), &info) != 0) || !S_ISREG (info.st_mode))
+                    return false;
+
+                signature.size = static_cast<boost::uint64_t> (info.st_size);
+#if defined(__APPLE__)
+                const long nanoseconds = info.st_mtimespec.tv_nsec;
+#else
+                const long nanoseconds = info.st_mtim.tv_nsec;
+#endif
+                signature.modified = static_cast<boost::uint64_t> (info.st_mtime) * 1000000000ULL + static_cast<boost::uint64_t> (nanoseconds);
+
+                std::ifstream ifs (fn.c_str(), std::ios::binary);
+                if (!ifs)
+                    return false;
+
+                // hash first, middle and last block
+                const std::size_t blockSize = 64 * 1024;
+                std::vector<char> block (blockSize);
+                boost::uint64_t hash = 14695981039346656037ULL;
+                boost::uint64_t offsets[3] = {0, signature.size / 2, (signature.size > blockSize) ? signature.size - blockSize : 0};
+
+                for (std::size_t b = 0; b != 3; ++b) {
+                    ifs.clear();
+                    ifs.seekg (static_cast<std::streamoff> (offsets[b]));
+                    ifs.read (&block[0], blockSize);
+
+                    std::size_t length = static_cast<std::size_t> (ifs.gcount());
+                    for (std::size_t i = 0; i != length; ++i) {
+                        hash ^= static_cast<unsigned char> (block[i]);
+                        hash *= 1099511628211ULL;
+                    }
+                }
+
+                signature.hash = hash;
+                return true;
+#else
+                (void) fn;
+                (void) signature;
+                return false;
+#endif
+            }
+
+
+
+            /// \brief Map the cache of a data file, if it is valid.
+            ///
+            /// \param  fn          data file
+            /// \param  signature   signature of the data file
+            /// \param  cacheFile   mapping of the cache, the rows point into it
+            /// \param[out] statistics  statistics of the cached rows
+            /// \param[out] rows    view of the cached rows
+            /// \return true if a valid cache was found
+            ///
+            static bool load (std::string const &fn,
+                              Signature const &signature,
+                              MappedFile &cacheFile,
+                              SparseDataStatistics &statistics,
+                              SparseDataRows &rows) {
+                if (!cacheFile.open (cacheFilename (fn)))
+                    return false;
+
+                if (cacheFile.size() < sizeof (Header)) {
+                    cacheFile.close();
+                    return false;
+                }
+
+                Header header;
+                std::memcpy (&header, cacheFile.data(), sizeof (Header));
+
+                Header expected (signature);
+                if ((std::memcmp (header.magic, expected.magic, sizeof (header.magic)) != 0) ||
+                        (header.version != expected.version) ||
+                        (header.byteOrder != expected.byteOrder) ||
+                        (header.sourceSize != signature.size) ||
+                        (header.sourceModified != signature.modified) ||
+                        (header.sourceHash != signature.hash) ||
+                        (cacheFile.size() != fileSize (header))) {
+                    cacheFile.close();
+                    return false;
+                }
+
+                const char* p = cacheFile.data() + sizeof (Header);
+
+                const int* labelOrder = reinterpret_cast<const int*> (p);
+                p += align (header.numberOfLabels * sizeof (boost::int32_t));
+
+                rows.rows = static_cast<std::size_t> (header.rows);
+                rows.labels = reinterpret_cast<const int*> (p);
+                p += align (header.rows * sizeof (boost::int32_t));
+                rows.rowPointers = reinterpret_cast<const boost::uint64_t*> (p);
+                p += (header.rows + 1) * sizeof (boost::uint64_t);
+                rows.indices = reinterpret_cast<const unsigned int*> (p);
+                p += align (header.entries * sizeof (boost::uint32_t));
+                rows.values = reinterpret_cast<const double*> (p);
+
+                if (rows.rowPointers[rows.rows] != header.entries) {
+                    cacheFile.close();
+                    return false;
+                }
+
+                statistics = SparseDataStatistics();
+                statistics.maxIndex = static_cast<std::size_t> (header.maxIndex);
+                statistics.hasZero = (header.hasZero != 0);
+                statistics.hasMinusOne = (header.hasMinusOne != 0);
+                statistics.minLabel = header.minLabel;
+                statistics.minPositiveLabel = header.minPositiveLabel;
+                statistics.maxPositiveLabel = header.maxPositiveLabel;
+                statistics.addLabelOrder (std::vector<int> (labelOrder, labelOrder + header.numberOfLabels));
+
+                return true;
+            }
+
+
+
+            /// \brief Write the cache for a data file.
+            /// the cache is written to a temporary file first and renamed
+            /// afterwards, so a crash never leaves a broken cache behind.
+            ///
+            /// \param  fn          data file
+            /// \param  signature   signature of the data file at the time it was parsed
+            /// \param  chunks      the parsed points, in file order
+            /// \return true if the cache was written; failing to write is not an error
+            ///
+            static bool write (std::string const &fn,
+                               Signature const &signature,
+                               std::vector<SparseDataArena> const &chunks) {
+                Header header (signature);
+                SparseDataStatistics statistics;
+
+                for (std::size_t c = 0; c != chunks.size(); ++c) {
+                    statistics.merge (chunks[c].statistics);
+                    header.rows += chunks[c].numberOfRows();
+                    header.entries += chunks[c].numberOfEntries();
+                }
+
+                header.maxIndex = statistics.maxIndex;
+                header.hasZero = statistics.hasZero ? 1 : 0;
+                header.hasMinusOne = statistics.hasMinusOne ? 1 : 0;
+                header.minLabel = statistics.minLabel;
+                header.minPositiveLabel = statistics.minPositiveLabel;
+                header.maxPositiveLabel = statistics.maxPositiveLabel;
+                header.numberOfLabels = static_cast<boost::uint32_t> (statistics.labelOrder.size());
+
+                std::string cacheFn = cacheFilename (fn);
+                std::string temporaryFn = cacheFn + ".tmp";
+
+                std::vector<char> streamBuffer (1024 * 1024);
+                std::ofstream ofs;
+                ofs.rdbuf()->pubsetbuf (&streamBuffer[0], streamBuffer.size());
+                ofs.open (temporaryFn.c_str(), std::ios::binary | std::ios::trunc);
+
+                if (!ofs)
+                    return false;
+
+                ofs.write (reinterpret_cast<const char*> (&header), sizeof (Header));
+
+                writePadded (ofs, statistics.labelOrder.empty() ? NULL : &statistics.labelOrder[0],
+                             statistics.labelOrder.size() * sizeof (int));
+
+                std::size_t bytes = 0;
+                for (std::size_t c = 0; c != chunks.size(); ++c)
+                    bytes += writeArray (ofs, chunks[c].labels);
+                pad (ofs, bytes);
+
+                // row pointers are shifted by the entries of all chunks before
+                std::vector<boost::uint64_t> rowPointers (1, 0);
+                boost::uint64_t base = 0;
+                ofs.write (reinterpret_cast<const char*> (&rowPointers[0]), sizeof (boost::uint64_t));
+                for (std::size_t c = 0; c != chunks.size(); ++c) {
+                    rowPointers.assign (chunks[c].rowPointers.begin() + 1, chunks[c].rowPointers.end());
+                    for (std::size_t i = 0; i != rowPointers.size(); ++i)
+                        rowPointers[i] += base;
+                    writeArray (ofs, rowPointers);
+                    base += chunks[c].numberOfEntries();
+                }
+
+                bytes = 0;
+                for (std::size_t c = 0; c != chunks.size(); ++c)
+                    bytes += writeArray (ofs, chunks[c].indices);
+                pad (ofs, bytes);
+
+                for (std::size_t c = 0; c != chunks.size(); ++c)
+                    writeArray (ofs, chunks[c].values);
+
+                ofs.close();
+
+                if (!ofs || (std::rename (temporaryFn.c_str(), cacheFn.c_str()) != 0)) {
+                    std::remove (temporaryFn.c_str());
+                    return false;
+                }
+
+                return true;
+            }
+
+
+        private:
+
+            /// \brief Fixed size header of the cache, its size is a multiple of 8.
+            struct Header {
+                explicit Header (Signature const &signature = Signature()) : version (2),
+                    byteOrder (0x01020304),
+                    sourceSize (signature.size),
+                    sourceModified (signature.modified),
+                    sourceHash (signature.hash),
+                    rows (0),
+                    entries (0),
+                    maxIndex (0),
+                    minLabel (0),
+                    minPositiveLabel (0),
+                    maxPositiveLabel (0),
+                    numberOfLabels (0),
+                    hasZero (0),
+                    hasMinusOne (0) {
+                    std::memcpy (magic, "SHKSPRS", 8);
+                }
+
+                char magic[8];
+                boost::uint32_t version;
+                boost::uint32_t byteOrder;
+                boost::uint64_t sourceSize;
+                boost::uint64_t sourceModified;
+                boost::uint64_t sourceHash;
+                boost::uint64_t rows;
+                boost::uint64_t entries;
+                boost::uint64_t maxIndex;
+                boost::int32_t minLabel;
+                boost::int32_t minPositiveLabel;
+                boost::int32_t maxPositiveLabel;
+                boost::uint32_t numberOfLabels;
+                boost::uint32_t hasZero;
+                boost::uint32_t hasMinusOne;
+            };
+
+
+
+            static boost::uint64_t align (boost::uint64_t bytes) {
+                return (bytes + 7) & ~boost::uint64_t (7);
+            }
+
+
+
+            /// \brief size a cache with the given header must have
+            static boost::uint64_t fileSize (Header const &header) {
+                return sizeof (Header)
+                       + align (header.numberOfLabels * sizeof (boost::int32_t))
+                       + align (header.rows * sizeof (boost::int32_t))
+                       + (header.rows + 1) * sizeof (boost::uint64_t)
+                       + align (header.entries * sizeof (boost::uint32_t))
+                       + header.entries * sizeof (double);
+            }
+
+
+
+            template <class T>
+            static std::size_t writeArray (std::ofstream &ofs, std::vector<T> const &array) {
+                if (!array.empty())
+                    ofs.write (reinterpret_cast<const char*> (&array[0]), array.size() * sizeof (T));
+                return array.size() * sizeof (T);
+            }
+
+
+
+            static void writePadded (std::ofstream &ofs, const void* data, std::size_t bytes) {
+                if (bytes > 0)
+                    ofs.write (static_cast<const char*> (data), bytes);
+                pad (ofs, bytes);
+            }
+
+
+
+            static void pad (std::ofstream &ofs, std::size_t bytes) {
+                static const char zeros[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+                ofs.write (zeros, align (bytes) - bytes);
+            }
+    };
+
+}
+
+#endif
@@ -0,0 +1,729 @@
+//===========================================================================
+/*!
+ *
+ *
+ * \brief       Fast tokenizer for sparse data (libSVM) formatted text
+ *
+ *
+ * \par
+ * The parser works on raw character buffers and writes the points it
+ * finds into one growing compressed sparse row (CSR) arena, so that
+ * no per-line or per-point heap allocations are necessary.
+ *
+ *
+ *
+ * \author      Aydin Demircioglu
+ * \date        2015
+ *
+ *
+ * \par Copyright 1995-2015 Shark Development Team
+ *
+ * <BR><HR>
+ * This file is part of Shark.
+ * <http://image.diku.dk/shark/>
+ *
+ * Shark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Shark.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+//===========================================================================
+
+#ifndef SHARKSVM_DATA_SPARSEDATAPARSER_H
+#define SHARKSVM_DATA_SPARSEDATAPARSER_H
+
+#include <algorithm>
+#include <clocale>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <locale>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/unordered_map.hpp>
+
+#include "SharkSVM.h"
+
+
+namespace shark {
+
+
+    /// \brief Statistics of parsed sparse data that are needed to build a dataset.
+    ///
+    /// \par
+    /// The statistics are updated by the parser while it reads, so no extra
+    /// pass over the parsed points is needed. Statistics of consecutive parts
+    /// of a file can be merged in file order; the result is the same as if the
+    /// whole file was read at once, including the order in which the labels
+    /// were first seen.
+    ///
+    class SparseDataStatistics {
+        public:
+
+            SparseDataStatistics() : maxIndex (0),
+                hasZero (false),
+                minLabel (std::numeric_limits<int>::max()),
+                minPositiveLabel (std::numeric_limits<int>::max()),
+                maxPositiveLabel (-1),
+                hasMinusOne (false) {}
+
+
+            /// \brief account for the label of a new point
+            void addLabel (int label) {
+                minLabel = std::min (minLabel, label);
+
+                if (label == -1)
+                    hasMinusOne = true;
+                else if (label >= 0) {
+                    minPositiveLabel = std::min (minPositiveLabel, label);
+                    maxPositiveLabel = std::max (maxPositiveLabel, label);
+                }
+
+                insertLabel (label);
+            }
+
+
+            /// \brief account for a feature index
+            void addIndex (unsigned int index) {
+                if (index > maxIndex)
+                    maxIndex = index;
+                if (index == 0)
+                    hasZero = true;
+            }
+
+
+            /// \brief merge the statistics of the part following this one
+            void merge (SparseDataStatistics const &other) {
+                maxIndex = std::max (maxIndex, other.maxIndex);
+                hasZero = hasZero || other.hasZero;
+                minLabel = std::min (minLabel, other.minLabel);
+                minPositiveLabel = std::min (minPositiveLabel, other.minPositiveLabel);
+                maxPositiveLabel = std::max (maxPositiveLabel, other.maxPositiveLabel);
+                hasMinusOne = hasMinusOne || other.hasMinusOne;
+
+                addLabelOrder (other.labelOrder);
+            }
+
+
+            /// \brief add labels in the given order, as if they were seen
+            void addLabelOrder (std::vector<int> const &order) {
+                for (std::size_t i = 0; i != order.size(); ++i)
+                    insertLabel (order[i]);
+            }
+
+
+            /// \brief position of a seen label in labelOrder
+            unsigned int labelPosition (int label) const {
+                return labelIndex.find (label)->second;
+            }
+
+
+            /// \brief largest feature index seen
+            std::size_t maxIndex;
+
+            /// \brief was feature index zero used (non-standard, but it happens)
+            bool hasZero;
+
+            /// \brief all labels in the order they were first seen
+            std::vector<int> labelOrder;
+
+            /// \brief maps every seen label to its position in labelOrder
+            boost::unordered_map<int, unsigned int> labelIndex;
+
+            int minLabel;
+
+            int minPositiveLabel;
+
+            int maxPositiveLabel;
+
+            /// \brief was the label -1 seen, i.e. are these binary labels
+            bool hasMinusOne;
+
+
+        private:
+
+            void insertLabel (int label) {
+                if (labelIndex.find (label) == labelIndex.end()) {
+                    labelIndex[label] = static_cast<unsigned int> (labelOrder.size());
+                    labelOrder.push_back (label);
+                }
+            }
+    };
+
+
+
+    /// \brief Compressed sparse row storage for parsed sparse data.
+    ///
+    /// \par
+    /// Row i consists of the label labels[i] and the (index, value) pairs
+    /// stored at positions rowPointers[i] .. rowPointers[i+1]-1 of the
+    /// indices and values arrays. Indices are kept as they appear in the
+    /// file, i.e. they are usually one-based.
+    ///
+    class SparseDataArena {
+        public:
+
+            SparseDataArena() {
+                rowPointers.push_back (0);
+            }
+
+
+            /// \brief number of points stored in the arena
+            std::size_t numberOfRows() const {
+                return labels.size();
+            }
+
+
+            /// \brief number of stored (index, value) pairs
+            std::size_t numberOfEntries() const {
+                return indices.size();
+            }
+
+
+            /// \brief remove all points, but keep the allocated memory
+            void clear() {
+                labels.clear();
+                rowPointers.resize (1);
+                indices.clear();
+                values.clear();
+                statistics = SparseDataStatistics();
+            }
+
+
+            /// \brief exchange the contents with another arena, nothing is copied
+            void swap (SparseDataArena &other) {
+                labels.swap (other.labels);
+                rowPointers.swap (other.rowPointers);
+                indices.swap (other.indices);
+                values.swap (other.values);
+                std::swap (statistics, other.statistics);
+            }
+
+
+            /// \brief remove all points and give the memory back,
+            /// the statistics are kept
+            void release() {
+                std::vector<int>().swap (labels);
+                std::vector<boost::uint64_t> (1, 0).swap (rowPointers);
+                std::vector<unsigned int>().swap (indices);
+                std::vector<double>().swap (values);
+            }
+
+
+            std::vector<int> labels;
+
+            std::vector<boost::uint64_t> rowPointers;
+
+            std::vector<unsigned int> indices;
+
+            std::vector<double> values;
+
+            /// \brief statistics of all points parsed into the arena
+            SparseDataStatistics statistics;
+    };
+
+
+
+    /// \brief Read-only view of rows in compressed sparse row form.
+    ///
+    /// \par
+    /// The layout is the one of SparseDataArena, but the arrays may live
+    /// anywhere, e.g. in a memory mapped cache file. The view does not own
+    /// the memory.
+    ///
+    class SparseDataRows {
+        public:
+
+            SparseDataRows() : labels (NULL),
+                rowPointers (NULL),
+                indices (NULL),
+                values (NULL),
+                rows (0) {}
+
+
+            explicit SparseDataRows (SparseDataArena const &arena) : labels (arena.labels.empty() ? NULL : &arena.labels[0]),
+                rowPointers (&arena.rowPointers[0]),
+                indices (arena.indices.empty() ? NULL : &arena.indices[0]),
+                values (arena.values.empty() ? NULL : &arena.values[0]),
+                rows (arena.numberOfRows()) {}
+
+
+            /// \brief number of points in the view
+            std::size_t numberOfRows() const {
+                return rows;
+            }
+
+
+            const int* labels;
+
+            const boost::uint64_t* rowPointers;
+
+            const unsigned int* indices;
+
+            const double* values;
+
+            std::size_t rows;
+    };
+
+
+
+    /// \brief Hand-written tokenizer for sparse data (libSVM) lines.
+    ///
+    /// \par
+    /// The accepted language is exactly the one of the former Spirit grammar
+    ///     int_ >> -(lit('.') >> +lit('0')) >> *(uint_ >> ':' >> double_)
+    /// with the space skipper, applied to every non-empty line. So labels
+    /// like 1.000 are read as 1, feature index 0 is allowed and whitespace
+    /// may appear between all tokens.
+    ///
+    /// \par
+    /// Values are parsed by a fast path that is exact whenever the decimal
+    /// mantissa fits into 53 bits and the decimal exponent is small; all
+    /// other numbers are handed to the (locale independent) stream parser.
+    ///
+    class SparseDataParser {
+        public:
+
+            /// \brief Parse all lines in the given buffer.
+            ///
+            /// \param  begin       start of the buffer
+            /// \param  end         end of the buffer
+            /// \param  atEnd       if true, the buffer is the end of the input, so a
+            ///                     last line without line break is parsed too
+            /// \param  arena       arena the points are appended to
+            /// \return pointer to the first character that was not consumed, i.e.
+            ///         the start of an incomplete last line (or end)
+            ///
+            static const char* parse (const char* begin,
+                                      const char* end,
+                                      bool atEnd,
+                                      SparseDataArena &arena) {
+                const char* lineStart = begin;
+
+                while (lineStart != end) {
+                    const char* lineEnd = static_cast<const char*> (std::memchr (lineStart, '\n', end - lineStart));
+
+                    if (lineEnd == NULL) {
+                        if (!atEnd)
+                            return lineStart;
+
+                        lineEnd = end;
+                    }
+
+                    // empty lines are skipped, everything else must be a valid point
+                    if (lineEnd != lineStart)
+                        parseLine (lineStart, lineEnd, arena);
+
+                    lineStart = (lineEnd == end) ? end : lineEnd + 1;
+                }
+
+                return end;
+            }
+
+
+
+            /// \brief Parse a single line (without line break) into the arena.
+            ///
+            static void parseLine (const char* first, const char* last, SparseDataArena &arena) {
+                const char* p = first;
+
+                // label
+                int label = 0;
+                skipSpace (p, last);
+                if (!parseInt (p, last, label))
+                    parseError (p, last);
+
+                // we also want to be able to parse 1.00000 as label 1
+                const char* q = p;
+                skipSpace (q, last);
+                if (q != last && *q == '.') {
+                    ++q;
+                    skipSpace (q, last);
+                    if (q != last && *q == '0') {
+                        // as the former grammar, greedily eat zeros, even across whitespace
+                        do {
+                            p = ++q;
+                            skipSpace (q, last);
+                        } while (q != last && *q == '0');
+                    }
+                }
+
+                std::size_t rowStart = arena.indices.size();
+
+                // index:value pairs
+                while (true) {
+                    skipSpace (p, last);
+                    if (p == last)
+                        break;
+
+                    const char* pairStart = p;
+                    unsigned int index = 0;
+                    double value = 0.0;
+
+                    bool ok = parseUnsigned (p, last, index);
+                    if (ok) {
+                        skipSpace (p, last);
+                        ok = (p != last && *p == ':');
+                    }
+                    if (ok) {
+                        ++p;
+                        skipSpace (p, last);
+                        ok = parseDouble (p, last, value);
+                    }
+
+                    if (!ok) {
+                        // forget the partial row before complaining
+                        arena.indices.resize (rowStart);
+                        arena.values.resize (rowStart);
+                        parseError (pairStart, last);
+                    }
+
+                    arena.indices.push_back (index);
+                    arena.values.push_back (value);
+                    arena.statistics.addIndex (index);
+                }
+
+                arena.labels.push_back (label);
+                arena.rowPointers.push_back (arena.indices.size());
+                arena.statistics.addLabel (label);
+            }
+
+
+
+            /// \brief Parse a floating point number with the syntax of the Spirit double_ parser.
+            ///
+            /// \param[in,out]  p       current position, will be advanced behind the number
+            /// \param  last    end of the input
+            /// \param[out]     value   the parsed number
+            /// \return true if a number was found
+            ///
+            static bool parseDouble (const char* &p, const char* last, double &value) {
+                const char* s = p;
+                bool negative = false;
+
+                if (s != last && (*s == '+' || *s == '-')) {
+                    negative = (*s == '-');
+                    ++s;
+                }
+
+                if (s == last)
+                    return false;
+
+                if (!isDigit (*s) && *s != '.') {
+                    if (!parseSpecial (s, last, value))
+                        return false;
+
+                    if (negative)
+                        value = -value;
+
+                    p = s;
+                    return true;
+                }
+
+                // mantissa, at most 19 significant digits fit into 64 bits
+                boost::uint64_t mantissa = 0;
+                int significantDigits = 0;
+                int exponent = 0;
+                bool anyDigits = false;
+                bool truncated = false;
+
+                while (s != last && isDigit (*s)) {
+                    if (significantDigits < 19) {
+                        mantissa = mantissa * 10 + (*s - '0');
+                        if (mantissa != 0)
+                            ++significantDigits;
+                    } else {
+                        ++exponent;
+                        truncated = true;
+                    }
+                    anyDigits = true;
+                    ++s;
+                }
+
+                if (s != last && *s == '.') {
+                    ++s;
+                    while (s != last && isDigit (*s)) {
+                        if (significantDigits < 19) {
+                            mantissa = mantissa * 10 + (*s - '0');
+                            if (mantissa != 0)
+                                ++significantDigits;
+                            --exponent;
+                        } else {
+                            truncated = true;
+                        }
+                        anyDigits = true;
+                        ++s;
+                    }
+                }
+
+                if (!anyDigits)
+                    return false;
+
+                // exponent; an 'e' without digits is not part of the number
+                if (s != last && (*s == 'e' || *s == 'E')) {
+                    const char* e = s + 1;
+                    bool negativeExponent = false;
+
+                    if (e != last && (*e == '+' || *e == '-')) {
+                        negativeExponent = (*e == '-');
+                        ++e;
+                    }
+
+                    if (e != last && isDigit (*e)) {
+                        // an exponent that does not fit into an int is no exponent for Spirit
+                        const boost::int64_t bound = negativeExponent ? boost::int64_t (1) << 31 : (boost::int64_t (1) << 31) - 1;
+                        boost::int64_t explicitExponent = 0;
+                        while (e != last && isDigit (*e)) {
+                            explicitExponent = explicitExponent * 10 + (*e - '0');
+                            if (explicitExponent > bound)
+                                return false;
+                            ++e;
+                        }
+                        exponent = static_cast<int> (std::max<boost::int64_t> (-100000, exponent + (negativeExponent ? -explicitExponent : explicitExponent)));
+                        s = e;
+                    }
+                }
+
+                // as Spirit, refuse numbers whose decimal exponent is out of range
+                if (exponent > std::numeric_limits<double>::max_exponent10)
+                    return false;
+
+                if (mantissa == 0) {
+                    value = 0.0;
+                } else if (!truncated && mantissa <= (boost::uint64_t (1) << 53) && exponent >= -22 && exponent <= 22) {
+                    // both factors are exact, so one rounding step gives the correct result
+                    value = static_cast<double> (mantissa);
+                    if (exponent < 0)
+                        value /= powersOfTen()[-exponent];
+                    else
+                        value *= powersOfTen()[exponent];
+                } else if (truncated || !extendedParseDouble (mantissa, exponent, value)) {
+                    value = slowParseDouble (negative ? p + 1 : p, s);
+                }
+
+                if (negative)
+                    value = -value;
+
+                p = s;
+                return true;
+            }
+
+
+        private:
+
+            static inline bool isDigit (char c) {
+                return (c >= '0') && (c <= '9');
+            }
+
+
+            /// \brief whitespace as understood by the Spirit space skipper
+            static inline bool isSpace (char c) {
+                return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n') || (c == '\v') || (c == '\f');
+            }
+
+
+            static inline void skipSpace (const char* &p, const char* last) {
+                while (p != last && isSpace (*p))
+                    ++p;
+            }
+
+
+
+            static inline bool parseInt (const char* &p, const char* last, int &value) {
+                const char* s = p;
+                bool negative = false;
+
+                if (s != last && (*s == '+' || *s == '-')) {
+                    negative = (*s == '-');
+                    ++s;
+                }
+
+                if (s == last || !isDigit (*s))
+                    return false;
+
+                const boost::int64_t bound = negative ? -boost::int64_t (std::numeric_limits<int>::min()) : std::numeric_limits<int>::max();
+                boost::int64_t v = 0;
+                while (s != last && isDigit (*s)) {
+                    v = v * 10 + (*s - '0');
+                    if (v > bound)
+                        return false;
+                    ++s;
+                }
+
+                value = static_cast<int> (negative ? -v : v);
+                p = s;
+                return true;
+            }
+
+
+
+            static inline bool parseUnsigned (const char* &p, const char* last, unsigned int &value) {
+                const char* s = p;
+
+                if (s == last || !isDigit (*s))
+                    return false;
+
+                boost::uint64_t v = 0;
+                while (s != last && isDigit (*s)) {
+                    v = v * 10 + (*s - '0');
+                    if (v > std::numeric_limits<unsigned int>::max())
+                        return false;
+                    ++s;
+                }
+
+                value = static_cast<unsigned int> (v);
+                p = s;
+                return true;
+            }
+
+
+
+            /// \brief case insensitive prefix match, advances p on success
+            static bool matchWord (const char* &p, const char* last, const char* word) {
+                const char* s = p;
+                for (; *word != 0; ++word, ++s) {
+                    if (s == last || (*s | 0x20) != *word)
+                        return false;
+                }
+                p = s;
+                return true;
+            }
+
+
+
+            /// \brief nan, nan(...), inf and infinity as accepted by Spirit
+            static bool parseSpecial (const char* &p, const char* last, double &value) {
+                const char* s = p;
+
+                if (matchWord (s, last, "nan")) {
+                    if (s != last && *s == '(') {
+                        const char* closing = s;
+                        while (++closing != last && *closing != ')')
+                            ;
+                        if (closing == last)
+                            return false;
+                        s = closing + 1;
+                    }
+                    value = std::numeric_limits<double>::quiet_NaN();
+                    p = s;
+                    return true;
+                }
+
+                if (matchWord (s, last, "inf")) {
+                    matchWord (s, last, "inity");
+                    value = std::numeric_limits<double>::infinity();
+                    p = s;
+                    return true;
+                }
+
+                return false;
+            }
+
+
+
+            /// \brief Exact conversion of up to 19 digits with a 64 bit long double mantissa.
+            ///
+            /// \par
+            /// The mantissa and 10^|exponent| (up to 10^27) are exact, so the long double
+            /// is rounded once. Rounding it again to double only goes wrong if it lies
+            /// exactly on a midpoint between two doubles; then, and on platforms where
+            /// long double is just a double, false is returned.
+            ///
+            static bool extendedParseDouble (boost::uint64_t mantissa, int exponent, double &value) {
+                static const long double powers[] = {
+                    1e0L, 1e1L, 1e2L, 1e3L, 1e4L, 1e5L, 1e6L, 1e7L, 1e8L, 1e9L, 1e10L,
+                    1e11L, 1e12L, 1e13L, 1e14L, 1e15L, 1e16L, 1e17L, 1e18L, 1e19L, 1e20L,
+                    1e21L, 1e22L, 1e23L, 1e24L, 1e25L, 1e26L, 1e27L
+                };
+
+                if ((std::numeric_limits<long double>::digits < 64) || (exponent < -27) || (exponent > 27))
+                    return false;
+
+                long double exact = static_cast<long double> (mantissa);
+                if (exponent < 0)
+                    exact /= powers[-exponent];
+                else
+                    exact *= powers[exponent];
+
+                // exact lies on a midpoint iff it is as far from rounded as from the
+                // next double on the other side, i.e. iff rounded + 2 * rest is a double
+                double rounded = static_cast<double> (exact);
+                long double rest = exact - rounded;
+                long double mirrored = rounded + 2 * rest;
+                if ((rest != 0) && (static_cast<double> (mirrored) == mirrored))
+                    return false;
+
+                value = rounded;
+                return true;
+            }
+
+
+
+            /// \brief exact conversion for the numbers the fast path cannot handle,
+            /// e.g. the 17 digit values of round trip output.
+            /// strtod is exact and cheap, but it follows the C locale, so on a german
+            /// desktop we fall back to a stream with the classic locale.
+            static double slowParseDouble (const char* first, const char* last) {
+                char buffer[64];
+                std::size_t length = last - first;
+                if ((length < sizeof (buffer)) && (*std::localeconv()->decimal_point == '.')) {
+                    std::memcpy (buffer, first, length);
+                    buffer[length] = 0;
+                    return std::strtod (buffer, NULL);
+                }
+
+                std::istringstream iss (std::string (first, last));
+                iss.imbue (std::locale::classic());
+                double value = 0.0;
+                iss >> value;
+
+                // the stream refuses numbers that overflow; mimic what the fast path would do
+                if (iss.fail()) {
+                    bool tiny = false;
+                    for (const char* c = first; c != last; ++c) {
+                        if ((*c == 'e' || *c == 'E') && (c + 1 != last) && (*(c + 1) == '-'))
+                            tiny = true;
+                    }
+                    value = tiny ? 0.0 : std::numeric_limits<double>::infinity();
+                }
+
+                return value;
+            }
+
+
+
+            static const double* powersOfTen() {
+                static const double table[] = {
+                    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10,
+                    1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20,
+                    1e21, 1e22
+                };
+                return table;
+            }
+
+
+
+            static void parseError (const char* first, const char* last) {
+                std::cout << std::string (first, last) << std::endl;
+                throw SHARKSVMEXCEPTION ("Problems parsing the sparse data file.");
+            }
+    };
+
+}
+
+
+#endif
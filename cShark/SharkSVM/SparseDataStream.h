@@ -0,0 +1,453 @@
+//===========================================================================
+/*!
+ *
+ *
+ * \brief       Streaming access to sparse data files that do not fit into memory
+ *
+ *
+ *
+ * \author      Aydin Demircioglu
+ * \date        2015
+ *
+ *
+ * \par Copyright 1995-2015 Shark Development Team
+ *
+ * <BR><HR>
+ * This file is part of Shark.
+ * <http://image.diku.dk/shark/>
+ *
+ * Shark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Shark.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+//===========================================================================
+
+#ifndef SHARKSVM_SPARSEDATASTREAM_H
+#define SHARKSVM_SPARSEDATASTREAM_H
+
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <boost/noncopyable.hpp>
+#include <boost/thread.hpp>
+
+#include "SharkSVM.h"
+#include "LabelOrder.h"
+#include "SparseDataParser.h"
+
+
+namespace shark {
+
+
+    /// \brief Reads a sparse data (libSVM) file point by point with constant memory.
+    ///
+    /// \par
+    /// A background thread parses the file and keeps a bounded window of rows
+    /// ready in a ring buffer; next() hands them out in file order. At the end
+    /// of the file the stream either starts over or stops. Memory is bounded by
+    /// the window and the read buffer, independent of the size of the file.
+    ///
+    /// \par
+    /// Labels are normalized in the order they are first seen, which is the
+    /// order SparseDataModel would find. If no dimension is given, the file is
+    /// scanned once beforehand to find it; this scan keeps only statistics.
+    /// It costs a full parse of the file and open() blocks until it is done,
+    /// so for large files the dimension should be given.
+    ///
+    /// \par
+    /// Errors do not stick: a row with an index beyond the dimension is dropped
+    /// when next() reports it, and a parse error of the reader is reported once,
+    /// after the rows before it, then the stream ends.
+    ///
+    template <class InputType>
+    class SparseDataStream : boost::noncopyable {
+        public:
+
+            SparseDataStream() : m_dimensions (0),
+                m_delta (1),
+                m_wrapAround (false),
+                m_open (false),
+                m_stop (false),
+                m_finished (false),
+                m_head (0),
+                m_count (0) {}
+
+
+            virtual ~SparseDataStream() {
+                close();
+            }
+
+
+
+            /// \brief Start streaming the given file.
+            ///
+            /// \param  fn          file to stream
+            /// \param  window      number of rows read ahead
+            /// \param  wrapAround  if true, start over at the end of the file, else stop
+            /// \param  dimensions  highest feature index, or 0 for auto-detection
+            ///                     by parsing the whole file once before streaming starts;
+            ///                     as for the import, a file with index 0 gets one more
+            ///                     dimension, so given or not, the points are the same
+            ///
+            void open (std::string const &fn,
+                       std::size_t window = 1024,
+                       bool wrapAround = true,
+                       unsigned int dimensions = 0) {
+                close();
+
+                {
+                    std::ifstream ifs (fn.c_str());
+                    if (! ifs.good())
+                        throw SHARKSVMEXCEPTION ("Failed to open file for input");
+                }
+
+                m_filename = fn;
+                m_wrapAround = wrapAround;
+                m_statistics = SparseDataStatistics();
+
+                if (dimensions == 0) {
+                    // one pass to find the dimension, this also fixes the label order
+                    readFile (ScanStatistics (m_statistics));
+                    m_dimensions = m_statistics.maxIndex;
+                    m_delta = m_statistics.hasZero ? 0 : 1;
+                    m_dimensions += 1 - m_delta;
+                } else {
+                    // the layout still depends on whether the indices start at 0,
+                    // the scan stops at the first index 0 it sees
+                    try {
+                        readFile (ScanForZeroIndex (m_statistics));
+                    } catch (SharkSVMException const&) {
+                        // next() reports the broken line when it gets there
+                    }
+                    m_delta = m_statistics.hasZero ? 0 : 1;
+                    m_dimensions = dimensions + 1 - m_delta;
+                }
+
+                m_rows.assign (std::max<std::size_t> (window, 1), Row());
+                m_head = 0;
+                m_count = 0;
+                m_stop = false;
+                m_finished = false;
+                m_error = std::exception_ptr();
+
+                m_thread = boost::thread (&SparseDataStream::readAhead, this);
+                m_open = true;
+            }
+
+
+
+            /// \brief Stop the background thread and release the window.
+            void close() {
+                if (m_open == false)
+                    return;
+
+                {
+                    boost::mutex::scoped_lock lock (m_mutex);
+                    m_stop = true;
+                }
+                m_notFull.notify_all();
+                m_thread.join();
+
+                std::vector<Row>().swap (m_rows);
+                m_open = false;
+            }
+
+
+
+            /// \brief Fetch the next point, blocks until the reader caught up.
+            ///
+            /// \param[out] point   the next point
+            /// \param[out] label   its normalized label
+            /// \return false if the stream stopped at the end of the file
+            ///
+            bool next (InputType &point, unsigned int &label) {
+                std::size_t index = 0;
+                return next (point, label, index);
+            }
+
+
+
+            /// \brief Fetch the next point and its position in the file.
+            ///
+            /// \param[out] point   the next point
+            /// \param[out] label   its normalized label
+            /// \param[out] index   number of the row in the file, starting at 0 again after wrapping around
+            /// \return false if the stream stopped at the end of the file
+            /// \throws SharkSVMException for a row that does not fit the dimension (the row is
+            ///         dropped), or once for a parse error of the reader (the stream then ends)
+            ///
+            bool next (InputType &point, unsigned int &label, std::size_t &index) {
+                if (m_open == false)
+                    return false;
+
+                boost::mutex::scoped_lock lock (m_mutex);
+                while ((m_count == 0) && (m_finished == false))
+                    m_notEmpty.wait (lock);
+
+                if (m_count == 0) {
+                    // the reader stopped; hand over its error only once, afterwards the stream just ended
+                    if (m_error) {
+                        std::exception_ptr error = m_error;
+                        m_error = std::exception_ptr();
+                        std::rethrow_exception (error);
+                    }
+                    return false;
+                }
+
+                Row &row = m_rows[m_head];
+                bool fits = true;
+                point = InputType (m_dimensions);
+                point.clear();
+                for (std::size_t j = 0; j != row.indices.size(); ++j) {
+                    std::size_t index = std::size_t (row.indices[j]) - m_delta;
+                    if ((row.indices[j] < m_delta) || (index >= m_dimensions)) {
+                        fits = false;
+                        break;
+                    }
+                    point (index) = row.values[j];
+                }
+
+                if (fits) {
+                    m_statistics.addLabel (row.label);
+                    label = m_statistics.labelPosition (row.label);
+                    index = row.index;
+                }
+
+                // the row is consumed either way, else every later call would fail on it again
+                m_head = (m_head + 1) % m_rows.size();
+                --m_count;
+                lock.unlock();
+                m_notFull.notify_one();
+
+                if (!fits)
+                    throw SHARKSVMEXCEPTION ("Number of dimensions supplied is smaller than actual index data");
+
+                return true;
+            }
+
+
+
+            /// \brief is a file being streamed?
+            bool isOpen() const {
+                return m_open;
+            }
+
+
+            /// \brief dimension of the points
+            std::size_t dimensions() const {
+                return m_dimensions;
+            }
+
+
+            /// \brief the labels seen so far (all of them, if the dimension was detected)
+            void getLabelOrder (LabelOrder &labelOrder) {
+                boost::mutex::scoped_lock lock (m_mutex);
+                std::vector<int> order = m_statistics.labelOrder;
+                labelOrder.setLabelOrder (order);
+            }
+
+
+        private:
+
+            /// \brief One parsed row, the vectors keep their memory when the slot is reused.
+            struct Row {
+                Row() : label (0), index (0) {}
+
+                int label;
+                std::size_t index;
+                std::vector<unsigned int> indices;
+                std::vector<double> values;
+            };
+
+
+
+            /// \brief Sink that only merges the statistics of every buffer.
+            struct ScanStatistics {
+                explicit ScanStatistics (SparseDataStatistics &statistics) : m_statistics (&statistics) {}
+
+                bool operator() (SparseDataArena const &arena) const {
+                    m_statistics->merge (arena.statistics);
+                    return true;
+                }
+
+                SparseDataStatistics *m_statistics;
+            };
+
+
+
+            /// \brief Sink that merges the statistics until a buffer contains index 0.
+            struct ScanForZeroIndex {
+                explicit ScanForZeroIndex (SparseDataStatistics &statistics) : m_statistics (&statistics) {}
+
+                bool operator() (SparseDataArena const &arena) const {
+                    m_statistics->merge (arena.statistics);
+                    return !m_statistics->hasZero;
+                }
+
+                SparseDataStatistics *m_statistics;
+            };
+
+
+
+            /// \brief Sink that hands all rows of a buffer to the ring.
+            struct FillRing {
+                explicit FillRing (SparseDataStream *stream) : m_stream (stream), m_row (0) {}
+
+                bool operator() (SparseDataArena const &arena) const {
+                    for (std::size_t i = 0; i != arena.numberOfRows(); ++i, ++m_row) {
+                        if (!m_stream->push (arena, i, m_row))
+                            return false;
+                    }
+                    return true;
+                }
+
+                SparseDataStream *m_stream;
+
+                /// rows of the file passed on so far
+                mutable std::size_t m_row;
+            };
+
+
+
+            /// \brief Parse the file buffer by buffer and pass every parsed buffer to the sink.
+            /// \return the number of rows read, or 0 if the sink stopped early
+            ///
+            template <class Sink>
+            std::size_t readFile (Sink sink) {
+                std::ifstream stream (m_filename.c_str(), std::ios::binary);
+                if (!stream)
+                    throw SHARKSVMEXCEPTION ("Failed to open file for input");
+
+                std::vector<char> buffer (1024 * 1024);
+                std::size_t carry = 0;
+                std::size_t rows = 0;
+                SparseDataArena arena;
+
+                while (true) {
+                    stream.read (&buffer[carry], buffer.size() - carry);
+                    std::size_t filled = carry + static_cast<std::size_t> (stream.gcount());
+                    bool atEnd = !stream;
+
+                    const char* begin = &buffer[0];
+                    const char* rest = begin;
+                    arena.clear();
+                    try {
+                        rest = SparseDataParser::parse (begin, begin + filled, atEnd, arena);
+                    } catch (...) {
+                        // the rows before the broken line are fine, pass them on first
+                        sink (arena);
+                        throw;
+                    }
+
+                    rows += arena.numberOfRows();
+                    if (!sink (arena))
+                        return 0;
+
+                    if (atEnd)
+                        break;
+
+                    // move the incomplete last line to the front, grow if one line fills the whole buffer
+                    carry = filled - (rest - begin);
+                    std::memmove (&buffer[0], rest, carry);
+                    if (carry == buffer.size())
+                        buffer.resize (2 * buffer.size());
+                }
+
+                return rows;
+            }
+
+
+
+            /// \brief Body of the background thread.
+            void readAhead() {
+                try {
+                    while (true) {
+                        std::size_t rows = readFile (FillRing (this));
+
+                        // stopped, at the end, or nothing to repeat
+                        if ((rows == 0) || (m_wrapAround == false))
+                            break;
+                    }
+                } catch (...) {
+                    boost::mutex::scoped_lock lock (m_mutex);
+                    m_error = std::current_exception();
+                }
+
+                {
+                    boost::mutex::scoped_lock lock (m_mutex);
+                    m_finished = true;
+                }
+                m_notEmpty.notify_all();
+            }
+
+
+
+            /// \brief Copy row i of the arena, row number index of the file, into the ring.
+            /// blocks while the ring is full.
+            /// \return false if the stream is being closed
+            ///
+            bool push (SparseDataArena const &arena, std::size_t i, std::size_t index) {
+                boost::mutex::scoped_lock lock (m_mutex);
+                while ((m_count == m_rows.size()) && (m_stop == false))
+                    m_notFull.wait (lock);
+
+                if (m_stop == true)
+                    return false;
+
+                Row &row = m_rows[(m_head + m_count) % m_rows.size()];
+                row.label = arena.labels[i];
+                row.index = index;
+                row.indices.assign (arena.indices.begin() + arena.rowPointers[i], arena.indices.begin() + arena.rowPointers[i + 1]);
+                row.values.assign (arena.values.begin() + arena.rowPointers[i], arena.values.begin() + arena.rowPointers[i + 1]);
+
+                ++m_count;
+                lock.unlock();
+                m_notEmpty.notify_one();
+
+                return true;
+            }
+
+
+
+            std::string m_filename;
+
+            /// dimension of the points and offset of the first feature index
+            std::size_t m_dimensions;
+            std::size_t m_delta;
+
+            bool m_wrapAround;
+
+            bool m_open;
+
+            /// statistics of the labels handed out so far, used for normalizing
+            SparseDataStatistics m_statistics;
+
+            /// the background reader and the ring buffer it fills
+            boost::thread m_thread;
+            boost::mutex m_mutex;
+            boost::condition_variable m_notEmpty;
+            boost::condition_variable m_notFull;
+            bool m_stop;
+            bool m_finished;
+            std::exception_ptr m_error;
+            std::vector<Row> m_rows;
+            std::size_t m_head;
+            std::size_t m_count;
+    };
+
+}
+
+#endif
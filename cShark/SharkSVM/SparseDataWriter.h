@@ -0,0 +1,208 @@
+//===========================================================================
+/*!
+ *
+ *
+ * \brief       Fast formatting of sparse data (libSVM) lines
+ *
+ *
+ *
+ * \author      Aydin Demircioglu
+ * \date        2015
+ *
+ *
+ * \par Copyright 1995-2015 Shark Development Team
+ *
+ * <BR><HR>
+ * This file is part of Shark.
+ * <http://image.diku.dk/shark/>
+ *
+ * Shark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Shark.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+//===========================================================================
+
+#ifndef SHARKSVM_SPARSEDATAWRITER_H
+#define SHARKSVM_SPARSEDATAWRITER_H
+
+#include <clocale>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+#include <boost/math/special_functions/fpclassify.hpp>
+
+
+namespace shark {
+
+
+    /// \brief Formats points as sparse data (libSVM) lines into a string.
+    ///
+    /// \par
+    /// Values are written with the fewest significant digits that still read
+    /// back to exactly the same double, integral values without any digits
+    /// after the point. The output does not depend on the locale.
+    ///
+    class SparseDataWriter {
+        public:
+
+            /// \brief Append a line (including the line break) for one point.
+            ///
+            /// \param  out     string the line is appended to
+            /// \param  label   label as it should appear in the file
+            /// \param  input   the point, only its stored entries are visited
+            /// \param  dense   if true, all entries up to dim are written, zeros included,
+            ///                 else only the non-zero entries
+            /// \param  dim     dimension of the data, used for dense output
+            ///
+            template <class Input>
+            static void formatLine (std::string &out, long long label, Input const &input, bool dense, std::size_t dim) {
+                char buffer[64];
+                char* p = formatInteger (label, buffer);
+                *p++ = ' ';
+                out.append (buffer, p);
+
+                std::size_t next = 0;
+                for (typename Input::const_iterator it = input.begin(); it != input.end(); ++it) {
+                    if (dense) {
+                        for (; next < it.index(); ++next)
+                            appendEntry (out, next, 0.0);
+                    }
+
+                    if (dense || *it != 0)
+                        appendEntry (out, it.index(), *it);
+
+                    next = it.index() + 1;
+                }
+
+                if (dense) {
+                    for (; next < dim; ++next)
+                        appendEntry (out, next, 0.0);
+                }
+
+                out += '\n';
+            }
+
+
+
+            /// \brief Write an integer, returns the end of the written characters.
+            static char* formatInteger (long long value, char* out) {
+                unsigned long long magnitude = (value < 0) ? 0ULL - static_cast<unsigned long long> (value) : static_cast<unsigned long long> (value);
+
+                if (value < 0)
+                    *out++ = '-';
+
+                char digits[24];
+                char* d = digits;
+                do {
+                    *d++ = static_cast<char> ('0' + magnitude % 10);
+                    magnitude /= 10;
+                } while (magnitude != 0);
+
+                while (d != digits)
+                    *out++ = *--d;
+
+                return out;
+            }
+
+
+
+            /// \brief Write a double with the shortest representation that reads back exactly.
+            /// the output buffer must hold at least 32 characters.
+            ///
+            static char* formatDouble (double value, char* out) {
+                // integral values (0/1 features, counts) are very common
+                if ((value == std::floor (value)) && (std::fabs (value) < 1e15))
+                    return formatInteger (static_cast<long long> (value), out);
+
+                // fast path: find the fewest decimals k such that m / 10^k is value again.
+                // m and 10^k are exact doubles, so the division is rounded just like
+                // strtod rounds the decimal m * 10^-k, i.e. the string reads back exactly.
+                double magnitude = std::fabs (value);
+                if ((magnitude >= 1e-5) && (magnitude < 1e15)) {
+                    static const double powersOfTen[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8,
+                                                         1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17};
+
+                    for (int k = 1; k != 18; ++k) {
+                        double scaled = std::floor (magnitude * powersOfTen[k] + 0.5);
+                        if (scaled >= 9007199254740992.0)
+                            break;
+
+                        if (scaled / powersOfTen[k] == magnitude)
+                            return formatFixed (value < 0, static_cast<unsigned long long> (scaled), k, out);
+                    }
+                }
+
+                int length = std::snprintf (out, 32, "%.15g", value);
+
+                if (boost::math::isfinite (value)) {
+                    if (std::strtod (out, NULL) != value)
+                        length = std::snprintf (out, 32, "%.16g", value);
+                    if (std::strtod (out, NULL) != value)
+                        length = std::snprintf (out, 32, "%.17g", value);
+                }
+
+                // printf follows the C locale, a qt application might have changed it
+                char point = *std::localeconv()->decimal_point;
+                if (point != '.') {
+                    for (int i = 0; i != length; ++i) {
+                        if (out[i] == point)
+                            out[i] = '.';
+                    }
+                }
+
+                return out + length;
+            }
+
+
+        private:
+
+            /// \brief write mantissa * 10^-decimals with a decimal point
+            static char* formatFixed (bool negative, unsigned long long mantissa, int decimals, char* out) {
+                char digits[24];
+                int count = 0;
+                do {
+                    digits[count++] = static_cast<char> ('0' + mantissa % 10);
+                    mantissa /= 10;
+                } while ((mantissa != 0) || (count <= decimals));
+
+                if (negative)
+                    *out++ = '-';
+
+                while (count > decimals)
+                    *out++ = digits[--count];
+                *out++ = '.';
+                while (count > 0)
+                    *out++ = digits[--count];
+
+                return out;
+            }
+
+
+
+            /// \brief append " index:value", the index is written one-based
+            static void appendEntry (std::string &out, std::size_t index, double value) {
+                char buffer[64];
+                char* p = buffer;
+                *p++ = ' ';
+                p = formatInteger (static_cast<long long> (index) + 1, p);
+                *p++ = ':';
+                p = formatDouble (value, p);
+                out.append (buffer, p);
+            }
+    };
+
+}
+
+#endif
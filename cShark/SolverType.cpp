@@ -0,0 +1,76 @@
+/*======================================================================================================================
+
+    Copyright 2011, 2012, 2013, 2014, 2015 Institut fuer Neuroinformatik, Ruhr-Universitaet Bochum, Germany
+ 
+    This file is part of cedar.
+
+    cedar is free software: you can redistribute it and/or modify it under
+    the terms of the GNU Lesser General Public License as published by the
+    Free Software Foundation, either version 3 of the License, or (at your
+    option) any later version.
+
+    cedar is distributed in the hope that it will be useful, but WITHOUT ANY
+    WARRANTY; without even the implied warranty of MERCHANTABILITY or
+    FITNESS FOR A PARTICULAR PURPOSE. See the GNU Lesser General Public
+    License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with cedar. If not, see <http://www.gnu.org/licenses/>.
+
+========================================================================================================================
+
+    Institute:   Ruhr-Universitaet Bochum
+                 Institut fuer Neuroinformatik
+
+    File:        SolverType.cpp
+
+    Maintainer:  aydin demircioglu
+    Email:       aydin.demircioglu@ini.rub.de
+    Date:        2015 01 20
+
+    Description: Source file for the class cShark::SolverType.
+
+    Credits:
+
+======================================================================================================================*/
+
+// CEDAR CONFIGURATION
+#include "cedar/configuration.h"
+
+// CLASS HEADER
+#include "SolverType.h"
+
+// CEDAR INCLUDES
+
+// SYSTEM INCLUDES
+
+//----------------------------------------------------------------------------------------------------------------------
+// static members
+//----------------------------------------------------------------------------------------------------------------------
+
+cedar::aux::EnumType<cShark::SolverType> cShark::SolverType::mType("cShark::SolverType::");
+
+#ifndef CEDAR_COMPILER_MSVC
+const cShark::SolverType::Id cShark::SolverType::Liblinear;
+const cShark::SolverType::Id cShark::SolverType::Smo;
+#endif // CEDAR_COMPILER_MSVC
+
+//----------------------------------------------------------------------------------------------------------------------
+// methods
+//----------------------------------------------------------------------------------------------------------------------
+
+void cShark::SolverType::construct()
+{
+  mType.type()->def(cedar::aux::Enum(Liblinear, "Liblinear", "Linear (dual coordinate descent)"));
+  mType.type()->def(cedar::aux::Enum(Smo, "Smo", "Gaussian kernel (SMO)"));
+}
+
+const cedar::aux::EnumBase& cShark::SolverType::type()
+{
+  return *cShark::SolverType::mType.type();
+}
+
+const cShark::SolverType::TypePtr& cShark::SolverType::typePtr()
+{
+  return cShark::SolverType::mType.type();
+}
@@ -48,15 +48,204 @@
 using namespace shark;
 
 
+namespace
+{
+	// copy the stored entries of a point into a row of a cleared batch
+	template <class Matrix, class Vector>
+	void copyRow(Matrix& batch, std::size_t r, const Vector& point)
+	{
+		for (typename Vector::const_iterator it = point.begin(); it != point.end(); ++it) {
+			batch(r, it.index()) = *it;
+		}
+	}
+
+
+
+	// give the batch the requested shape, its memory is reused if the shape did not change
+	template <class Matrix>
+	void resetBatch(Matrix& batch, std::size_t rows, std::size_t columns)
+	{
+		if (batch.size1() != rows || batch.size2() != columns) {
+			batch = Matrix(rows, columns);
+		}
+		batch.clear();
+	}
+
+
+
+	// collect the labels of a loaded dataset, batch by batch
+	template <class InputType>
+	void collectLabels(const LabeledData<InputType, unsigned int>& data, std::vector<unsigned int>& labels)
+	{
+		labels.reserve (data.numberOfElements());
+		for (std::size_t b = 0; b < data.numberOfBatches(); ++b) {
+			const UIntVector& batchLabels = data.labels().batch (b);
+			labels.insert (labels.end(), batchLabels.begin(), batchLabels.end());
+		}
+	}
+
+
+
+	// note batch and row of every point, element() would walk the batches for each lookup
+	template <class InputType>
+	void collectPositions(const LabeledData<InputType, unsigned int>& data, std::vector<std::pair<std::size_t, std::size_t> >& positions)
+	{
+		positions.clear();
+		positions.reserve (data.numberOfElements());
+		for (std::size_t b = 0; b < data.numberOfBatches(); ++b) {
+			std::size_t rows = data.labels().batch (b).size();
+			for (std::size_t r = 0; r < rows; ++r) {
+				positions.push_back (std::make_pair (b, r));
+			}
+		}
+	}
+
+
+
+	// take the next points of a loaded dataset in the order of the scheduler, across epochs
+	template <class InputType, class Matrix>
+	std::size_t nextBatch
+	(
+		const LabeledData<InputType, unsigned int>& data,
+		EpochScheduler& scheduler,
+		const std::vector<std::pair<std::size_t, std::size_t> >& positions,
+		std::size_t batchSize,
+		InputType& point,
+		std::size_t& index,
+		Matrix& batch,
+		UIntVector& labels
+	)
+	{
+		// nothing loaded yet, or nothing in our shard
+		if (data.numberOfElements() == 0 || scheduler.epochLength() == 0) {
+			return 0;
+		}
+
+		resetBatch (batch, batchSize, inputDimension (data));
+		if (labels.size() != batchSize) {
+			labels = UIntVector(batchSize);
+		}
+
+		for (std::size_t r = 0; r < batchSize; ++r) {
+			std::size_t current = scheduler.next();
+			const std::pair<std::size_t, std::size_t>& position = positions[current];
+			const typename Batch<InputType>::type& inputs = data.inputs().batch (position.first);
+
+			// straight from the stored batch, only the single point output gets a copy
+			copyRow (batch, r, row (inputs, position.second));
+			labels(r) = data.labels().batch (position.first)(position.second);
+
+			if (r + 1 == batchSize) {
+				point = row (inputs, position.second);
+				index = current;
+			}
+		}
+
+		return batchSize;
+	}
+
+
+
+	// take the next points of a stream, the batch is shorter at the end of the stream
+	template <class InputType, class Matrix>
+	std::size_t nextBatch
+	(
+		SparseDataStream<InputType>& stream,
+		std::size_t batchSize,
+		InputType& point,
+		std::size_t& index,
+		Matrix& batch,
+		UIntVector& labels
+	)
+	{
+		std::vector<InputType> points;
+		std::vector<unsigned int> streamLabels;
+		InputType next;
+		unsigned int label = 0;
+		std::size_t row = 0;
+
+		while (points.size() < batchSize) {
+			try {
+				if (stream.next (next, label, row) == false) {
+					break;
+				}
+			} catch (const std::exception& e) {
+				// the stream already dropped the broken row (or ended after a parse error), so go on
+				cedar::aux::LogSingleton::getInstance()->warning ("Row of the stream skipped: " + std::string(e.what()), "cShark::SparseData::compute()");
+				continue;
+			}
+
+			points.push_back (next);
+			streamLabels.push_back (label);
+			index = row;
+		}
+
+		// at the end of the stream nothing changes anymore
+		if (points.empty() == true) {
+			return 0;
+		}
+
+		resetBatch (batch, points.size(), stream.dimensions());
+		labels = UIntVector(points.size());
+
+		for (std::size_t r = 0; r < points.size(); ++r) {
+			copyRow (batch, r, points[r]);
+			labels(r) = streamLabels[r];
+		}
+
+		point = points.back();
+		return points.size();
+	}
+}
+
+
+
 cShark::SparseData::SparseData():
 	mOutput(new CedarRealVector()),
-	mFilename(new cedar::aux::FileParameter(this, "Filename", cedar::aux::FileParameter::READ, "none"))
+	mSparseOutput(new CedarCompressedRealVector()),
+	mLabel(new CedarLabel(0)),
+	mIndex(new CedarIndex(0)),
+	mDataGeneration(new CedarIndex(0)),
+	mBatchOutput(new CedarRealMatrix()),
+	mSparseBatchOutput(new CedarCompressedRealMatrix()),
+	mBatchLabels(new CedarUIntVector()),
+	mDataset(new CedarSVMData()),
+	mSparseDataset(new CedarSparseSVMData()),
+	mFilename(new cedar::aux::FileParameter(this, "Filename", cedar::aux::FileParameter::READ, "none")),
+	mSparse(new cedar::aux::BoolParameter(this, "Sparse Output", false)),
+	mBinaryCache(new cedar::aux::BoolParameter(this, "Binary Cache", false)),
+	mDimensions(new cedar::aux::UIntParameter(this, "Dimensions", 0)),
+	mStreaming(new cedar::aux::BoolParameter(this, "Streaming", false)),
+	mStreamWindow(new cedar::aux::UIntParameter(this, "Stream Window", 1024, cedar::aux::UIntParameter::LimitType::fromLower(1))),
+	mWrapAround(new cedar::aux::BoolParameter(this, "Wrap Around", true)),
+	mBatchSize(new cedar::aux::UIntParameter(this, "Batch Size", 1, cedar::aux::UIntParameter::LimitType::fromLower(1))),
+	mEpochMode(new cedar::aux::EnumParameter(this, "Epoch Mode", cShark::EpochMode::typePtr(), cShark::EpochMode::Sequential)),
+	mShardIndex(new cedar::aux::UIntParameter(this, "Shard Index", 0)),
+	mNumberOfShards(new cedar::aux::UIntParameter(this, "Number of Shards", 1, cedar::aux::UIntParameter::LimitType::fromLower(1)))
 {
 	// declare all data
 	this->declareOutput("output", mOutput);
+	this->declareOutput("sparse output", mSparseOutput);
+	this->declareOutput("label", mLabel);
+	this->declareOutput("index", mIndex);
+	this->declareOutput("data generation", mDataGeneration);
+	this->declareOutput("batch", mBatchOutput);
+	this->declareOutput("sparse batch", mSparseBatchOutput);
+	this->declareOutput("batch labels", mBatchLabels);
+	this->declareOutput("dataset", mDataset);
+	this->declareOutput("sparse dataset", mSparseDataset);
 
 	// do all connections
 	QObject::connect(mFilename.get(), SIGNAL(valueChanged()), this, SLOT(updateFilename()));
+	QObject::connect(mSparse.get(), SIGNAL(valueChanged()), this, SLOT(updateFilename()));
+	QObject::connect(mBinaryCache.get(), SIGNAL(valueChanged()), this, SLOT(updateFilename()));
+	QObject::connect(mDimensions.get(), SIGNAL(valueChanged()), this, SLOT(updateFilename()));
+	QObject::connect(mStreaming.get(), SIGNAL(valueChanged()), this, SLOT(updateFilename()));
+	QObject::connect(mStreamWindow.get(), SIGNAL(valueChanged()), this, SLOT(updateFilename()));
+	QObject::connect(mWrapAround.get(), SIGNAL(valueChanged()), this, SLOT(updateFilename()));
+	QObject::connect(mEpochMode.get(), SIGNAL(valueChanged()), this, SLOT(updateEpochMode()));
+	QObject::connect(mShardIndex.get(), SIGNAL(valueChanged()), this, SLOT(updateEpochMode()));
+	QObject::connect(mNumberOfShards.get(), SIGNAL(valueChanged()), this, SLOT(updateEpochMode()));
   
 //	input->setCheck(cedar::proc::typecheck::IsMatrix());
 }
@@ -69,23 +258,104 @@ void cShark::SparseData::updateFilename()
 
 	// change filename
 	std::string trainingDataPath = mFilename->getPath();
-	mTrainingData = sparseDataHandler.importData (trainingDataPath, mLabelOrder);
+
+	// reuse the parsed data of earlier runs, if the file did not change
+	sparseDataHandler.setUseCache (mBinaryCache->getValue());
+	sparseSparseDataHandler.setUseCache (mBinaryCache->getValue());
+
+	// only one of the representations is kept
+	mStream.close();
+	mSparseStream.close();
+	mTrainingData = LabeledData<RealVector, unsigned int>();
+	mSparseTrainingData = LabeledData<CompressedRealVector, unsigned int>();
+
+	unsigned int dimensions = mDimensions->getValue();
+
+	if (mStreaming->getValue() == true) {
+		if (mSparse->getValue() == true) {
+			mSparseStream.open (trainingDataPath, mStreamWindow->getValue(), mWrapAround->getValue(), dimensions);
+			mSparseStream.getLabelOrder (mLabelOrder);
+		} else {
+			mStream.open (trainingDataPath, mStreamWindow->getValue(), mWrapAround->getValue(), dimensions);
+			mStream.getLabelOrder (mLabelOrder);
+		}
+	} else if (mSparse->getValue() == true) {
+		mSparseTrainingData = sparseSparseDataHandler.importData (trainingDataPath, mLabelOrder, true, dimensions);
+	} else {
+		mTrainingData = sparseDataHandler.importData (trainingDataPath, mLabelOrder, true, dimensions);
+	}
+
+	// the batches are shared with the dataset output, not copied
+	this->mDataset->setData (mTrainingData);
+	this->mSparseDataset->setData (mSparseTrainingData);
+	this->emitOutputPropertiesChangedSignal ("dataset");
+	this->emitOutputPropertiesChangedSignal ("sparse dataset");
 	
-	// pointer where we are currently
-	mCurrentPoint = 0;
+	// start with a fresh epoch
+	updateEpochMode();
+}
+
+
+
+void cShark::SparseData::updateEpochMode()
+{
+	std::size_t numberOfElements = mSparse->getValue() ? mSparseTrainingData.numberOfElements() : mTrainingData.numberOfElements();
+	cShark::EpochMode::Id mode = mEpochMode->getValue().id();
+
+	// only stratification needs the labels, all other modes work on indices alone
+	std::vector<unsigned int> labels;
+	if (mode == cShark::EpochMode::Stratified) {
+		if (mSparse->getValue() == true) {
+			collectLabels (mSparseTrainingData, labels);
+		} else {
+			collectLabels (mTrainingData, labels);
+		}
+	}
+
+	mScheduler.reset (numberOfElements, mode, labels);
+
+	// the file, the representation, the stream or the shard may have changed (updateFilename ends here, too),
+	// so whoever keeps anything per index, like the kernel cache of KernelSGD, has to start over
+	++this->mDataGeneration->getData();
+
+	if (mSparse->getValue() == true) {
+		collectPositions (mSparseTrainingData, mElementPositions);
+	} else {
+		collectPositions (mTrainingData, mElementPositions);
+	}
+
+	if (mShardIndex->getValue() < mNumberOfShards->getValue()) {
+		mScheduler.setShard (mShardIndex->getValue(), mNumberOfShards->getValue());
+	} else {
+		cedar::aux::LogSingleton::getInstance()->warning ("Shard index must be smaller than the number of shards, using the whole data.", "cShark::SparseData::updateEpochMode()");
+	}
 }
 
 
 
 void cShark::SparseData::compute(const cedar::proc::Arguments& arguments)
 {
-  // TODO: something
-	RealVector dataPoint = mTrainingData.inputs().element (mCurrentPoint);
-	CedarRealVector dp (dataPoint);
-	this->mOutput = CedarRealVectorPtr (&dp);
-
-	mCurrentPoint++;
-	if (mCurrentPoint >= mTrainingData.numberOfElements()) {
-		mCurrentPoint = 0;
+	std::size_t batchSize = mBatchSize->getValue();
+	UIntVector& labels = this->mBatchLabels->getData();
+	std::size_t& index = this->mIndex->getData();
+	std::size_t rows = 0;
+
+	// each tick hands out a whole batch, the single point output carries its last point
+	if (mStreaming->getValue() == true) {
+		if (mSparse->getValue() == true) {
+			rows = nextBatch (mSparseStream, batchSize, this->mSparseOutput->getData(), index, this->mSparseBatchOutput->getData(), labels);
+		} else {
+			rows = nextBatch (mStream, batchSize, this->mOutput->getData(), index, this->mBatchOutput->getData(), labels);
+		}
+	} else {
+		if (mSparse->getValue() == true) {
+			rows = nextBatch (mSparseTrainingData, mScheduler, mElementPositions, batchSize, this->mSparseOutput->getData(), index, this->mSparseBatchOutput->getData(), labels);
+		} else {
+			rows = nextBatch (mTrainingData, mScheduler, mElementPositions, batchSize, this->mOutput->getData(), index, this->mBatchOutput->getData(), labels);
+		}
+	}
+
+	if (rows > 0) {
+		this->mLabel->setData (labels (rows - 1));
 	}
 }
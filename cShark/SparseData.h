@@ -43,14 +43,20 @@
 // CEDAR INCLUDES
 #include <cedar/processing/Step.h>
 
+#include <cedar/auxiliaries/BoolParameter.h>
+#include <cedar/auxiliaries/EnumParameter.h>
 #include <cedar/auxiliaries/FileParameter.h>
 #include <cedar/auxiliaries/MatData.h>
+#include <cedar/auxiliaries/UIntParameter.h>
 
 // CSHARK
 #include "cShark.h"
+#include "EpochMode.h"
 
 // SHARK THINGS
+#include "SharkSVM/EpochScheduler.h"
 #include "SharkSVM/SharkSparseData.h"
+#include "SharkSVM/SparseDataStream.h"
 
 // FORWARD DECLARATIONS
 #include "SparseData.fwd.h"
@@ -101,6 +107,8 @@ private:
 public slots: 
 	void updateFilename();
 
+	void updateEpochMode();
+
 	
   //--------------------------------------------------------------------------------------------------------------------
   // members
@@ -112,6 +120,33 @@ private:
   //!@brief The output data.
   CedarRealVectorPtr  mOutput;
 
+  //!@brief The output data, if sparse output is chosen.
+  CedarCompressedRealVectorPtr mSparseOutput;
+
+  //!@brief The label of the single point output.
+  CedarLabelPtr mLabel;
+
+  //!@brief The index of the single point output in the data, or its row in the file when streaming.
+  CedarIndexPtr mIndex;
+
+  //!@brief Changes whenever an index may name another point than before, e.g. after loading another file.
+  CedarIndexPtr mDataGeneration;
+
+  //!@brief The points handed out in one tick, as rows of a matrix.
+  CedarRealMatrixPtr mBatchOutput;
+
+  //!@brief The points handed out in one tick, if sparse output is chosen.
+  CedarCompressedRealMatrixPtr mSparseBatchOutput;
+
+  //!@brief The labels of the points in the batch.
+  CedarUIntVectorPtr mBatchLabels;
+
+  //!@brief The whole loaded data, for batch trainers; empty if the data is sparse or streamed.
+  CedarSVMDataPtr mDataset;
+
+  //!@brief The whole loaded data if sparse output is chosen, empty otherwise.
+  CedarSparseSVMDataPtr mSparseDataset;
+
   //--------------------------------------------------------------------------------------------------------------------
   // parameters
   //--------------------------------------------------------------------------------------------------------------------
@@ -122,14 +157,59 @@ private:
 	// data handler
 	SparseDataModel<RealVector> sparseDataHandler;
 
+	// data handler for sparse data
+	SparseDataModel<CompressedRealVector> sparseSparseDataHandler;
+
 	//!@brief determines the filename from which currently is read
 	cedar::aux::FileParameterPtr mFilename;
 
-	//!@brief where are we in the file?
-	size_t mCurrentPoint;
+	//!@brief keep the data sparse instead of expanding every point to a dense vector
+	cedar::aux::BoolParameterPtr mSparse;
+
+	//!@brief keep a binary cache next to the data file, so unchanged data is not parsed again
+	cedar::aux::BoolParameterPtr mBinaryCache;
+
+	//!@brief highest feature index, 0 detects it from the data (when streaming, the whole file is parsed once for this); zero-based files get one more dimension either way
+	cedar::aux::UIntParameterPtr mDimensions;
+
+	//!@brief read the file point by point instead of loading it, memory stays constant
+	cedar::aux::BoolParameterPtr mStreaming;
+
+	//!@brief number of points the stream reads ahead
+	cedar::aux::UIntParameterPtr mStreamWindow;
+
+	//!@brief start over at the end of a streamed file, or stop there
+	cedar::aux::BoolParameterPtr mWrapAround;
+
+	//!@brief number of points handed out per tick
+	cedar::aux::UIntParameterPtr mBatchSize;
+
+	//!@brief order in which the points of loaded data are visited, streams are always sequential
+	cedar::aux::EnumParameterPtr mEpochMode;
+
+	//!@brief which part of the data this step hands out in sharded mode
+	cedar::aux::UIntParameterPtr mShardIndex;
+
+	//!@brief into how many parts the data is split in sharded mode
+	cedar::aux::UIntParameterPtr mNumberOfShards;
+
+	//!@brief which point comes next, and in which order
+	EpochScheduler mScheduler;
+
+	//!@brief batch and row of every point of the loaded data, so a point is found without walking the batches
+	std::vector<std::pair<std::size_t, std::size_t> > mElementPositions;
 
 	// a learning machine has data
 	LabeledData<RealVector, unsigned int> mTrainingData;
+
+	// or sparse data, memory is then proportional to the non-zeros
+	LabeledData<CompressedRealVector, unsigned int> mSparseTrainingData;
+
+	// or no data at all, but a stream over the file
+	SparseDataStream<RealVector> mStream;
+
+	// or a stream of sparse points
+	SparseDataStream<CompressedRealVector> mSparseStream;
 	
 	// the data has some labeling order  we also need to consider
 	LabelOrder mLabelOrder;
@@ -44,16 +44,35 @@ using namespace shark;
 typedef cedar::aux::DataTemplate<shark::RealVector> CedarRealVector;
 CEDAR_GENERATE_POINTER_TYPES(CedarRealVector);
 
+typedef cedar::aux::DataTemplate<shark::CompressedRealVector> CedarCompressedRealVector;
+CEDAR_GENERATE_POINTER_TYPES(CedarCompressedRealVector);
+
 typedef shark::LabeledData<shark::RealVector, unsigned int> SharkSVMData;
 typedef cedar::aux::DataTemplate<SharkSVMData> CedarSVMData;
 CEDAR_GENERATE_POINTER_TYPES(CedarSVMData);
 
+typedef shark::LabeledData<shark::CompressedRealVector, unsigned int> SharkSparseSVMData;
+typedef cedar::aux::DataTemplate<SharkSparseSVMData> CedarSparseSVMData;
+CEDAR_GENERATE_POINTER_TYPES(CedarSparseSVMData);
+
 typedef cedar::aux::DataTemplate<shark::Data<shark::RealVector> > CedarDataRealVector;
 CEDAR_GENERATE_POINTER_TYPES(CedarDataRealVector);
 
 typedef cedar::aux::DataTemplate<shark::RealMatrix> CedarRealMatrix;
 CEDAR_GENERATE_POINTER_TYPES(CedarRealMatrix);
 
+typedef cedar::aux::DataTemplate<shark::CompressedRealMatrix> CedarCompressedRealMatrix;
+CEDAR_GENERATE_POINTER_TYPES(CedarCompressedRealMatrix);
+
+typedef cedar::aux::DataTemplate<shark::UIntVector> CedarUIntVector;
+CEDAR_GENERATE_POINTER_TYPES(CedarUIntVector);
+
+typedef cedar::aux::DataTemplate<unsigned int> CedarLabel;
+CEDAR_GENERATE_POINTER_TYPES(CedarLabel);
+
+typedef cedar::aux::DataTemplate<std::size_t> CedarIndex;
+CEDAR_GENERATE_POINTER_TYPES(CedarIndex);
+
 typedef cedar::aux::DataTemplate<LabelOrder> CedarLabelOrder;
 CEDAR_GENERATE_POINTER_TYPES(CedarLabelOrder);
 
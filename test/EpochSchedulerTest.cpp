@@ -0,0 +1,110 @@
+//===========================================================================
+/*!
+ *
+ *
+ * \brief       Tests of the epoch scheduler
+ *
+ *
+ *
+ * \author      Aydin Demircioglu
+ * \date        2015
+ *
+ *
+ * \par Copyright 1995-2015 Shark Development Team
+ *
+ * <BR><HR>
+ * This file is part of Shark.
+ * <http://image.diku.dk/shark/>
+ *
+ * Shark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Shark.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+//===========================================================================
+
+
+#define BOOST_TEST_MODULE Data_EpochScheduler
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <vector>
+
+#include "SharkSVM/EpochScheduler.h"
+
+using namespace shark;
+
+
+namespace {
+
+    std::vector<std::size_t> oneEpoch (EpochScheduler &scheduler) {
+        std::vector<std::size_t> indices;
+        for (std::size_t i = 0; i < scheduler.epochLength(); ++i)
+            indices.push_back (scheduler.next());
+        return indices;
+    }
+}
+
+
+
+BOOST_AUTO_TEST_SUITE (Data_EpochScheduler)
+
+
+BOOST_AUTO_TEST_CASE (EpochScheduler_Shards) {
+    EpochScheduler scheduler;
+    scheduler.reset (10, EpochModes::SHARDED);
+    scheduler.setShard (1, 3);
+    BOOST_REQUIRE_EQUAL (scheduler.epochLength(), 3u);
+
+    std::vector<std::size_t> indices = oneEpoch (scheduler);
+    std::size_t const expected[] = {1, 4, 7};
+    BOOST_CHECK_EQUAL_COLLECTIONS (indices.begin(), indices.end(), expected, expected + 3);
+
+    // the next epoch starts over at the shard
+    BOOST_CHECK_EQUAL (scheduler.next(), 1u);
+    BOOST_CHECK_EQUAL (scheduler.epoch(), 1u);
+}
+
+
+BOOST_AUTO_TEST_CASE (EpochScheduler_ResetDropsShard) {
+    // SparseData resets the scheduler and only sets a shard if the shard index is valid,
+    // so after a switch to an invalid shard the whole data must be visited again
+    EpochScheduler scheduler;
+    scheduler.reset (10, EpochModes::SHARDED);
+    scheduler.setShard (2, 4);
+    BOOST_REQUIRE_EQUAL (scheduler.epochLength(), 2u);
+
+    scheduler.reset (10, EpochModes::SHARDED);
+    BOOST_CHECK_THROW (scheduler.setShard (4, 4), SharkSVMException);
+    BOOST_REQUIRE_EQUAL (scheduler.epochLength(), 10u);
+
+    std::vector<std::size_t> indices = oneEpoch (scheduler);
+    for (std::size_t i = 0; i < indices.size(); ++i)
+        BOOST_CHECK_EQUAL (indices[i], i);
+}
+
+
+BOOST_AUTO_TEST_CASE (EpochScheduler_Permutation) {
+    EpochScheduler scheduler;
+    scheduler.setSeed (3);
+    scheduler.reset (50, EpochModes::PERMUTATION);
+
+    for (std::size_t e = 0; e < 3; ++e) {
+        std::vector<std::size_t> indices = oneEpoch (scheduler);
+        std::sort (indices.begin(), indices.end());
+        for (std::size_t i = 0; i < indices.size(); ++i)
+            BOOST_CHECK_EQUAL (indices[i], i);
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
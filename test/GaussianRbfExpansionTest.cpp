@@ -0,0 +1,144 @@
+//===========================================================================
+/*!
+ *
+ *
+ * \brief       Tests of the fast Gaussian RBF kernel expansion
+ *
+ *
+ *
+ * \author      Aydin Demircioglu
+ * \date        2015
+ *
+ *
+ * \par Copyright 1995-2015 Shark Development Team
+ *
+ * <BR><HR>
+ * This file is part of Shark.
+ * <http://image.diku.dk/shark/>
+ *
+ * Shark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Shark.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+//===========================================================================
+
+
+#define BOOST_TEST_MODULE Models_GaussianRbfExpansion
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/normal_distribution.hpp>
+
+#include "SharkSVM/GaussianRbfExpansion.h"
+
+using namespace shark;
+
+
+namespace {
+
+    /// \brief f(x) = sum_i alpha_i exp(-gamma |s_i - x|^2) + b, term by term.
+    RealVector naiveEval (double gamma, std::vector<RealVector> const &basis, RealMatrix const &alpha,
+                          RealVector const &offset, RealVector const &x) {
+        RealVector f (offset);
+        for (std::size_t i = 0; i < basis.size(); ++i) {
+            double distance = 0.0;
+            for (std::size_t j = 0; j < x.size(); ++j)
+                distance += (basis[i] (j) - x (j)) * (basis[i] (j) - x (j));
+            double k = std::exp (-gamma * distance);
+            for (std::size_t c = 0; c < f.size(); ++c)
+                f (c) += alpha (i, c) * k;
+        }
+        return f;
+    }
+
+
+    /// \brief Check single and batch evaluation against the naive sum.
+    ///
+    /// Sizes that are no multiples of the blocks (4 support vectors, 2 points,
+    /// 8 doubles of a row) exercise all the remainders.
+    ///
+    void checkAgainstNaive (std::size_t n, std::size_t d, std::size_t outputs, std::size_t points) {
+        boost::random::mt19937 rng (n * 1000 + d);
+        boost::random::normal_distribution<double> normal;
+
+        std::vector<RealVector> basis (n, RealVector (d));
+        for (std::size_t i = 0; i < n; ++i)
+            for (std::size_t j = 0; j < d; ++j)
+                basis[i] (j) = normal (rng);
+        RealMatrix alpha (n, outputs);
+        for (std::size_t i = 0; i < n; ++i)
+            for (std::size_t c = 0; c < outputs; ++c)
+                alpha (i, c) = normal (rng);
+        RealVector offset (outputs);
+        for (std::size_t c = 0; c < outputs; ++c)
+            offset (c) = normal (rng);
+        RealMatrix inputs (points, d);
+        for (std::size_t p = 0; p < points; ++p)
+            for (std::size_t j = 0; j < d; ++j)
+                inputs (p, j) = normal (rng);
+
+        double gamma = 0.5 / d;
+        GaussianRbfExpansion expansion;
+        expansion.setStructure (gamma, basis, alpha, offset);
+
+        RealMatrix batch;
+        expansion.eval (inputs, batch);
+        BOOST_REQUIRE_EQUAL (batch.size1(), points);
+        BOOST_REQUIRE_EQUAL (batch.size2(), outputs);
+
+        for (std::size_t p = 0; p < points; ++p) {
+            RealVector x (row (inputs, p));
+            RealVector expected = naiveEval (gamma, basis, alpha, offset, x);
+            RealVector single;
+            expansion.eval (x, single);
+            BOOST_REQUIRE_EQUAL (single.size(), outputs);
+
+            double scale = 1.0;
+            for (std::size_t i = 0; i < n; ++i)
+                scale += std::fabs (alpha (i, 0));
+            for (std::size_t c = 0; c < outputs; ++c) {
+                BOOST_CHECK_SMALL (single (c) - expected (c), 1e-11 * scale);
+                BOOST_CHECK_SMALL (batch (p, c) - expected (c), 1e-11 * scale);
+            }
+        }
+    }
+}
+
+
+
+BOOST_AUTO_TEST_SUITE (Models_GaussianRbfExpansion)
+
+
+BOOST_AUTO_TEST_CASE (GaussianRbfExpansion_SingleOutput) {
+    checkAgainstNaive (1, 1, 1, 1);
+    checkAgainstNaive (7, 13, 1, 5);
+    checkAgainstNaive (64, 784, 1, 9);
+}
+
+
+BOOST_AUTO_TEST_CASE (GaussianRbfExpansion_MultipleOutputs) {
+    checkAgainstNaive (5, 3, 3, 2);
+    checkAgainstNaive (33, 17, 3, 7);
+}
+
+
+BOOST_AUTO_TEST_CASE (GaussianRbfExpansion_EmptyBatch) {
+    checkAgainstNaive (6, 10, 2, 0);
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,247 @@
+//===========================================================================
+/*!
+ *
+ *
+ * \brief       Tests of the kernel cache handling of the online kernel SGD trainer
+ *
+ *
+ *
+ * \author      Aydin Demircioglu
+ * \date        2015
+ *
+ *
+ * \par Copyright 1995-2015 Shark Development Team
+ *
+ * <BR><HR>
+ * This file is part of Shark.
+ * <http://image.diku.dk/shark/>
+ *
+ * Shark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Shark.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+//===========================================================================
+
+
+#define BOOST_TEST_MODULE Algorithms_KernelSGDOnlineTrainer
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/normal_distribution.hpp>
+
+#include <shark/Models/Kernels/GaussianRbfKernel.h>
+#include <shark/ObjectiveFunctions/Loss/CrossEntropy.h>
+
+#include "SharkSVM/SharkKernelSGDOnlineTrainer.h"
+
+using namespace shark;
+
+
+namespace {
+
+    typedef KernelSGDOnlineTrainer<RealVector> Trainer;
+
+
+    struct Points {
+        std::vector<RealVector> inputs;
+        std::vector<unsigned int> labels;
+    };
+
+
+    /// \brief two Gaussian classes around -shift and +shift
+    Points randomPoints (std::size_t n, std::size_t d, double shift, unsigned int seed) {
+        boost::random::mt19937 rng (seed);
+        boost::random::normal_distribution<double> normal;
+
+        Points points;
+        for (std::size_t i = 0; i < n; ++i) {
+            unsigned int label = i % 2;
+            RealVector x (d);
+            for (std::size_t j = 0; j < d; ++j)
+                x (j) = normal (rng) + (label == 0 ? -shift : shift);
+            points.inputs.push_back (x);
+            points.labels.push_back (label);
+        }
+        return points;
+    }
+
+
+    /// \brief One epoch in order, the cached trainer gets the position of the point as its index.
+    void epoch (Trainer &cached, Trainer &uncached, Points const& points) {
+        for (std::size_t i = 0; i < points.inputs.size(); ++i) {
+            cached.oneStep (points.inputs[i], points.labels[i], i);
+            uncached.oneStep (points.inputs[i], points.labels[i]);
+        }
+    }
+
+
+    /// \brief The trainers must agree up to the float precision of the cache.
+    void checkSameModel (Trainer &cached, Trainer &uncached, Points const& points) {
+        BOOST_REQUIRE_EQUAL (cached.numberOfSupportVectors(), uncached.numberOfSupportVectors());
+        RealVector f;
+        RealVector g;
+        for (std::size_t i = 0; i < points.inputs.size(); ++i) {
+            cached.decisionFunction (points.inputs[i], f);
+            uncached.decisionFunction (points.inputs[i], g);
+            BOOST_CHECK_SMALL (f (0) - g (0), 1e-4 * (1.0 + std::fabs (g (0))));
+        }
+    }
+}
+
+
+
+BOOST_AUTO_TEST_SUITE (Algorithms_KernelSGDOnlineTrainer)
+
+
+BOOST_AUTO_TEST_CASE (KernelSGDOnlineTrainer_DataGeneration) {
+    // the same indices name other points in the second data set
+    Points first = randomPoints (40, 5, 1.0, 1);
+    Points second = randomPoints (40, 5, -0.5, 2);
+
+    GaussianRbfKernel<RealVector> kernel (0.2);
+    CrossEntropy loss;
+    Trainer cached (&kernel, &loss, 0.01, true, false, 1 << 20);
+    Trainer uncached (&kernel, &loss, 0.01, true, false, 0);
+
+    cached.setDataGeneration (1);
+    for (std::size_t e = 0; e < 3; ++e)
+        epoch (cached, uncached, first);
+    BOOST_CHECK_GT (cached.cache().hits(), 0u);
+    checkSameModel (cached, uncached, first);
+
+    cached.setDataGeneration (2);
+    BOOST_CHECK_EQUAL (cached.dataGeneration(), 2u);
+    for (std::size_t e = 0; e < 3; ++e)
+        epoch (cached, uncached, second);
+    checkSameModel (cached, uncached, second);
+}
+
+
+BOOST_AUTO_TEST_CASE (KernelSGDOnlineTrainer_ParameterVector) {
+    Points points = randomPoints (40, 5, 1.0, 3);
+
+    GaussianRbfKernel<RealVector> cachedKernel (0.2);
+    GaussianRbfKernel<RealVector> uncachedKernel (0.2);
+    CrossEntropy loss;
+    Trainer cached (&cachedKernel, &loss, 0.01, true, false, 1 << 20);
+    Trainer uncached (&uncachedKernel, &loss, 0.01, true, false, 0);
+
+    for (std::size_t e = 0; e < 2; ++e)
+        epoch (cached, uncached, points);
+
+    // a new bandwidth, the cached kernel values are of the old one
+    RealVector parameters (2);
+    parameters (0) = 2.0;
+    parameters (1) = 0.01;
+    cached.setParameterVector (parameters);
+    uncached.setParameterVector (parameters);
+    BOOST_CHECK_EQUAL (cachedKernel.gamma(), 2.0);
+
+    for (std::size_t e = 0; e < 2; ++e)
+        epoch (cached, uncached, points);
+    checkSameModel (cached, uncached, points);
+}
+
+
+BOOST_AUTO_TEST_CASE (KernelSGDOnlineTrainer_ParameterVectorLambda) {
+    Points points = randomPoints (40, 5, 1.0, 5);
+
+    GaussianRbfKernel<RealVector> cachedKernel (0.2);
+    GaussianRbfKernel<RealVector> uncachedKernel (0.2);
+    CrossEntropy loss;
+    Trainer cached (&cachedKernel, &loss, 0.01, true, false, 1 << 20);
+    Trainer uncached (&uncachedKernel, &loss, 0.01, true, false, 0);
+
+    for (std::size_t e = 0; e < 2; ++e)
+        epoch (cached, uncached, points);
+
+    // a new lambda through the parameter vector must rescale the model like setLambda
+    RealVector parameters (2);
+    parameters (0) = 0.2;
+    parameters (1) = 0.05;
+    cached.setParameterVector (parameters);
+    uncached.setLambda (0.05);
+    BOOST_CHECK_EQUAL (cached.Lambda(), 0.05);
+    checkSameModel (cached, uncached, points);
+
+    for (std::size_t e = 0; e < 2; ++e)
+        epoch (cached, uncached, points);
+    checkSameModel (cached, uncached, points);
+}
+
+
+BOOST_AUTO_TEST_CASE (KernelSGDOnlineTrainer_MiniBatchOfOne) {
+    // a batch of one point is a plain step, down to the last bit
+    Points points = randomPoints (40, 5, 1.0, 7);
+
+    GaussianRbfKernel<RealVector> kernel (0.2);
+    CrossEntropy loss;
+    Trainer single (&kernel, &loss, 0.01, true, false, 0);
+    Trainer batch (&kernel, &loss, 0.01, true, false, 0);
+
+    for (std::size_t e = 0; e < 2; ++e) {
+        for (std::size_t i = 0; i < points.inputs.size(); ++i) {
+            single.oneStep (points.inputs[i], points.labels[i]);
+            batch.miniBatchStep (std::vector<RealVector> (1, points.inputs[i]), std::vector<unsigned int> (1, points.labels[i]));
+        }
+    }
+
+    BOOST_REQUIRE_EQUAL (single.numberOfSupportVectors(), batch.numberOfSupportVectors());
+    BOOST_CHECK_EQUAL (single.iterations(), batch.iterations());
+    RealVector f;
+    RealVector g;
+    for (std::size_t i = 0; i < points.inputs.size(); ++i) {
+        single.decisionFunction (points.inputs[i], f);
+        batch.decisionFunction (points.inputs[i], g);
+        BOOST_CHECK_EQUAL (f (0), g (0));
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE (KernelSGDOnlineTrainer_ThreadsDoNotChangeResult) {
+    // the threads only evaluate the current model, the steps are taken in order
+    Points points = randomPoints (60, 5, 1.0, 9);
+
+    GaussianRbfKernel<RealVector> kernel (0.2);
+    CrossEntropy loss;
+    Trainer oneThread (&kernel, &loss, 0.01, true, false, 0);
+    Trainer fourThreads (&kernel, &loss, 0.01, true, false, 0);
+    oneThread.setNumberOfThreads (1);
+    fourThreads.setNumberOfThreads (4);
+
+    for (std::size_t e = 0; e < 3; ++e) {
+        for (std::size_t b = 0; b < points.inputs.size(); b += 8) {
+            std::size_t last = std::min<std::size_t> (b + 8, points.inputs.size());
+            std::vector<RealVector> batch (points.inputs.begin() + b, points.inputs.begin() + last);
+            std::vector<unsigned int> batchLabels (points.labels.begin() + b, points.labels.begin() + last);
+            oneThread.miniBatchStep (batch, batchLabels);
+            fourThreads.miniBatchStep (batch, batchLabels);
+        }
+    }
+
+    BOOST_REQUIRE_EQUAL (oneThread.numberOfSupportVectors(), fourThreads.numberOfSupportVectors());
+    RealVector f;
+    RealVector g;
+    for (std::size_t i = 0; i < points.inputs.size(); ++i) {
+        oneThread.decisionFunction (points.inputs[i], f);
+        fourThreads.decisionFunction (points.inputs[i], g);
+        BOOST_CHECK_EQUAL (f (0), g (0));
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,238 @@
+//===========================================================================
+/*!
+ *
+ *
+ * \brief       Tests of the linear SVM solver by dual coordinate descent
+ *
+ *
+ *
+ * \author      Aydin Demircioglu
+ * \date        2015
+ *
+ *
+ * \par Copyright 1995-2015 Shark Development Team
+ *
+ * <BR><HR>
+ * This file is part of Shark.
+ * <http://image.diku.dk/shark/>
+ *
+ * Shark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Shark.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+//===========================================================================
+
+
+#define BOOST_TEST_MODULE Algorithms_LinearDcdSolver
+#include <boost/test/unit_test.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "SharkSVM/LinearDcdSolver.h"
+#include "SharkSVM/SharkSparseData.h"
+
+using namespace shark;
+
+
+namespace {
+
+    /// \brief The optima on australian.sparse for C = 1 with the offset as a constant
+    /// feature 1, as LIBLINEAR -s 1 / -s 3 -c 1 -B 1 trains them. The last entry is the
+    /// offset, the labels are those of the file (+1 positive).
+    ///
+    /// \par
+    /// Both problems are strictly convex in w, so the optimum is unique. It was
+    /// computed independently of this solver: Newton's method on the primal for
+    /// the squared hinge loss (gradient below 1e-13), and cyclic coordinate
+    /// descent on the dual for the hinge loss (duality gap below 1e-11).
+    ///
+    double const SquaredHingeWeights[] = {
+        0.005949818573, 0.029042498673, -0.118500901745, 0.213929101048, 0.332965946706,
+        0.042692628763, 0.253423513677, 0.580649452992, 0.099111389444, 0.746448195167,
+        -0.031588256447, 0.158526912359, -0.550035320953, 1.093161090308, 1.383957811093
+    };
+    double const SquaredHingeObjective = 271.79232018471492;
+
+    double const HingeWeights[] = {
+        -0.002496445061, -0.004625345102, -0.008234792864, 0.014242549977, 0.016978023810,
+        0.008305162666, 0.015162970928, 1.005406009130, 0.003115563270, 0.026079738347,
+        -0.001027273726, 0.015416852543, -0.044384105568, 0.678500835868, 0.665617957271
+    };
+    double const HingeObjective = 200.04638807500828;
+
+
+    struct Australian {
+        Australian() {
+            SparseDataModel<CompressedRealVector> model;
+            LabelOrder labelOrder;
+            data = model.importData (std::string (CSHARK_TEST_DATA_DIR) + "/australian.sparse", labelOrder);
+
+            // the solver takes label 1 as the positive class, whichever label of the file that is
+            std::vector<int> order;
+            labelOrder.getLabelOrder (order);
+            BOOST_REQUIRE_EQUAL (order.size(), 2u);
+            sign = (order[1] == 1) ? 1.0 : -1.0;
+        }
+
+        /// \brief primal objective 1/2 |w|^2 + 1/2 b^2 + C sum_i loss_i with the offset as a feature
+        double objective (RealVector const& weights, double offset, unsigned int loss) const {
+            double value = 0.5 * (inner_prod (weights, weights) + offset * offset);
+            for (std::size_t i = 0; i < data.numberOfElements(); ++i) {
+                double y = (data.labels().element (i) == 1) ? 1.0 : -1.0;
+                double margin = std::max (0.0, 1.0 - y * (inner_prod (weights, RealVector (data.inputs().element (i))) + offset));
+                value += (loss == LossTypes::HINGE) ? margin : margin * margin;
+            }
+            return value;
+        }
+
+        LabeledData<CompressedRealVector, unsigned int> data;
+        double sign;
+    };
+
+
+    void checkOptimum (unsigned int loss, double const* expected, double expectedObjective) {
+        Australian australian;
+        BOOST_REQUIRE_EQUAL (inputDimension (australian.data), 14u);
+
+        // the hinge loss needs some 10^5 epochs for this tolerance
+        LinearDcdSolver solver (1.0, loss, true);
+        solver.setEpsilon (1e-8);
+        solver.setMaxEpochs (1000000);
+        RealVector weights;
+        double offset = 0.0;
+        BOOST_REQUIRE (solver.train (australian.data, weights, offset));
+        BOOST_REQUIRE_EQUAL (weights.size(), 14u);
+
+        for (std::size_t j = 0; j < 14; ++j)
+            BOOST_CHECK_SMALL (weights (j) - australian.sign * expected[j], 1e-5);
+        BOOST_CHECK_SMALL (offset - australian.sign * expected[14], 1e-5);
+        BOOST_CHECK_CLOSE (australian.objective (weights, offset, loss), expectedObjective, 1e-7);
+
+        // with the default tolerance of LIBLINEAR the objective is close, too
+        LinearDcdSolver coarse (1.0, loss, true);
+        BOOST_REQUIRE (coarse.train (australian.data, weights, offset));
+        BOOST_CHECK_CLOSE (australian.objective (weights, offset, loss), expectedObjective, 1.0);
+    }
+
+
+    bool sameBits (RealVector const& a, RealVector const& b) {
+        return (a.size() == b.size()) && (std::memcmp (&a (0), &b (0), a.size() * sizeof (double)) == 0);
+    }
+}
+
+
+
+BOOST_AUTO_TEST_SUITE (Algorithms_LinearDcdSolver)
+
+
+BOOST_AUTO_TEST_CASE (LinearDcdSolver_SquaredHinge) {
+    checkOptimum (LossTypes::SQUARED_HINGE, SquaredHingeWeights, SquaredHingeObjective);
+}
+
+
+BOOST_AUTO_TEST_CASE (LinearDcdSolver_Hinge) {
+    checkOptimum (LossTypes::HINGE, HingeWeights, HingeObjective);
+}
+
+
+BOOST_AUTO_TEST_CASE (LinearDcdSolver_Deterministic) {
+    Australian australian;
+
+    for (std::size_t threads = 1; threads <= 3; ++threads) {
+        BOOST_TEST_CHECKPOINT ("threads " << threads);
+        RealVector weights[2];
+        double offsets[2];
+        std::size_t epochs[2];
+        for (std::size_t run = 0; run < 2; ++run) {
+            LinearDcdSolver solver (1.0, LossTypes::HINGE, true);
+            solver.setNumberOfThreads (threads);
+            solver.setDeterministic (true);
+            solver.setSeed (42);
+            BOOST_REQUIRE (solver.train (australian.data, weights[run], offsets[run]));
+            epochs[run] = solver.iterations();
+        }
+
+        // same seed and number of threads, so the same result to the last bit
+        BOOST_CHECK (sameBits (weights[0], weights[1]));
+        BOOST_CHECK (std::memcmp (&offsets[0], &offsets[1], sizeof (double)) == 0);
+        BOOST_CHECK_EQUAL (epochs[0], epochs[1]);
+        BOOST_CHECK_CLOSE (australian.objective (weights[0], offsets[0], LossTypes::HINGE), HingeObjective, 1.0);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE (LinearDcdSolver_WarmStartOnlyOnSameData) {
+    Australian australian;
+    std::string path = std::string (CSHARK_TEST_DATA_DIR) + "/australian.sparse";
+
+    // the same file loaded again, also as dense points, and a file with as many points but one value changed
+    std::ifstream ifs (path.c_str());
+    std::ostringstream contents;
+    contents << ifs.rdbuf();
+    std::string text = contents.str();
+    std::string changedText = text;
+    changedText.replace (changedText.find ("2:-0.7494737"), 12, "2:-0.7494736");
+
+    SparseDataModel<CompressedRealVector> sparseModel;
+    SparseDataModel<RealVector> denseModel;
+    LabelOrder labelOrder;
+    std::istringstream same (text);
+    std::istringstream dense (text);
+    std::istringstream changed (changedText);
+    LabeledData<CompressedRealVector, unsigned int> const reloaded = sparseModel.importData (same, labelOrder);
+    LabeledData<RealVector, unsigned int> const reloadedDense = denseModel.importData (dense, labelOrder);
+    LabeledData<CompressedRealVector, unsigned int> const changedData = sparseModel.importData (changed, labelOrder);
+    BOOST_REQUIRE_EQUAL (changedData.numberOfElements(), australian.data.numberOfElements());
+
+    LinearDcdSolver solver (1.0, LossTypes::SQUARED_HINGE, true);
+    RealVector weights;
+    double offset = 0.0;
+    BOOST_REQUIRE (solver.train (australian.data, weights, offset));
+
+    BOOST_CHECK (solver.hasData (australian.data));
+    BOOST_CHECK (solver.hasData (reloaded));
+    BOOST_CHECK (solver.hasData (reloadedDense));
+    BOOST_CHECK (!solver.hasData (changedData));
+
+    // what LinearSVM does on a change of C: warm start only on the same data, else train from scratch
+    solver.setC (0.5);
+    if (solver.hasData (changedData))
+        BOOST_REQUIRE (solver.warmStart (weights, offset));
+    else
+        BOOST_REQUIRE (solver.train (changedData, weights, offset));
+
+    LinearDcdSolver cold (0.5, LossTypes::SQUARED_HINGE, true);
+    RealVector coldWeights;
+    double coldOffset = 0.0;
+    BOOST_REQUIRE (cold.train (changedData, coldWeights, coldOffset));
+    BOOST_CHECK (sameBits (weights, coldWeights));
+    BOOST_CHECK_EQUAL (offset, coldOffset);
+
+    // and on the same data the warm start ends at the same optimum as a cold start
+    BOOST_REQUIRE (solver.hasData (changedData));
+    solver.setC (0.25);
+    BOOST_REQUIRE (solver.warmStart (weights, offset));
+    LinearDcdSolver coldQuarter (0.25, LossTypes::SQUARED_HINGE, true);
+    coldQuarter.setEpsilon (1e-8);
+    BOOST_REQUIRE (coldQuarter.train (changedData, coldWeights, coldOffset));
+    for (std::size_t j = 0; j < coldWeights.size(); ++j)
+        BOOST_CHECK_SMALL (weights (j) - coldWeights (j), 1e-2);
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
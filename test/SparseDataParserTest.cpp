@@ -0,0 +1,254 @@
+//===========================================================================
+/*!
+ *
+ *
+ * \brief       Tests of the sparse data tokenizer
+ *
+ *
+ * \par
+ * The hand written tokenizer replaced a per line Spirit grammar, it has
+ * to accept exactly the same language and produce exactly the same
+ * points. The former grammar is kept here as reference.
+ *
+ *
+ *
+ * \author      Aydin Demircioglu
+ * \date        2015
+ *
+ *
+ * \par Copyright 1995-2015 Shark Development Team
+ *
+ * <BR><HR>
+ * This file is part of Shark.
+ * <http://image.diku.dk/shark/>
+ *
+ * Shark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Shark.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+//===========================================================================
+
+#define BOOST_TEST_MODULE Data_SparseDataParser
+#include <boost/test/unit_test.hpp>
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/fusion/adapted/std_pair.hpp>
+#include <boost/spirit/include/qi.hpp>
+
+#include "SharkSVM/SparseDataParser.h"
+
+using namespace shark;
+
+
+namespace {
+
+    typedef std::pair<int, std::vector<std::pair<std::size_t, double> > > LibSVMPoint;
+
+
+    /// \brief The former reader: one Spirit phrase_parse per line, empty lines are skipped.
+    ///
+    /// \return false if any line was rejected
+    ///
+    bool spiritParse (std::string const& text, SparseDataArena &arena) {
+        std::istringstream stream (text);
+
+        while (stream) {
+            std::string line;
+            std::getline (stream, line);
+
+            if (line.empty()) continue;
+
+            using namespace boost::spirit::qi;
+            std::string::const_iterator first = line.begin();
+            std::string::const_iterator last = line.end();
+
+            LibSVMPoint point;
+            bool r = phrase_parse (
+                         first, last,
+                         int_   >> - (lit ('.') >> +lit ('0'))
+                         >> * (uint_ >> ':' >> double_),
+                         space , point
+                     );
+
+            if (!r || first != last)
+                return false;
+
+            for (std::size_t i = 0; i < point.second.size(); ++i) {
+                arena.indices.push_back (static_cast<unsigned int> (point.second[i].first));
+                arena.values.push_back (point.second[i].second);
+            }
+            arena.labels.push_back (point.first);
+            arena.rowPointers.push_back (arena.indices.size());
+        }
+
+        return true;
+    }
+
+
+    /// \brief Parse the text with the tokenizer, handing it over in chunks of the given size
+    /// like the file reader does. A chunk size of 0 parses the whole text at once.
+    ///
+    /// \return false if the tokenizer threw
+    ///
+    bool tokenizerParse (std::string const& text, SparseDataArena &arena, std::size_t chunkSize = 0) {
+        // the tokenizer echoes the offending line, keep the test output clean
+        std::streambuf* coutBuffer = std::cout.rdbuf (NULL);
+        bool ok = true;
+
+        try {
+            if (chunkSize == 0) {
+                SparseDataParser::parse (text.data(), text.data() + text.size(), true, arena);
+            } else {
+                std::string pending;
+                for (std::size_t offset = 0; offset < text.size(); offset += chunkSize) {
+                    pending.append (text, offset, chunkSize);
+                    bool atEnd = (offset + chunkSize >= text.size());
+                    const char* rest = SparseDataParser::parse (pending.data(), pending.data() + pending.size(), atEnd, arena);
+                    pending.erase (0, rest - pending.data());
+                }
+            }
+        } catch (...) {
+            ok = false;
+        }
+
+        std::cout.rdbuf (coutBuffer);
+        return ok;
+    }
+
+
+    std::string readFile (std::string const& name) {
+        std::string path = std::string (CSHARK_TEST_DATA_DIR) + "/" + name;
+        std::ifstream ifs (path.c_str(), std::ios::binary);
+        BOOST_REQUIRE_MESSAGE (ifs.good(), "cannot open " << path);
+
+        std::ostringstream contents;
+        contents << ifs.rdbuf();
+        return contents.str();
+    }
+
+
+    void checkSameArena (SparseDataArena const& arena, SparseDataArena const& reference) {
+        BOOST_REQUIRE_EQUAL (arena.numberOfRows(), reference.numberOfRows());
+        BOOST_REQUIRE_EQUAL (arena.numberOfEntries(), reference.numberOfEntries());
+        BOOST_CHECK (arena.labels == reference.labels);
+        BOOST_CHECK (arena.rowPointers == reference.rowPointers);
+        BOOST_CHECK (arena.indices == reference.indices);
+        // both parsers must round the same way, so compare exactly
+        BOOST_CHECK (arena.values == reference.values);
+    }
+
+
+    /// \brief Parse the text with both parsers and check that they agree.
+    ///
+    /// \return whether the text was accepted
+    ///
+    bool checkSameAsSpirit (std::string const& text) {
+        SparseDataArena reference;
+        bool accepted = spiritParse (text, reference);
+
+        SparseDataArena arena;
+        BOOST_CHECK_EQUAL (tokenizerParse (text, arena), accepted);
+        if (accepted)
+            checkSameArena (arena, reference);
+
+        return accepted;
+    }
+}
+
+
+
+BOOST_AUTO_TEST_SUITE (Data_SparseDataParser)
+
+
+BOOST_AUTO_TEST_CASE (SparseDataParser_Australian) {
+    std::string text = readFile ("australian.sparse");
+
+    SparseDataArena reference;
+    BOOST_REQUIRE (spiritParse (text, reference));
+    BOOST_CHECK_EQUAL (reference.numberOfRows(), 690u);
+
+    SparseDataArena arena;
+    BOOST_REQUIRE (tokenizerParse (text, arena));
+    checkSameArena (arena, reference);
+
+    // the reader hands over arbitrary chunks, lines split between two
+    // chunks must be parsed once and completely
+    std::size_t const chunkSizes[] = {1, 7, 97, 4096};
+    for (std::size_t c = 0; c < sizeof (chunkSizes) / sizeof (chunkSizes[0]); ++c) {
+        SparseDataArena chunked;
+        BOOST_REQUIRE (tokenizerParse (text, chunked, chunkSizes[c]));
+        checkSameArena (chunked, reference);
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE (SparseDataParser_BlankLines) {
+    BOOST_CHECK (checkSameAsSpirit (readFile ("parser/blank_lines.sparse")));
+
+    // a line with only whitespace is not empty, so the grammar wants a label there
+    BOOST_CHECK (!checkSameAsSpirit (readFile ("parser/whitespace_line.sparse")));
+}
+
+
+BOOST_AUTO_TEST_CASE (SparseDataParser_TrailingWhitespace) {
+    // includes \r\n line endings and tabs
+    BOOST_CHECK (checkSameAsSpirit (readFile ("parser/trailing_whitespace.sparse")));
+}
+
+
+BOOST_AUTO_TEST_CASE (SparseDataParser_Qid) {
+    // qid is not part of the grammar
+    BOOST_CHECK (!checkSameAsSpirit (readFile ("parser/qid.sparse")));
+}
+
+
+BOOST_AUTO_TEST_CASE (SparseDataParser_LabelZeros) {
+    std::string text = readFile ("parser/label_zeros.sparse");
+    BOOST_REQUIRE (checkSameAsSpirit (text));
+
+    SparseDataArena arena;
+    BOOST_REQUIRE (tokenizerParse (text, arena));
+    BOOST_REQUIRE_EQUAL (arena.numberOfRows(), 5u);
+
+    int const labels[] = {1, -1, 1, 2, -1};
+    for (std::size_t i = 0; i < 5; ++i)
+        BOOST_CHECK_EQUAL (arena.labels[i], labels[i]);
+
+    // "1.01:0.5": the zeros after the '.' are eaten, so the line is label 1 with the pair 1:0.5
+    BOOST_CHECK_EQUAL (arena.rowPointers[3] - arena.rowPointers[2], 1u);
+    BOOST_CHECK_EQUAL (arena.indices[2], 1u);
+    BOOST_CHECK_EQUAL (arena.values[2], 0.5);
+}
+
+
+BOOST_AUTO_TEST_CASE (SparseDataParser_BadTokens) {
+    std::string text = readFile ("parser/bad_tokens.sparse");
+    BOOST_CHECK (!checkSameAsSpirit (text));
+
+    // every single line has to be rejected on its own, too
+    std::istringstream lines (text);
+    std::string line;
+    while (std::getline (lines, line)) {
+        BOOST_TEST_CHECKPOINT ("line " << line);
+        BOOST_CHECK_MESSAGE (!checkSameAsSpirit (line), "accepted: " << line);
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,178 @@
+//===========================================================================
+/*!
+ *
+ *
+ * \brief       Tests of the streaming reader for sparse data
+ *
+ *
+ *
+ * \author      Aydin Demircioglu
+ * \date        2015
+ *
+ *
+ * \par Copyright 1995-2015 Shark Development Team
+ *
+ * <BR><HR>
+ * This file is part of Shark.
+ * <http://image.diku.dk/shark/>
+ *
+ * Shark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Shark.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+//===========================================================================
+
+#define BOOST_TEST_MODULE Data_SparseDataStream
+#include <boost/test/unit_test.hpp>
+
+#include <iostream>
+#include <string>
+
+#include "SharkSVM/SharkSparseData.h"
+#include "SharkSVM/SparseDataStream.h"
+
+using namespace shark;
+
+
+namespace {
+
+    std::string dataFile (std::string const& name) {
+        return std::string (CSHARK_TEST_DATA_DIR) + "/" + name;
+    }
+
+
+    /// \brief next(), but with the echo of the parser on std::cout muted
+    /// \return 1 for a point, 0 for the end of the stream, -1 for an exception
+    ///
+    int quietNext (SparseDataStream<RealVector> &stream, RealVector &point, unsigned int &label, std::size_t &row) {
+        std::streambuf* coutBuffer = std::cout.rdbuf (NULL);
+        int result = -1;
+        try {
+            result = stream.next (point, label, row) ? 1 : 0;
+        } catch (SharkSVMException const&) {
+        }
+        std::cout.rdbuf (coutBuffer);
+        return result;
+    }
+}
+
+
+
+BOOST_AUTO_TEST_SUITE (Data_SparseDataStream)
+
+
+BOOST_AUTO_TEST_CASE (SparseDataStream_SameAsImport) {
+    std::string fn = dataFile ("australian.sparse");
+
+    SparseDataModel<RealVector> model;
+    LabelOrder labelOrder;
+    LabeledData<RealVector, unsigned int> const data = model.importData (fn, labelOrder);
+    std::size_t n = data.numberOfElements();
+
+    // a window smaller than the file, read it twice to wrap around once
+    SparseDataStream<RealVector> stream;
+    stream.open (fn, 7, true);
+    BOOST_REQUIRE_EQUAL (stream.dimensions(), inputDimension (data));
+
+    RealVector point;
+    unsigned int label = 0;
+    std::size_t row = 0;
+    for (std::size_t k = 0; k != 2 * n; ++k) {
+        BOOST_REQUIRE (stream.next (point, label, row));
+        BOOST_CHECK_EQUAL (row, k % n);
+        BOOST_CHECK_EQUAL (label, data.labels().element (k % n));
+
+        RealVector expected = data.inputs().element (k % n);
+        BOOST_REQUIRE_EQUAL (point.size(), expected.size());
+        for (std::size_t j = 0; j != point.size(); ++j)
+            BOOST_CHECK_EQUAL (point (j), expected (j));
+    }
+}
+
+
+BOOST_AUTO_TEST_CASE (SparseDataStream_DimensionErrorDropsRow) {
+    // the second row has index 5, beyond the three dimensions given
+    SparseDataStream<RealVector> stream;
+    stream.open (dataFile ("stream/dimension_error.sparse"), 2, false, 3);
+
+    RealVector point;
+    unsigned int label = 0;
+    std::size_t row = 0;
+    BOOST_CHECK_EQUAL (quietNext (stream, point, label, row), 1);
+    BOOST_CHECK_EQUAL (row, 0u);
+    BOOST_CHECK_EQUAL (quietNext (stream, point, label, row), -1);
+
+    // the broken row must not block the stream
+    BOOST_CHECK_EQUAL (quietNext (stream, point, label, row), 1);
+    BOOST_CHECK_EQUAL (row, 2u);
+    BOOST_CHECK_EQUAL (point (1), 1.0);
+    BOOST_CHECK_EQUAL (quietNext (stream, point, label, row), 1);
+    BOOST_CHECK_EQUAL (row, 3u);
+    BOOST_CHECK_EQUAL (quietNext (stream, point, label, row), 0);
+}
+
+
+BOOST_AUTO_TEST_CASE (SparseDataStream_ParseErrorReportedOnce) {
+    // the third line does not parse; wrapping around must not repeat the error forever
+    SparseDataStream<RealVector> stream;
+    stream.open (dataFile ("stream/parse_error.sparse"), 16, true, 3);
+
+    RealVector point;
+    unsigned int label = 0;
+    std::size_t row = 0;
+
+    // the rows before the broken line come first
+    BOOST_CHECK_EQUAL (quietNext (stream, point, label, row), 1);
+    BOOST_CHECK_EQUAL (row, 0u);
+    BOOST_CHECK_EQUAL (quietNext (stream, point, label, row), 1);
+    BOOST_CHECK_EQUAL (row, 1u);
+
+    BOOST_CHECK_EQUAL (quietNext (stream, point, label, row), -1);
+    BOOST_CHECK_EQUAL (quietNext (stream, point, label, row), 0);
+    BOOST_CHECK_EQUAL (quietNext (stream, point, label, row), 0);
+}
+
+
+BOOST_AUTO_TEST_CASE (SparseDataStream_ZeroBasedWithDimensions) {
+    // indices start at 0, with the dimensions given the stream must not drop these rows
+    std::string fn = dataFile ("stream/zero_based.sparse");
+    // auto-detected, exact, and more dimensions than used
+    unsigned int const dimensionsToTest[] = {0, 3, 4};
+    for (unsigned int dimensions : dimensionsToTest) {
+        SparseDataModel<RealVector> model;
+        LabelOrder labelOrder;
+        LabeledData<RealVector, unsigned int> const data = model.importData (fn, labelOrder, true, dimensions);
+
+        SparseDataStream<RealVector> stream;
+        stream.open (fn, 2, false, dimensions);
+        BOOST_REQUIRE_EQUAL (stream.dimensions(), inputDimension (data));
+
+        RealVector point;
+        unsigned int label = 0;
+        std::size_t row = 0;
+        for (std::size_t k = 0; k != data.numberOfElements(); ++k) {
+            BOOST_REQUIRE_EQUAL (quietNext (stream, point, label, row), 1);
+            BOOST_CHECK_EQUAL (row, k);
+            BOOST_CHECK_EQUAL (label, data.labels().element (k));
+
+            RealVector expected = data.inputs().element (k);
+            BOOST_REQUIRE_EQUAL (point.size(), expected.size());
+            for (std::size_t j = 0; j != point.size(); ++j)
+                BOOST_CHECK_EQUAL (point (j), expected (j));
+        }
+        BOOST_CHECK_EQUAL (quietNext (stream, point, label, row), 0);
+    }
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,189 @@
+//===========================================================================
+/*!
+ *
+ *
+ * \brief       Tests of the sparse data writer
+ *
+ *
+ *
+ * \author      Aydin Demircioglu
+ * \date        2015
+ *
+ *
+ * \par Copyright 1995-2015 Shark Development Team
+ *
+ * <BR><HR>
+ * This file is part of Shark.
+ * <http://image.diku.dk/shark/>
+ *
+ * Shark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Shark.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+//===========================================================================
+
+
+#define BOOST_TEST_MODULE Data_SparseDataWriter
+#include <boost/test/unit_test.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include <boost/cstdint.hpp>
+#include <boost/math/special_functions/fpclassify.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+
+#include "SharkSVM/SharkSparseData.h"
+#include "SharkSVM/SparseDataParser.h"
+#include "SharkSVM/SparseDataWriter.h"
+
+using namespace shark;
+
+
+namespace {
+
+    bool sameBits (double a, double b) {
+        return std::memcmp (&a, &b, sizeof (double)) == 0;
+    }
+
+
+    /// \brief Non-zero doubles of every kind: random bit patterns (all exponents,
+    /// subnormals included), short and long decimals, integers and the extremes.
+    std::vector<double> testValues (std::size_t n) {
+        boost::random::mt19937 rng (7);
+        boost::random::uniform_int_distribution<boost::uint64_t> bits;
+        boost::random::uniform_real_distribution<double> uniform (-1000.0, 1000.0);
+        boost::random::uniform_int_distribution<int> digits (0, 6);
+
+        std::vector<double> values;
+        values.push_back (1.0);
+        values.push_back (-1.0);
+        values.push_back (0.1);
+        values.push_back (1e-5);
+        values.push_back (9.999999999999999e14);
+        values.push_back (1e15);
+        values.push_back (4.9e-324);
+        values.push_back (2.2250738585072014e-308);
+        values.push_back (1.7976931348623157e308);
+        values.push_back (-0.75494737);
+
+        while (values.size() < n) {
+            switch (values.size() % 3) {
+                case 0: {
+                    boost::uint64_t pattern = bits (rng);
+                    double value;
+                    std::memcpy (&value, &pattern, sizeof (double));
+                    if (boost::math::isfinite (value) && (value != 0.0))
+                        values.push_back (value);
+                    break;
+                }
+                case 1: {
+                    // what data files usually hold: a few decimals
+                    // sparse lines skip zeros, so there must be none
+                    double scale = std::pow (10.0, digits (rng));
+                    double value = std::floor (uniform (rng) * scale) / scale;
+                    if (value != 0.0)
+                        values.push_back (value);
+                    break;
+                }
+                default:
+                    values.push_back (uniform (rng));
+            }
+        }
+        return values;
+    }
+
+
+    std::string readFile (std::string const& path) {
+        std::ifstream ifs (path.c_str(), std::ios::binary);
+        std::ostringstream contents;
+        contents << ifs.rdbuf();
+        return contents.str();
+    }
+}
+
+
+
+BOOST_AUTO_TEST_SUITE (Data_SparseDataWriter)
+
+
+BOOST_AUTO_TEST_CASE (SparseDataWriter_ValuesReadBack) {
+    std::vector<double> values = testValues (200000);
+
+    // one line per value, the index runs through 1..10
+    std::string text;
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        CompressedRealVector point (10);
+        point (i % 10) = values[i];
+        SparseDataWriter::formatLine (text, (i % 2 == 0) ? 1 : -1, point, false, 10);
+    }
+
+    SparseDataArena arena;
+    SparseDataParser::parse (text.data(), text.data() + text.size(), true, arena);
+    BOOST_REQUIRE_EQUAL (arena.numberOfRows(), values.size());
+    BOOST_REQUIRE_EQUAL (arena.numberOfEntries(), values.size());
+
+    std::size_t wrong = 0;
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        BOOST_CHECK_EQUAL (arena.indices[i], i % 10 + 1);
+        BOOST_CHECK_EQUAL (arena.labels[i], (i % 2 == 0) ? 1 : -1);
+        if (!sameBits (arena.values[i], values[i])) {
+            if (++wrong < 10)
+                BOOST_ERROR ("value " << values[i] << " reads back as " << arena.values[i]);
+        }
+    }
+    BOOST_CHECK_EQUAL (wrong, 0u);
+}
+
+
+BOOST_AUTO_TEST_CASE (SparseDataWriter_FileRoundTrip) {
+    // the australian data has 7 digit decimals, export and import must not change any of them
+    SparseDataModel<RealVector> model;
+    LabelOrder labelOrder;
+    LabeledData<RealVector, unsigned int> const data = model.importData (std::string (CSHARK_TEST_DATA_DIR) + "/australian.sparse", labelOrder);
+
+    // written to the working directory of the test
+    std::string first = "SparseDataWriterTest_first.sparse";
+    std::string second = "SparseDataWriterTest_second.sparse";
+    model.exportData (data, first);
+
+    LabelOrder readOrder;
+    LabeledData<RealVector, unsigned int> const read = model.importData (first, readOrder);
+    BOOST_REQUIRE_EQUAL (read.numberOfElements(), data.numberOfElements());
+    BOOST_REQUIRE_EQUAL (inputDimension (read), inputDimension (data));
+
+    for (std::size_t i = 0; i < data.numberOfElements(); ++i) {
+        BOOST_CHECK_EQUAL (read.labels().element (i), data.labels().element (i));
+        RealVector x = data.inputs().element (i);
+        RealVector y = read.inputs().element (i);
+        for (std::size_t j = 0; j < x.size(); ++j)
+            BOOST_CHECK (sameBits (x (j), y (j)));
+    }
+
+    // and the second export is the same file again
+    model.exportData (read, second);
+    BOOST_CHECK (readFile (first) == readFile (second));
+
+    std::remove (first.c_str());
+    std::remove (second.c_str());
+}
+
+
+BOOST_AUTO_TEST_SUITE_END()
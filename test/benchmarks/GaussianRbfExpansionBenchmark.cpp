@@ -0,0 +1,151 @@
+//===========================================================================
+/*!
+ *
+ *
+ * \brief       Benchmark of the evaluation of the Gaussian RBF kernel expansion
+ *
+ *
+ * \par
+ * Usage: GaussianRbfExpansionBenchmark [support vectors] [dimension] [points] [outputs]
+ *
+ * Compares the term by term sum, one GaussianRbfExpansion::eval per point and
+ * the batch evaluation of all points at once, on random data. Build with
+ * -mavx2 -mfma (or -mavx512f) to measure the vectorized code paths.
+ *
+ *
+ *
+ * \author      Aydin Demircioglu
+ * \date        2015
+ *
+ *
+ * \par Copyright 1995-2015 Shark Development Team
+ *
+ * <BR><HR>
+ * This file is part of Shark.
+ * <http://image.diku.dk/shark/>
+ *
+ * Shark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Shark.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+//===========================================================================
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <boost/chrono.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/normal_distribution.hpp>
+
+#include "SharkSVM/GaussianRbfExpansion.h"
+
+using namespace shark;
+
+
+namespace {
+
+    typedef boost::chrono::steady_clock Clock;
+
+
+    double seconds (Clock::time_point start) {
+        boost::chrono::duration<double> elapsed = Clock::now() - start;
+        return elapsed.count();
+    }
+
+
+    double maxDifference (RealMatrix const &a, RealMatrix const &b) {
+        double difference = 0.0;
+        for (std::size_t i = 0; i < a.size1(); ++i)
+            for (std::size_t j = 0; j < a.size2(); ++j)
+                difference = std::max (difference, std::fabs (a (i, j) - b (i, j)));
+        return difference;
+    }
+}
+
+
+
+int main (int argc, char** argv) {
+    std::size_t n = (argc > 1) ? std::atoi (argv[1]) : 2000;
+    std::size_t d = (argc > 2) ? std::atoi (argv[2]) : 784;
+    std::size_t points = (argc > 3) ? std::atoi (argv[3]) : 500;
+    std::size_t outputs = (argc > 4) ? std::atoi (argv[4]) : 1;
+    if (n == 0 || d == 0 || points == 0 || outputs == 0) {
+        std::fprintf (stderr, "Usage: %s [support vectors] [dimension] [points] [outputs]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    boost::random::mt19937 rng (42);
+    boost::random::normal_distribution<double> normal;
+
+    std::vector<RealVector> basis (n, RealVector (d));
+    for (std::size_t i = 0; i < n; ++i)
+        for (std::size_t j = 0; j < d; ++j)
+            basis[i] (j) = normal (rng);
+    RealMatrix alpha (n, outputs);
+    for (std::size_t i = 0; i < n; ++i)
+        for (std::size_t c = 0; c < outputs; ++c)
+            alpha (i, c) = normal (rng);
+    RealVector offset (outputs, 0.0);
+    RealMatrix inputs (points, d);
+    for (std::size_t p = 0; p < points; ++p)
+        for (std::size_t j = 0; j < d; ++j)
+            inputs (p, j) = normal (rng);
+
+    double gamma = 0.5 / d;
+    GaussianRbfExpansion expansion;
+    expansion.setStructure (gamma, basis, alpha, offset);
+
+    // term by term, as KernelExpansion does it
+    Clock::time_point start = Clock::now();
+    RealMatrix naive (points, outputs, 0.0);
+    for (std::size_t p = 0; p < points; ++p) {
+        for (std::size_t i = 0; i < n; ++i) {
+            double distance = 0.0;
+            for (std::size_t j = 0; j < d; ++j)
+                distance += (basis[i] (j) - inputs (p, j)) * (basis[i] (j) - inputs (p, j));
+            double k = std::exp (-gamma * distance);
+            for (std::size_t c = 0; c < outputs; ++c)
+                naive (p, c) += alpha (i, c) * k;
+        }
+    }
+    double naiveTime = seconds (start);
+
+    start = Clock::now();
+    RealMatrix single (points, outputs);
+    RealVector f;
+    for (std::size_t p = 0; p < points; ++p) {
+        RealVector x (row (inputs, p));
+        expansion.eval (x, f);
+        row (single, p) = f;
+    }
+    double singleTime = seconds (start);
+
+    start = Clock::now();
+    RealMatrix batch;
+    expansion.eval (inputs, batch);
+    double batchTime = seconds (start);
+
+    // the inner products dominate: 2 n d flops per point
+    double gflops = 2.0 * n * d * points * 1e-9;
+    std::printf ("%lu support vectors, dimension %lu, %lu points, %lu outputs\n",
+                 static_cast<unsigned long> (n), static_cast<unsigned long> (d),
+                 static_cast<unsigned long> (points), static_cast<unsigned long> (outputs));
+    std::printf ("naive:  %.4f s  %6.2f GFLOP/s\n", naiveTime, gflops / naiveTime);
+    std::printf ("single: %.4f s  %6.2f GFLOP/s  max difference %.2e\n", singleTime, gflops / singleTime, maxDifference (single, naive));
+    std::printf ("batch:  %.4f s  %6.2f GFLOP/s  max difference %.2e\n", batchTime, gflops / batchTime, maxDifference (batch, naive));
+
+    return EXIT_SUCCESS;
+}
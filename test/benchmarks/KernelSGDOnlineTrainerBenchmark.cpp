@@ -0,0 +1,162 @@
+//===========================================================================
+/*!
+ *
+ *
+ * \brief       Benchmark of the online kernel SGD trainer, single steps against train()
+ *
+ *
+ * \par
+ * Usage: KernelSGDOnlineTrainerBenchmark [data file] [epochs] [gamma]
+ *
+ * Times the same epochs as single oneStep calls, without and with the index
+ * for the kernel cache, and as one call of train(). Without a data file the
+ * australian data of the tests is used.
+ *
+ *
+ *
+ * \author      Aydin Demircioglu
+ * \date        2015
+ *
+ *
+ * \par Copyright 1995-2015 Shark Development Team
+ *
+ * <BR><HR>
+ * This file is part of Shark.
+ * <http://image.diku.dk/shark/>
+ *
+ * Shark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Shark.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+//===========================================================================
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/chrono.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+
+#include <shark/Models/Kernels/GaussianRbfKernel.h>
+#include <shark/ObjectiveFunctions/Loss/HingeLoss.h>
+
+#include "SharkSVM/SharkKernelSGDOnlineTrainer.h"
+#include "SharkSVM/SharkSparseData.h"
+
+using namespace shark;
+
+
+namespace {
+
+    typedef boost::chrono::steady_clock Clock;
+    typedef KernelSGDOnlineTrainer<RealVector> Trainer;
+
+
+    double seconds (Clock::time_point start) {
+        boost::chrono::duration<double> elapsed = Clock::now() - start;
+        return elapsed.count();
+    }
+
+
+    /// \brief The same random orders for every run, one per epoch.
+    std::vector<std::size_t> randomOrder (std::size_t ell, std::size_t epochs) {
+        boost::random::mt19937 rng (42);
+        std::vector<std::size_t> order;
+        for (std::size_t e = 0; e < epochs; ++e) {
+            std::vector<std::size_t> epoch (ell);
+            for (std::size_t i = 0; i < ell; ++i)
+                epoch[i] = i;
+            for (std::size_t i = ell - 1; i > 0; --i) {
+                boost::random::uniform_int_distribution<std::size_t> pick (0, i);
+                std::swap (epoch[i], epoch[pick (rng)]);
+            }
+            order.insert (order.end(), epoch.begin(), epoch.end());
+        }
+        return order;
+    }
+
+
+    /// \brief Time of one oneStep call per entry of the order, with or without the index for the kernel cache.
+    double timeOneStep (Trainer &trainer, std::vector<RealVector> const& points, std::vector<unsigned int> const& labels,
+                        std::vector<std::size_t> const& order, bool indexed) {
+        Clock::time_point start = Clock::now();
+        for (std::size_t k = 0; k < order.size(); ++k) {
+            std::size_t i = order[k];
+            trainer.oneStep (points[i], labels[i], indexed ? i : Trainer::NoIndex);
+        }
+        return seconds (start);
+    }
+}
+
+
+
+int main (int argc, char** argv) {
+    std::string fn = (argc > 1) ? argv[1] : std::string (CSHARK_TEST_DATA_DIR) + "/australian.sparse";
+    std::size_t epochs = (argc > 2) ? std::atoi (argv[2]) : 10;
+    double gamma = (argc > 3) ? std::atof (argv[3]) : 0.1;
+    if (epochs == 0 || gamma <= 0.0) {
+        std::fprintf (stderr, "Usage: %s [data file] [epochs] [gamma]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    SparseDataModel<RealVector> model;
+    LabelOrder labelOrder;
+    LabeledData<RealVector, unsigned int> const data = model.importData (fn, labelOrder);
+    std::size_t ell = data.numberOfElements();
+
+    std::vector<RealVector> points;
+    std::vector<unsigned int> labels;
+    for (std::size_t i = 0; i < ell; ++i) {
+        points.push_back (data.inputs().element (i));
+        labels.push_back (data.labels().element (i));
+    }
+    std::vector<std::size_t> order = randomOrder (ell, epochs);
+
+    // C = 1 of the equivalent C-SVM
+    double lambda = 1.0 / ell;
+    GaussianRbfKernel<RealVector> kernel (gamma);
+    HingeLoss loss;
+
+    // the streaming use: every point is new to the trainer, no cache
+    Trainer streaming (&kernel, &loss, lambda, true, false, 0);
+    double streamingTime = timeOneStep (streaming, points, labels, order, false);
+
+    // the same steps, the index lets the trainer cache the kernel rows
+    Trainer cached (&kernel, &loss, lambda, true);
+    double cachedTime = timeOneStep (cached, points, labels, order, true);
+
+    // train() draws its own orders and takes the rows out of the dataset itself
+    Trainer batch (&kernel, &loss, lambda, true);
+    batch.setEpochs (epochs);
+    batch.setSeed (42);
+    KernelClassifier<RealVector> classifier;
+    Clock::time_point start = Clock::now();
+    batch.train (classifier, data);
+    double trainTime = seconds (start);
+
+    double steps = static_cast<double> (order.size());
+    std::printf ("input: %s, %lu points, dimension %lu, %lu epochs, gamma %g\n",
+                 fn.c_str(), static_cast<unsigned long> (ell), static_cast<unsigned long> (inputDimension (data)),
+                 static_cast<unsigned long> (epochs), gamma);
+    std::printf ("oneStep, no index: %.4f s  %8.2f us/step  %lu support vectors\n",
+                 streamingTime, 1e6 * streamingTime / steps, static_cast<unsigned long> (streaming.numberOfSupportVectors()));
+    std::printf ("oneStep, indexed:  %.4f s  %8.2f us/step  %lu support vectors  cache hit rate %.2f\n",
+                 cachedTime, 1e6 * cachedTime / steps, static_cast<unsigned long> (cached.numberOfSupportVectors()), cached.cache().hitRate());
+    std::printf ("train():           %.4f s  %8.2f us/step  %lu support vectors\n",
+                 trainTime, 1e6 * trainTime / steps, static_cast<unsigned long> (batch.numberOfSupportVectors()));
+
+    return EXIT_SUCCESS;
+}
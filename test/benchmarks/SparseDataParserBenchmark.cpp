@@ -0,0 +1,173 @@
+//===========================================================================
+/*!
+ *
+ *
+ * \brief       Benchmark of the sparse data tokenizer against the former Spirit grammar
+ *
+ *
+ * \par
+ * Usage: SparseDataParserBenchmark [file] [repetitions]
+ *
+ * Without a file a synthetic data set (20000 points with 50 nonzeros
+ * each) is generated. The text is held in memory, so only the parsing
+ * is measured, not the disk.
+ *
+ *
+ *
+ * \author      Aydin Demircioglu
+ * \date        2015
+ *
+ *
+ * \par Copyright 1995-2015 Shark Development Team
+ *
+ * <BR><HR>
+ * This file is part of Shark.
+ * <http://image.diku.dk/shark/>
+ *
+ * Shark is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published
+ * by the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Shark is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with Shark.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ */
+//===========================================================================
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <boost/chrono.hpp>
+#include <boost/fusion/adapted/std_pair.hpp>
+#include <boost/random/mersenne_twister.hpp>
+#include <boost/random/uniform_int_distribution.hpp>
+#include <boost/random/uniform_real_distribution.hpp>
+#include <boost/spirit/include/qi.hpp>
+
+#include "SharkSVM/SparseDataParser.h"
+
+using namespace shark;
+
+
+namespace {
+
+    typedef std::pair<int, std::vector<std::pair<std::size_t, double> > > LibSVMPoint;
+
+
+    std::size_t spiritParse (std::string const& text) {
+        std::istringstream stream (text);
+        std::vector<LibSVMPoint> fileContents;
+
+        while (stream) {
+            std::string line;
+            std::getline (stream, line);
+
+            if (line.empty()) continue;
+
+            using namespace boost::spirit::qi;
+            std::string::const_iterator first = line.begin();
+            std::string::const_iterator last = line.end();
+
+            LibSVMPoint newPoint;
+            bool r = phrase_parse (
+                         first, last,
+                         int_   >> - (lit ('.') >> +lit ('0'))
+                         >> * (uint_ >> ':' >> double_),
+                         space , newPoint
+                     );
+
+            if (!r || first != last) {
+                std::fprintf (stderr, "Spirit rejected the input\n");
+                std::exit (EXIT_FAILURE);
+            }
+
+            fileContents.push_back (newPoint);
+        }
+
+        return fileContents.size();
+    }
+
+
+    std::size_t tokenizerParse (std::string const& text) {
+        SparseDataArena arena;
+        SparseDataParser::parse (text.data(), text.data() + text.size(), true, arena);
+        return arena.numberOfRows();
+    }
+
+
+    std::string syntheticData (std::size_t points, std::size_t nonzeros) {
+        boost::random::mt19937 rng (42);
+        boost::random::uniform_int_distribution<unsigned int> gap (1, 8);
+        boost::random::uniform_real_distribution<double> value (-1.0, 1.0);
+
+        std::ostringstream text;
+        text.precision (17);
+        for (std::size_t i = 0; i < points; ++i) {
+            text << ((i % 2 == 0) ? "+1" : "-1");
+            unsigned int index = 0;
+            for (std::size_t j = 0; j < nonzeros; ++j) {
+                index += gap (rng);
+                text << ' ' << index << ':' << value (rng);
+            }
+            text << '\n';
+        }
+        return text.str();
+    }
+
+
+    /// \brief Average wall clock time of one parse in seconds.
+    template <typename Parse>
+    double timeParse (Parse parse, std::string const& text, unsigned int repetitions, std::size_t &points) {
+        boost::chrono::steady_clock::time_point start = boost::chrono::steady_clock::now();
+        for (unsigned int r = 0; r < repetitions; ++r)
+            points = parse (text);
+        boost::chrono::duration<double> elapsed = boost::chrono::steady_clock::now() - start;
+        return elapsed.count() / repetitions;
+    }
+}
+
+
+
+int main (int argc, char** argv) {
+    std::string text;
+    if (argc > 1) {
+        std::ifstream ifs (argv[1], std::ios::binary);
+        if (!ifs.good()) {
+            std::fprintf (stderr, "Cannot open %s\n", argv[1]);
+            return EXIT_FAILURE;
+        }
+        std::ostringstream contents;
+        contents << ifs.rdbuf();
+        text = contents.str();
+    } else {
+        text = syntheticData (20000, 50);
+    }
+
+    unsigned int repetitions = (argc > 2) ? std::atoi (argv[2]) : 5;
+    if (repetitions == 0)
+        repetitions = 1;
+
+    double megabytes = text.size() / (1024.0 * 1024.0);
+    std::size_t spiritPoints = 0;
+    std::size_t tokenizerPoints = 0;
+    double spiritTime = timeParse (spiritParse, text, repetitions, spiritPoints);
+    double tokenizerTime = timeParse (tokenizerParse, text, repetitions, tokenizerPoints);
+
+    std::printf ("input: %s, %.2f MB, %lu points, %u repetitions\n",
+                 (argc > 1) ? argv[1] : "synthetic", megabytes, static_cast<unsigned long> (tokenizerPoints), repetitions);
+    std::printf ("spirit:    %.4f s  %8.2f MB/s\n", spiritTime, megabytes / spiritTime);
+    std::printf ("tokenizer: %.4f s  %8.2f MB/s  (%.1fx)\n", tokenizerTime, megabytes / tokenizerTime, spiritTime / tokenizerTime);
+
+    return (spiritPoints == tokenizerPoints) ? EXIT_SUCCESS : EXIT_FAILURE;
+}